@@ -0,0 +1,149 @@
+#pragma once
+//Locale free scanning and number parsing for ASCII point clouds.
+//Everything is inline so the parse loop in the loaders compiles into a single tight function.
+
+//C++
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCV_ASCII_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+#if defined(PCV_ASCII_SSE2)
+inline unsigned int lowestSetBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+//Returns a pointer to the first '\n' in [first, last) or last if there is none. Scans 16 bytes per step.
+inline const char* findNewline(const char* first, const char* last)
+{
+#if defined(PCV_ASCII_SSE2)
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (last - first >= 16)
+	{
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+		if (mask != 0)
+			return first + lowestSetBit(mask);
+		first += 16;
+	}
+#endif
+	const void* found = std::memchr(first, '\n', static_cast<std::size_t>(last - first));
+	return found ? static_cast<const char*>(found) : last;
+}
+
+//Counts the '\n' bytes in [first, last). Byte-wise compare results are summed in 8-bit lanes
+//and widened with _mm_sad_epu8 before they can overflow.
+inline std::size_t countNewlines(const char* first, const char* last)
+{
+	std::size_t count = 0;
+#if defined(PCV_ASCII_SSE2)
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (last - first >= 16)
+	{
+		__m128i laneCounts = _mm_setzero_si128();
+		for (int i = 0; i < 255 && last - first >= 16; ++i)
+		{
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+			laneCounts = _mm_sub_epi8(laneCounts, _mm_cmpeq_epi8(bytes, newline));
+			first += 16;
+		}
+		__m128i sums = _mm_sad_epu8(laneCounts, _mm_setzero_si128());
+		count += static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) + static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+	}
+#endif
+	for (; first < last; ++first)
+		count += (*first == '\n');
+	return count;
+}
+
+//Upper bound on the records in text: every line, including a final one without '\n'.
+inline std::size_t countLinesASC(const char* first, const char* last)
+{
+	if (first == last)
+		return 0;
+	return countNewlines(first, last) + (last[-1] != '\n' ? 1 : 0);
+}
+
+inline const char* skipBlanks(const char* first, const char* last)
+{
+	while (first < last && isBlank(*first))
+		++first;
+	return first;
+}
+
+//Parses a float at cursor and advances past it. Matches strtof/std::istream rounding exactly.
+//Scanners write short fixed-decimal values such as "-12.3456", those are converted with a single
+//correctly rounded division because both the digits (< 2^24) and the power of ten (<= 10^10) are exact floats.
+//Anything else (exponents, long mantissas, inf/nan) falls back to std::from_chars.
+inline bool parseFloatASC(const char*& cursor, const char* last, float& value)
+{
+	static constexpr float powersOfTen[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+	const char* first = cursor;
+	if (first < last && *first == '+') //from_chars doesn't accept a leading '+', istream does
+		++first;
+	const char* p = first;
+	bool negative = false;
+	if (p < last && *p == '-')
+	{
+		negative = true;
+		++p;
+	}
+
+	std::uint64_t mantissa = 0;
+	int nDigits = 0;
+	int nFractionDigits = 0;
+	while (p < last && static_cast<unsigned char>(*p - '0') < 10 && nDigits < 19)
+	{
+		mantissa = mantissa * 10 + static_cast<unsigned char>(*p - '0');
+		++nDigits;
+		++p;
+	}
+	if (p < last && *p == '.')
+	{
+		++p;
+		while (p < last && static_cast<unsigned char>(*p - '0') < 10 && nDigits < 19)
+		{
+			mantissa = mantissa * 10 + static_cast<unsigned char>(*p - '0');
+			++nDigits;
+			++nFractionDigits;
+			++p;
+		}
+	}
+
+	bool endOfToken = (p == last) || isBlank(*p) || *p == '\n' || *p == ',' || *p == ';';
+	if (nDigits > 0 && endOfToken && mantissa <= (1u << 24) && nFractionDigits <= 10)
+	{
+		float result = static_cast<float>(mantissa) / powersOfTen[nFractionDigits];
+		value = negative ? -result : result;
+		cursor = p;
+		return true;
+	}
+
+	std::from_chars_result result = std::from_chars(first, last, value);
+	if (result.ec != std::errc())
+		return false;
+	cursor = result.ptr;
+	return true;
+}
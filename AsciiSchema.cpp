@@ -0,0 +1,392 @@
+#include "AsciiSchema.h"
+#include "AsciiParser.h"
+#include "OctahedralNormal.h"
+//C++
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <string>
+
+namespace
+{
+    constexpr std::size_t maxDetectionLines = 16;
+
+    //Moves p onto the next column. The first column only skips leading blanks.
+    template<char delimiter>
+    inline bool advanceToColumn(const char*& p, const char* last, bool firstColumn)
+    {
+        p = skipBlanks(p, last);
+        if (delimiter == ' ' || firstColumn)
+            return true;
+        if (p == last || *p != delimiter)
+            return false;
+        p = skipBlanks(p + 1, last);
+        return true;
+    }
+
+    inline float colourDivisor(const AsciiSchema& schema)
+    {
+        return schema.colourType == ColourType::UInt8 ? 255.0f : 1.0f;
+    }
+
+    //Fixed layout: positions in columns 0-2, optional colour in three columns from redColumn and optional normal in
+    //three columns from normalColumn, every column numeric.
+    //Compiled per layout so the column loop unrolls and the delimiter test folds away.
+    template<int nColumns, int redColumn, int normalColumn, char delimiter>
+    std::size_t parseFixedColumnsBlock(std::string_view block, PointCloudVertex* destination, std::uint32_t* normals,
+        const AsciiSchema& schema, BoundsAccumulator& bounds)
+    {
+        const float divisor = colourDivisor(schema);
+        const char* cursor = block.data();
+        const char* last = block.data() + block.size();
+        PointCloudVertex* out = destination;
+        OctahedralNormalWriter normalWriter(normals);
+
+        while (cursor < last) {
+            const char* endOfLine = findNewline(cursor, last);
+            const char* p = cursor;
+            float values[nColumns];
+            bool valid = true;
+            for (int column = 0; column < nColumns && valid; ++column)
+                valid = advanceToColumn<delimiter>(p, endOfLine, column == 0) && parseFloatASC(p, endOfLine, values[column]);
+
+            if (valid) {
+                DirectX::XMFLOAT3 colour(1.0f, 1.0f, 1.0f);
+                if constexpr (redColumn >= 0)
+                    colour = DirectX::XMFLOAT3(values[redColumn] / divisor, values[redColumn + 1] / divisor, values[redColumn + 2] / divisor);
+                *out = PointCloudVertex(DirectX::XMFLOAT3(values[0], values[1], values[2]), colour);
+                bounds.add(*out++);
+                if constexpr (normalColumn >= 0)
+                    normalWriter.push(DirectX::XMFLOAT3(values[normalColumn], values[normalColumn + 1], values[normalColumn + 2]));
+            }
+            cursor = endOfLine + 1;
+        }
+        if constexpr (normalColumn >= 0)
+            normalWriter.flush();
+        return static_cast<std::size_t>(out - destination);
+    }
+
+    //Any other layout, driven by the role list at run time. Skipped columns don't have to be numeric.
+    template<char delimiter>
+    std::size_t parseGenericColumnsBlock(std::string_view block, PointCloudVertex* destination, std::uint32_t* normals,
+        const AsciiSchema& schema, BoundsAccumulator& bounds)
+    {
+        const float divisor = colourDivisor(schema);
+        const bool keepNormals = hasNormals(schema);
+        const char* cursor = block.data();
+        const char* last = block.data() + block.size();
+        PointCloudVertex* out = destination;
+        OctahedralNormalWriter normalWriter(normals);
+
+        while (cursor < last) {
+            const char* endOfLine = findNewline(cursor, last);
+            const char* p = cursor;
+            float position[3] = {};
+            float colour[3] = { divisor, divisor, divisor };
+            float normal[3] = {};
+            bool valid = true;
+            for (std::size_t column = 0; column < schema.columns.size() && valid; ++column)
+            {
+                valid = advanceToColumn<delimiter>(p, endOfLine, column == 0);
+                if (!valid)
+                    break;
+                float value;
+                switch (schema.columns[column])
+                {
+                case ColumnRole::X: valid = parseFloatASC(p, endOfLine, position[0]); break;
+                case ColumnRole::Y: valid = parseFloatASC(p, endOfLine, position[1]); break;
+                case ColumnRole::Z: valid = parseFloatASC(p, endOfLine, position[2]); break;
+                case ColumnRole::Red: valid = parseFloatASC(p, endOfLine, colour[0]); break;
+                case ColumnRole::Green: valid = parseFloatASC(p, endOfLine, colour[1]); break;
+                case ColumnRole::Blue: valid = parseFloatASC(p, endOfLine, colour[2]); break;
+                case ColumnRole::NormalX: valid = parseFloatASC(p, endOfLine, normal[0]); break;
+                case ColumnRole::NormalY: valid = parseFloatASC(p, endOfLine, normal[1]); break;
+                case ColumnRole::NormalZ: valid = parseFloatASC(p, endOfLine, normal[2]); break;
+                case ColumnRole::Intensity:
+                    valid = parseFloatASC(p, endOfLine, value);
+                    break;
+                default:
+                    //Free text such as a name can hold blanks, so only a blank delimiter ends a column at one.
+                    //Quoted fields may also hold the delimiter.
+                    if constexpr (delimiter == ' ')
+                    {
+                        while (p < endOfLine && !isBlank(*p))
+                            ++p;
+                    }
+                    else
+                    {
+                        bool quoted = false;
+                        while (p < endOfLine && (quoted || *p != delimiter))
+                            quoted ^= *p++ == '"';
+                    }
+                    break;
+                }
+            }
+
+            if (valid)
+            {
+                *out = PointCloudVertex(DirectX::XMFLOAT3(position[0], position[1], position[2]),
+                    DirectX::XMFLOAT3(colour[0] / divisor, colour[1] / divisor, colour[2] / divisor));
+                bounds.add(*out++);
+                if (keepNormals)
+                    normalWriter.push(DirectX::XMFLOAT3(normal[0], normal[1], normal[2]));
+            }
+            cursor = endOfLine + 1;
+        }
+        if (keepNormals)
+            normalWriter.flush();
+        return static_cast<std::size_t>(out - destination);
+    }
+
+    template<char delimiter>
+    AsciiBlockParser selectParserForDelimiter(const AsciiSchema& schema)
+    {
+        using R = ColumnRole;
+        const std::vector<ColumnRole>& columns = schema.columns;
+        auto isNumericSkip = [](R role) { return role == R::Intensity || role == R::NormalX || role == R::NormalY || role == R::NormalZ; };
+        auto matches = [&](std::initializer_list<R> layout) {
+            return columns.size() == layout.size() && std::equal(layout.begin(), layout.end(), columns.begin(),
+                [&](R expected, R actual) { return expected == actual || (expected == R::Intensity && isNumericSkip(actual)); });
+        };
+
+        //Normal columns only count as skipped when there aren't all three of them
+        if (hasNormals(schema))
+        {
+            if (matches({ R::X, R::Y, R::Z, R::Red, R::Green, R::Blue, R::NormalX, R::NormalY, R::NormalZ }))
+                return parseFixedColumnsBlock<9, 3, 6, delimiter>;
+            return parseGenericColumnsBlock<delimiter>;
+        }
+        if (matches({ R::X, R::Y, R::Z }))
+            return parseFixedColumnsBlock<3, -1, -1, delimiter>;
+        if (matches({ R::X, R::Y, R::Z, R::Intensity }))
+            return parseFixedColumnsBlock<4, -1, -1, delimiter>;
+        if (matches({ R::X, R::Y, R::Z, R::Red, R::Green, R::Blue }))
+            return parseFixedColumnsBlock<6, 3, -1, delimiter>;
+        if (matches({ R::X, R::Y, R::Z, R::Intensity, R::Red, R::Green, R::Blue }))
+            return parseFixedColumnsBlock<7, 4, -1, delimiter>;
+        if (matches({ R::X, R::Y, R::Z, R::Red, R::Green, R::Blue, R::Intensity, R::Intensity, R::Intensity }))
+            return parseFixedColumnsBlock<9, 3, -1, delimiter>;
+        return parseGenericColumnsBlock<delimiter>;
+    }
+
+    std::string_view trimBlanks(std::string_view text)
+    {
+        while (!text.empty() && (isBlank(text.front()) || text.front() == '\n'))
+            text.remove_prefix(1);
+        while (!text.empty() && (isBlank(text.back()) || text.back() == '\n'))
+            text.remove_suffix(1);
+        return text;
+    }
+
+    std::vector<std::string_view> splitColumns(std::string_view line, char delimiter)
+    {
+        std::vector<std::string_view> tokens;
+        std::size_t begin = 0;
+        while (begin <= line.size())
+        {
+            std::size_t end;
+            if (delimiter == ' ')
+            {
+                while (begin < line.size() && isBlank(line[begin]))
+                    ++begin;
+                if (begin == line.size())
+                    break;
+                end = begin;
+                while (end < line.size() && !isBlank(line[end]))
+                    ++end;
+            }
+            else
+            {
+                bool quoted = false;
+                for (end = begin; end < line.size() && (quoted || line[end] != delimiter); ++end)
+                    quoted ^= line[end] == '"';
+            }
+            tokens.push_back(trimBlanks(line.substr(begin, end - begin)));
+            begin = end + 1;
+        }
+        return tokens;
+    }
+
+    bool isNumber(std::string_view token)
+    {
+        float value;
+        const char* p = token.data();
+        return !token.empty() && parseFloatASC(p, token.data() + token.size(), value) && p == token.data() + token.size();
+    }
+
+    bool parseColumnRole(std::string_view name, ColumnRole& role)
+    {
+        std::string lower(name);
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (lower == "x") role = ColumnRole::X;
+        else if (lower == "y") role = ColumnRole::Y;
+        else if (lower == "z") role = ColumnRole::Z;
+        else if (lower == "r" || lower == "red") role = ColumnRole::Red;
+        else if (lower == "g" || lower == "green") role = ColumnRole::Green;
+        else if (lower == "b" || lower == "blue") role = ColumnRole::Blue;
+        else if (lower == "i" || lower == "intensity") role = ColumnRole::Intensity;
+        else if (lower == "nx") role = ColumnRole::NormalX;
+        else if (lower == "ny") role = ColumnRole::NormalY;
+        else if (lower == "nz") role = ColumnRole::NormalZ;
+        else if (lower == "_" || lower == "skip") role = ColumnRole::Skip;
+        else return false;
+        return true;
+    }
+
+    bool hasRole(const std::vector<ColumnRole>& columns, ColumnRole role)
+    {
+        return std::find(columns.begin(), columns.end(), role) != columns.end();
+    }
+
+    std::vector<ColumnRole> rolesForColumnCount(std::size_t nColumns)
+    {
+        using R = ColumnRole;
+        switch (nColumns)
+        {
+        case 3: return { R::X, R::Y, R::Z };
+        case 4: return { R::X, R::Y, R::Z, R::Intensity };
+        case 6: return { R::X, R::Y, R::Z, R::Red, R::Green, R::Blue };
+        case 7: return { R::X, R::Y, R::Z, R::Intensity, R::Red, R::Green, R::Blue };
+        case 9: return { R::X, R::Y, R::Z, R::Red, R::Green, R::Blue, R::NormalX, R::NormalY, R::NormalZ };
+        default:
+        {
+            std::vector<R> roles(nColumns, R::Skip);
+            roles[0] = R::X;
+            roles[1] = R::Y;
+            roles[2] = R::Z;
+            return roles;
+        }
+        }
+    }
+}
+
+std::optional<AsciiSchema> detectAsciiSchema(std::string_view text, const std::vector<ColumnRole>& columns)
+{
+    //Collect the first few non-empty lines along with where each one ends
+    struct Line { std::string_view text; std::size_t end; };
+    std::vector<Line> lines;
+    std::size_t lineStart = 0;
+    while (lineStart < text.size() && lines.size() < maxDetectionLines)
+    {
+        std::size_t lineEnd = std::min(text.find('\n', lineStart), text.size());
+        std::string_view line = trimBlanks(text.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+        if (!line.empty())
+            lines.push_back({ line, std::min(lineStart, text.size()) });
+    }
+    if (lines.empty())
+        return std::nullopt;
+
+    AsciiSchema schema;
+    std::size_t firstRecord = 0;
+
+    //PTS files open with the number of points on a line of its own
+    if (lines.size() > 1 && splitColumns(lines[0].text, ' ').size() == 1 && isNumber(lines[0].text)
+        && lines[0].text.find('.') == std::string_view::npos)
+    {
+        //Only a non-negative count that fits is kept, any other number on its own line is still the header
+        std::uint64_t count;
+        std::string_view token = lines[0].text;
+        std::from_chars_result result = std::from_chars(token.data(), token.data() + token.size(), count);
+        if (result.ec == std::errc() && result.ptr == token.data() + token.size())
+            schema.declaredCount = count;
+        schema.headerLength = lines[0].end;
+        firstRecord = 1;
+    }
+    if (firstRecord >= lines.size())
+        return std::nullopt;
+
+    std::string_view sample = lines[firstRecord].text;
+    if (sample.find(',') != std::string_view::npos)
+        schema.delimiter = ',';
+    else if (sample.find(';') != std::string_view::npos)
+        schema.delimiter = ';';
+
+    std::vector<std::string_view> tokens = splitColumns(sample, schema.delimiter);
+    bool nameRow = !tokens.empty() && !isNumber(tokens[0]);
+    if (!columns.empty())
+    {
+        //Given roles may skip a text column, so only text where they expect a number marks a header
+        nameRow = false;
+        for (std::size_t i = 0; i < std::min(tokens.size(), columns.size()); ++i)
+            nameRow = nameRow || (columns[i] != ColumnRole::Skip && !isNumber(tokens[i]));
+        schema.columns = columns;
+    }
+    else if (nameRow)
+    {
+        //A row of names such as "X,Y,Z,R,G,B" maps the columns directly. Names it doesn't know are skipped, but a row
+        //that doesn't name all three coordinates, such as "Easting,Northing,Elevation", is only trusted for its length.
+        for (std::string_view token : tokens)
+        {
+            ColumnRole role;
+            schema.columns.push_back(parseColumnRole(token, role) ? role : ColumnRole::Skip);
+        }
+        if (!hasRole(schema.columns, ColumnRole::X) || !hasRole(schema.columns, ColumnRole::Y) || !hasRole(schema.columns, ColumnRole::Z))
+        {
+            if (tokens.size() < 3)
+                return std::nullopt;
+            schema.columns = rolesForColumnCount(tokens.size());
+        }
+    }
+    else
+    {
+        if (tokens.size() < 3)
+            return std::nullopt;
+        schema.columns = rolesForColumnCount(tokens.size());
+    }
+    if (nameRow)
+    {
+        schema.headerLength = lines[firstRecord].end;
+        ++firstRecord;
+    }
+
+    //Colours are 0-1 floats only if every sampled colour has a decimal point and none exceed 1
+    auto red = std::find(schema.columns.begin(), schema.columns.end(), ColumnRole::Red);
+    if (red != schema.columns.end())
+    {
+        bool unitFloat = firstRecord < lines.size();
+        std::size_t redIndex = static_cast<std::size_t>(red - schema.columns.begin());
+        for (std::size_t i = firstRecord; i < lines.size() && unitFloat; ++i)
+        {
+            std::vector<std::string_view> recordTokens = splitColumns(lines[i].text, schema.delimiter);
+            if (redIndex >= recordTokens.size())
+                continue;
+            std::string_view token = recordTokens[redIndex];
+            float value;
+            const char* p = token.data();
+            unitFloat = token.find('.') != std::string_view::npos && parseFloatASC(p, token.data() + token.size(), value) && value <= 1.0f;
+        }
+        schema.colourType = unitFloat ? ColourType::UnitFloat : ColourType::UInt8;
+    }
+    return schema;
+}
+
+bool parseColumnRoles(std::string_view spec, std::vector<ColumnRole>& columns)
+{
+    columns.clear();
+    for (std::string_view token : splitColumns(spec, ','))
+    {
+        ColumnRole role;
+        if (!parseColumnRole(token, role))
+            return false;
+        columns.push_back(role);
+    }
+    return hasRole(columns, ColumnRole::X) && hasRole(columns, ColumnRole::Y) && hasRole(columns, ColumnRole::Z);
+}
+
+bool hasNormals(const AsciiSchema& schema)
+{
+    return hasRole(schema.columns, ColumnRole::NormalX) && hasRole(schema.columns, ColumnRole::NormalY)
+        && hasRole(schema.columns, ColumnRole::NormalZ);
+}
+
+AsciiBlockParser selectAsciiBlockParser(const AsciiSchema& schema)
+{
+    switch (schema.delimiter)
+    {
+    case ' ': return selectParserForDelimiter<' '>(schema);
+    case ',': return selectParserForDelimiter<','>(schema);
+    case ';': return selectParserForDelimiter<';'>(schema);
+    default: return parseGenericColumnsBlock<','>; //Unreachable for detected schemas
+    }
+}
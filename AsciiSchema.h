@@ -0,0 +1,44 @@
+#pragma once
+#include "PointCloudVertex.h"
+#include "Bounds.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+enum class ColumnRole { Skip, X, Y, Z, Red, Green, Blue, Intensity, NormalX, NormalY, NormalZ };
+enum class ColourType { UInt8, UnitFloat }; //0-255 integers or 0-1 floats
+
+//Describes the columns of an ASCII point cloud.
+struct AsciiSchema
+{
+	std::vector<ColumnRole> columns;
+	char delimiter = ' '; //' ' matches any run of blanks, otherwise a single character such as ','
+	ColourType colourType = ColourType::UInt8;
+	std::size_t headerLength = 0; //Bytes before the first record: a PTS count line and/or a row of column names
+	std::optional<std::uint64_t> declaredCount; //From a PTS count line, only a hint since nothing checks it against the records
+};
+
+//Inspects the first lines of text to find the delimiter, header lines, colour type and column roles.
+//Column roles come from a name row if it names x, y and z, otherwise from the column count:
+//3 "x y z", 4 "x y z i", 6 "x y z r g b", 7 "x y z i r g b" (PTS), 9 "x y z r g b nx ny nz".
+//A non-empty columns list is used as the roles instead, even if the lines match no layout detection knows, and a
+//first row is then only taken for a header if one of its numeric columns isn't a number.
+std::optional<AsciiSchema> detectAsciiSchema(std::string_view text, const std::vector<ColumnRole>& columns = {});
+
+//Parses a comma separated list of roles such as "x,y,z,_,r,g,b" ("_" skips a column).
+bool parseColumnRoles(std::string_view spec, std::vector<ColumnRole>& columns);
+
+//True if the schema has all three normal columns, whose values are then kept rather than skipped.
+bool hasNormals(const AsciiSchema& schema);
+
+//Parses newline separated records in block into destination and returns the number written.
+//destination must have room for one vertex per line, lines missing a column are skipped. Written vertices are added to bounds.
+//If the schema has normals, normals receives each written vertex's normal octahedral encoded, otherwise it may be null.
+using AsciiBlockParser = std::size_t(*)(std::string_view block, PointCloudVertex* destination, std::uint32_t* normals,
+	const AsciiSchema& schema, BoundsAccumulator& bounds);
+
+//Returns a parser specialised at compile time for common layouts, or a generic one driven by schema.columns.
+AsciiBlockParser selectAsciiBlockParser(const AsciiSchema& schema);
@@ -0,0 +1,145 @@
+#pragma once
+//C++
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+//Fixed capacity lock-free multi-producer/multi-consumer queue (Vyukov's bounded ring).
+//Each cell carries a sequence number that tells producers and consumers whether it is free or full,
+//so push and pop only contend on a single atomic index. Capacity is rounded up to a power of two.
+//The blocking push and pop only take a lock to sleep while the queue is full or empty and to wake the other side.
+template<typename T>
+class BoundedQueue
+{
+	struct Cell
+	{
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	std::size_t mask;
+	alignas(64) std::atomic<std::size_t> enqueuePos{ 0 };
+	alignas(64) std::atomic<std::size_t> dequeuePos{ 0 };
+
+	std::mutex waitMutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	bool closed = false;
+
+	//Taking the lock orders the change before any waiter's recheck, so the wake up can't be lost
+	void wake(std::condition_variable& waiters)
+	{
+		{
+			std::lock_guard<std::mutex> lock(waitMutex);
+		}
+		waiters.notify_one();
+	}
+
+public:
+	explicit BoundedQueue(std::size_t capacity)
+	{
+		std::size_t size = 2;
+		while (size < capacity)
+			size <<= 1;
+		cells = std::make_unique<Cell[]>(size);
+		mask = size - 1;
+		for (std::size_t i = 0; i < size; ++i)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	//Returns false without moving from value if the queue is full.
+	bool tryPush(T& value)
+	{
+		std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = cells[pos & mask];
+			std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+			if (difference == 0)
+			{
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					cell.value = std::move(value);
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+				return false;
+			else
+				pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	//Returns false if the queue is empty.
+	bool tryPop(T& value)
+	{
+		std::size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Cell& cell = cells[pos & mask];
+			std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+			if (difference == 0)
+			{
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					value = std::move(cell.value);
+					cell.sequence.store(pos + mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+				return false;
+			else
+				pos = dequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	//Waits while the queue is full, then moves from value.
+	void push(T& value)
+	{
+		if (!tryPush(value))
+		{
+			std::unique_lock<std::mutex> lock(waitMutex);
+			notFull.wait(lock, [&] { return tryPush(value); });
+		}
+		wake(notEmpty);
+	}
+	void push(T&& value)
+	{
+		push(value);
+	}
+
+	//Waits while the queue is empty. Returns false once it is empty and closed.
+	bool pop(T& value)
+	{
+		bool popped = tryPop(value);
+		if (!popped)
+		{
+			std::unique_lock<std::mutex> lock(waitMutex);
+			notEmpty.wait(lock, [&] { return (popped = tryPop(value)) || closed; });
+			if (!popped)
+				return false;
+		}
+		wake(notFull);
+		return true;
+	}
+
+	//No more values will be pushed: pop drains what is left and then stops waiting.
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(waitMutex);
+			closed = true;
+		}
+		notEmpty.notify_all();
+	}
+};
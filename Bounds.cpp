@@ -0,0 +1,523 @@
+#include "Bounds.h"
+#include "ThreadPool.h"
+//C++
+#include <array>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCV_BOUNDS_SSE2
+#include <xmmintrin.h>
+#endif
+using namespace DirectX;
+
+namespace
+{
+    using Point3 = std::array<double, 3>;
+
+    constexpr std::size_t boundsVerticesPerTask = 1 << 16;
+    constexpr std::size_t coreSetSampleSize = 1024;
+    constexpr int maxCoreSetRounds = 64;
+
+    //Relative slack when testing against the core set's ball. The parallel scan works in float, so it uses a larger one.
+    constexpr double welzlTolerance = 1e-10;
+    constexpr float scanTolerance = 1e-5f;
+    constexpr float radiusPadding = 4.0f * std::numeric_limits<float>::epsilon();
+
+#if defined(PCV_BOUNDS_SSE2)
+    //Positions of vertices[0..3] transposed into x, y and z lanes. Each 16 byte load stays inside its vertex,
+    //the fourth float being the red channel, which is discarded.
+    inline void loadPositions4(const PointCloudVertex* vertices, __m128& x, __m128& y, __m128& z)
+    {
+        __m128 a = _mm_loadu_ps(&vertices[0].modelPos.x);
+        __m128 b = _mm_loadu_ps(&vertices[1].modelPos.x);
+        __m128 c = _mm_loadu_ps(&vertices[2].modelPos.x);
+        __m128 d = _mm_loadu_ps(&vertices[3].modelPos.x);
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        x = a;
+        y = b;
+        z = c;
+    }
+
+    inline float horizontalMin(__m128 v)
+    {
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(_mm_min_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+
+    inline float horizontalMax(__m128 v)
+    {
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(_mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+
+    inline double horizontalSum(__m128 v)
+    {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, v);
+        return static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+
+    inline float distanceSquared(const DirectX::XMFLOAT3& pos, const float (&centre)[3])
+    {
+        float dx = pos.x - centre[0], dy = pos.y - centre[1], dz = pos.z - centre[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    struct FarthestVertex
+    {
+        float distanceSquared = -1.0f;
+        std::size_t index = 0;
+    };
+
+    FarthestVertex findFarthestVertex(const PointCloudVertex* vertices, std::size_t begin, std::size_t end, const float (&centre)[3])
+    {
+        FarthestVertex farthest;
+        std::size_t i = begin;
+#if defined(PCV_BOUNDS_SSE2)
+        __m128 cx = _mm_set1_ps(centre[0]), cy = _mm_set1_ps(centre[1]), cz = _mm_set1_ps(centre[2]);
+        __m128 best = _mm_set1_ps(-1.0f);
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 x, y, z;
+            loadPositions4(vertices + i, x, y, z);
+            x = _mm_sub_ps(x, cx);
+            y = _mm_sub_ps(y, cy);
+            z = _mm_sub_ps(z, cz);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+            //A new maximum is rare once the scan is under way, so lanes are only inspected when one beats it
+            if (_mm_movemask_ps(_mm_cmpgt_ps(d2, best)) != 0)
+            {
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, d2);
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    if (lanes[lane] > farthest.distanceSquared)
+                        farthest = { lanes[lane], i + lane };
+                }
+                best = _mm_set1_ps(farthest.distanceSquared);
+            }
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            float d2 = distanceSquared(vertices[i].modelPos, centre);
+            if (d2 > farthest.distanceSquared)
+                farthest = { d2, i };
+        }
+        return farthest;
+    }
+
+    struct Ball
+    {
+        Point3 centre = { 0.0, 0.0, 0.0 };
+        double radiusSquared = -1.0; //Empty ball
+    };
+
+    double distanceSquared(const Point3& a, const Point3& b)
+    {
+        double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    //Smallest ball with every support point on its surface. Its centre is p0 + sum(lambda_j * v_j) with v_j = p_j - p0,
+    //which solves 2 v_i.v_j lambda_j = v_i.v_i. Returns false if the points are affinely dependent.
+    bool ballThrough(const Point3* support, int nSupport, Ball& ball)
+    {
+        if (nSupport == 0)
+        {
+            ball = Ball();
+            return true;
+        }
+
+        const Point3& p0 = support[0];
+        Point3 v[3];
+        double system[3][4] = {};
+        int n = nSupport - 1;
+        for (int i = 0; i < n; ++i)
+            for (int axis = 0; axis < 3; ++axis)
+                v[i][axis] = support[i + 1][axis] - p0[axis];
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+                system[i][j] = 2.0 * (v[i][0] * v[j][0] + v[i][1] * v[j][1] + v[i][2] * v[j][2]);
+            system[i][n] = v[i][0] * v[i][0] + v[i][1] * v[i][1] + v[i][2] * v[i][2];
+        }
+
+        //Gaussian elimination with partial pivoting
+        double scale = 0.0;
+        for (int i = 0; i < n; ++i)
+            scale = std::max(scale, system[i][i]);
+        for (int column = 0; column < n; ++column)
+        {
+            int pivot = column;
+            for (int row = column + 1; row < n; ++row)
+            {
+                if (std::abs(system[row][column]) > std::abs(system[pivot][column]))
+                    pivot = row;
+            }
+            if (std::abs(system[pivot][column]) <= 1e-12 * scale)
+                return false;
+            std::swap(system[column], system[pivot]);
+            for (int row = 0; row < n; ++row)
+            {
+                if (row == column)
+                    continue;
+                double factor = system[row][column] / system[column][column];
+                for (int k = column; k <= n; ++k)
+                    system[row][k] -= factor * system[column][k];
+            }
+        }
+
+        Ball result;
+        result.centre = p0;
+        for (int j = 0; j < n; ++j)
+        {
+            double lambda = system[j][n] / system[j][j];
+            for (int axis = 0; axis < 3; ++axis)
+                result.centre[axis] += lambda * v[j][axis];
+        }
+        result.radiusSquared = distanceSquared(result.centre, p0);
+        ball = result;
+        return true;
+    }
+
+    //Gaertner's move-to-front variant of Welzl's algorithm. Points that end up on the boundary migrate to the front
+    //of the list, so later passes find them early.
+    class MoveToFrontWelzl
+    {
+        std::list<Point3> points;
+        Point3 support[4];
+        Ball ball;
+
+        bool outside(const Point3& point) const
+        {
+            return distanceSquared(point, ball.centre) > ball.radiusSquared * (1.0 + welzlTolerance);
+        }
+
+        void build(std::list<Point3>::iterator end, int nSupport)
+        {
+            if (nSupport == 4)
+                return;
+            for (auto point = points.begin(); point != end;)
+            {
+                auto next = std::next(point);
+                if (outside(*point))
+                {
+                    support[nSupport] = *point;
+                    //Degenerate support sets are skipped, the point is then picked up by a later, wider ball
+                    if (ballThrough(support, nSupport + 1, ball))
+                    {
+                        build(point, nSupport + 1);
+                        points.splice(points.begin(), points, point);
+                    }
+                }
+                point = next;
+            }
+        }
+
+    public:
+        explicit MoveToFrontWelzl(const std::vector<Point3>& coreSet) : points(coreSet.begin(), coreSet.end()) {}
+
+        Ball solve()
+        {
+            ball = Ball();
+            build(points.end(), 0);
+            return ball;
+        }
+    };
+
+    //Symmetric 3x3 eigen decomposition by cyclic Jacobi rotations. Eigenvectors end up in the columns of vectors.
+    void jacobiEigen(double (&matrix)[3][3], double (&values)[3], double (&vectors)[3][3])
+    {
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                vectors[i][j] = i == j ? 1.0 : 0.0;
+
+        for (int sweep = 0; sweep < 32; ++sweep)
+        {
+            double offDiagonal = std::abs(matrix[0][1]) + std::abs(matrix[0][2]) + std::abs(matrix[1][2]);
+            if (offDiagonal < 1e-15 * (std::abs(matrix[0][0]) + std::abs(matrix[1][1]) + std::abs(matrix[2][2])) || offDiagonal == 0.0)
+                break;
+            for (int p = 0; p < 2; ++p)
+            {
+                for (int q = p + 1; q < 3; ++q)
+                {
+                    if (matrix[p][q] == 0.0)
+                        continue;
+                    double theta = (matrix[q][q] - matrix[p][p]) / (2.0 * matrix[p][q]);
+                    double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                    double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double kp = matrix[k][p], kq = matrix[k][q];
+                        matrix[k][p] = c * kp - s * kq;
+                        matrix[k][q] = s * kp + c * kq;
+                    }
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double pk = matrix[p][k], qk = matrix[q][k];
+                        matrix[p][k] = c * pk - s * qk;
+                        matrix[q][k] = s * pk + c * qk;
+                    }
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        double kp = vectors[k][p], kq = vectors[k][q];
+                        vectors[k][p] = c * kp - s * kq;
+                        vectors[k][q] = s * kp + c * kq;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < 3; ++i)
+            values[i] = matrix[i][i];
+    }
+}
+
+void BoundsAccumulator::merge(const BoundsAccumulator& other)
+{
+    min = { std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z) };
+    max = { std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z) };
+    for (int axis = 0; axis < 3; ++axis)
+        sum[axis] += other.sum[axis];
+    count += other.count;
+}
+
+PointCloudBounds BoundsAccumulator::result() const
+{
+    PointCloudBounds bounds = {};
+    if (count == 0)
+        return bounds;
+
+    bounds.box = { min, max };
+    bounds.centroid = XMFLOAT3(static_cast<float>(sum[0] / count), static_cast<float>(sum[1] / count), static_cast<float>(sum[2] / count));
+
+    XMVECTOR minimum = XMLoadFloat3(&min);
+    XMVECTOR maximum = XMLoadFloat3(&max);
+    XMStoreFloat3(&bounds.sphere.centre, XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f));
+    XMStoreFloat(&bounds.sphere.radius, XMVectorScale(XMVector3Length(XMVectorSubtract(maximum, minimum)), 0.5f));
+    return bounds;
+}
+
+PointCloudBounds calculateBounds(const PointCloudVertex* vertices, std::size_t nVertices)
+{
+    std::size_t nTasks = (nVertices + boundsVerticesPerTask - 1) / boundsVerticesPerTask;
+    std::vector<BoundsAccumulator> partialBounds(nTasks);
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t begin = task * boundsVerticesPerTask;
+        std::size_t end = std::min(begin + boundsVerticesPerTask, nVertices);
+        for (std::size_t i = begin; i < end; ++i)
+            partialBounds[task].add(vertices[i]);
+    });
+
+    BoundsAccumulator bounds;
+    for (const auto& partial : partialBounds)
+        bounds.merge(partial);
+    return bounds.result();
+}
+
+BoundingSphere calculateMinimumEnclosingSphere(const PointCloudVertex* vertices, std::size_t nVertices)
+{
+    if (nVertices == 0)
+        return { XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f };
+
+    auto toPoint = [](const PointCloudVertex& vertex) { return Point3{ vertex.modelPos.x, vertex.modelPos.y, vertex.modelPos.z }; };
+
+    //An evenly strided sample usually lands close to the final ball, so few rounds are needed
+    std::vector<Point3> coreSet;
+    std::size_t stride = std::max<std::size_t>(nVertices / coreSetSampleSize, 1);
+    for (std::size_t i = 0; i < nVertices; i += stride)
+        coreSet.push_back(toPoint(vertices[i]));
+
+    std::size_t nTasks = (nVertices + boundsVerticesPerTask - 1) / boundsVerticesPerTask;
+    std::vector<FarthestVertex> taskFarthest(nTasks);
+    float centre[3] = {};
+    float farthestDistanceSquared = 0.0f;
+    double previousRadiusSquared = -1.0;
+
+    for (int round = 0; round < maxCoreSetRounds; ++round)
+    {
+        Ball ball = MoveToFrontWelzl(coreSet).solve();
+        for (int axis = 0; axis < 3; ++axis)
+            centre[axis] = static_cast<float>(ball.centre[axis]);
+
+        ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t begin = task * boundsVerticesPerTask;
+            taskFarthest[task] = findFarthestVertex(vertices, begin, std::min(begin + boundsVerticesPerTask, nVertices), centre);
+        });
+
+        //The ball of a subset that already encloses every vertex is the ball of the whole cloud
+        float threshold = static_cast<float>(ball.radiusSquared) * (1.0f + scanTolerance);
+        farthestDistanceSquared = 0.0f;
+        bool grew = false;
+        for (const auto& farthest : taskFarthest)
+        {
+            farthestDistanceSquared = std::max(farthestDistanceSquared, farthest.distanceSquared);
+            if (farthest.distanceSquared > threshold)
+            {
+                coreSet.push_back(toPoint(vertices[farthest.index]));
+                grew = true;
+            }
+        }
+        //Float rounding of the centre can flag a vertex the double solve already covers, the ball then stops growing
+        if (!grew || ball.radiusSquared <= previousRadiusSquared)
+            break;
+        previousRadiusSquared = ball.radiusSquared;
+    }
+
+    //The float distances are each a few ulps off, so the radius is padded by that much to be sure to cover the farthest vertex
+    float radius = std::sqrt(farthestDistanceSquared) * (1.0f + radiusPadding);
+    return { XMFLOAT3(centre[0], centre[1], centre[2]), radius };
+}
+
+OrientedBoundingBox calculateOrientedBoundingBox(const PointCloudVertex* vertices, std::size_t nVertices, const XMFLOAT3& centroid)
+{
+    OrientedBoundingBox box = {};
+    box.centre = centroid;
+    box.axes[0] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+    box.axes[1] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+    box.axes[2] = XMFLOAT3(0.0f, 0.0f, 1.0f);
+    if (nVertices == 0)
+        return box;
+
+    std::size_t nTasks = (nVertices + boundsVerticesPerTask - 1) / boundsVerticesPerTask;
+    const float c[3] = { centroid.x, centroid.y, centroid.z };
+
+    //Covariance about the centroid: xx, yy, zz, xy, xz, yz
+    std::vector<std::array<double, 6>> taskCovariance(nTasks);
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t begin = task * boundsVerticesPerTask;
+        std::size_t end = std::min(begin + boundsVerticesPerTask, nVertices);
+        std::array<double, 6> sums = {};
+        std::size_t i = begin;
+#if defined(PCV_BOUNDS_SSE2)
+        //Float lanes are flushed to double every 64 vertices to keep their rounding error small
+        __m128 cx = _mm_set1_ps(c[0]), cy = _mm_set1_ps(c[1]), cz = _mm_set1_ps(c[2]);
+        while (i + 4 <= end)
+        {
+            __m128 lanes[6] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+            for (std::size_t batchEnd = std::min(i + 64, end); i + 4 <= batchEnd; i += 4)
+            {
+                __m128 x, y, z;
+                loadPositions4(vertices + i, x, y, z);
+                x = _mm_sub_ps(x, cx);
+                y = _mm_sub_ps(y, cy);
+                z = _mm_sub_ps(z, cz);
+                lanes[0] = _mm_add_ps(lanes[0], _mm_mul_ps(x, x));
+                lanes[1] = _mm_add_ps(lanes[1], _mm_mul_ps(y, y));
+                lanes[2] = _mm_add_ps(lanes[2], _mm_mul_ps(z, z));
+                lanes[3] = _mm_add_ps(lanes[3], _mm_mul_ps(x, y));
+                lanes[4] = _mm_add_ps(lanes[4], _mm_mul_ps(x, z));
+                lanes[5] = _mm_add_ps(lanes[5], _mm_mul_ps(y, z));
+            }
+            for (int k = 0; k < 6; ++k)
+                sums[k] += horizontalSum(lanes[k]);
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            double x = vertices[i].modelPos.x - c[0], y = vertices[i].modelPos.y - c[1], z = vertices[i].modelPos.z - c[2];
+            sums[0] += x * x; sums[1] += y * y; sums[2] += z * z;
+            sums[3] += x * y; sums[4] += x * z; sums[5] += y * z;
+        }
+        taskCovariance[task] = sums;
+    });
+
+    std::array<double, 6> sums = {};
+    for (const auto& partial : taskCovariance)
+        for (int k = 0; k < 6; ++k)
+            sums[k] += partial[k];
+    double covariance[3][3] = {
+        { sums[0], sums[3], sums[4] },
+        { sums[3], sums[1], sums[5] },
+        { sums[4], sums[5], sums[2] } };
+    double eigenvalues[3], eigenvectors[3][3];
+    jacobiEigen(covariance, eigenvalues, eigenvectors);
+
+    int order[3] = { 0, 1, 2 };
+    std::sort(order, order + 3, [&](int a, int b) { return eigenvalues[a] > eigenvalues[b]; });
+    float axes[3][3];
+    for (int k = 0; k < 3; ++k)
+        for (int axis = 0; axis < 3; ++axis)
+            axes[k][axis] = static_cast<float>(eigenvectors[axis][order[k]]);
+
+    //Extents: min and max projection of the vertices onto each axis, relative to the centroid
+    std::vector<std::array<float, 6>> taskExtents(nTasks);
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t begin = task * boundsVerticesPerTask;
+        std::size_t end = std::min(begin + boundsVerticesPerTask, nVertices);
+        float lowest[3], highest[3];
+        std::fill(lowest, lowest + 3, std::numeric_limits<float>::infinity());
+        std::fill(highest, highest + 3, -std::numeric_limits<float>::infinity());
+        std::size_t i = begin;
+#if defined(PCV_BOUNDS_SSE2)
+        __m128 cx = _mm_set1_ps(c[0]), cy = _mm_set1_ps(c[1]), cz = _mm_set1_ps(c[2]);
+        __m128 low[3], high[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            low[k] = _mm_set1_ps(std::numeric_limits<float>::infinity());
+            high[k] = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+        }
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 x, y, z;
+            loadPositions4(vertices + i, x, y, z);
+            x = _mm_sub_ps(x, cx);
+            y = _mm_sub_ps(y, cy);
+            z = _mm_sub_ps(z, cz);
+            for (int k = 0; k < 3; ++k)
+            {
+                __m128 projection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(axes[k][0])), _mm_mul_ps(y, _mm_set1_ps(axes[k][1]))),
+                    _mm_mul_ps(z, _mm_set1_ps(axes[k][2])));
+                low[k] = _mm_min_ps(low[k], projection);
+                high[k] = _mm_max_ps(high[k], projection);
+            }
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            lowest[k] = horizontalMin(low[k]);
+            highest[k] = horizontalMax(high[k]);
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            float x = vertices[i].modelPos.x - c[0], y = vertices[i].modelPos.y - c[1], z = vertices[i].modelPos.z - c[2];
+            for (int k = 0; k < 3; ++k)
+            {
+                float projection = x * axes[k][0] + y * axes[k][1] + z * axes[k][2];
+                lowest[k] = std::min(lowest[k], projection);
+                highest[k] = std::max(highest[k], projection);
+            }
+        }
+        taskExtents[task] = { lowest[0], lowest[1], lowest[2], highest[0], highest[1], highest[2] };
+    });
+
+    float lowest[3], highest[3];
+    std::fill(lowest, lowest + 3, std::numeric_limits<float>::infinity());
+    std::fill(highest, highest + 3, -std::numeric_limits<float>::infinity());
+    for (const auto& extents : taskExtents)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            lowest[k] = std::min(lowest[k], extents[k]);
+            highest[k] = std::max(highest[k], extents[k + 3]);
+        }
+    }
+
+    float centre[3] = { c[0], c[1], c[2] };
+    float halfExtents[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        float middle = (lowest[k] + highest[k]) * 0.5f;
+        halfExtents[k] = (highest[k] - lowest[k]) * 0.5f;
+        for (int axis = 0; axis < 3; ++axis)
+            centre[axis] += middle * axes[k][axis];
+        box.axes[k] = XMFLOAT3(axes[k][0], axes[k][1], axes[k][2]);
+    }
+    box.centre = XMFLOAT3(centre[0], centre[1], centre[2]);
+    box.halfExtents = XMFLOAT3(halfExtents[0], halfExtents[1], halfExtents[2]);
+    return box;
+}
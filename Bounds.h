@@ -0,0 +1,79 @@
+#pragma once
+#include "PointCloudVertex.h"
+//C++
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+struct BoundingSphere
+{
+	DirectX::XMFLOAT3 centre;
+	float radius;
+};
+
+struct BoundingBox
+{
+	DirectX::XMFLOAT3 min;
+	DirectX::XMFLOAT3 max;
+};
+
+inline BoundingBox mergeBoundingBoxes(const BoundingBox& a, const BoundingBox& b)
+{
+	return { { std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+		{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) } };
+}
+
+struct PointCloudBounds
+{
+	BoundingBox box;
+	DirectX::XMFLOAT3 centroid;
+	BoundingSphere sphere; //Encloses every vertex
+	bool minimalSphere = false; //Whether sphere is the minimum enclosing one rather than the box's circumsphere
+};
+
+//Running bounds of one block of vertices. Loader workers keep one per block and add each vertex as it is written,
+//the blocks are then merged, so the bounds cost no extra pass over the vertices.
+struct BoundsAccumulator
+{
+	DirectX::XMFLOAT3 min = { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+	DirectX::XMFLOAT3 max = { -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
+	double sum[3] = {}; //A float sum stops absorbing small coordinates after a few million points
+	std::uint64_t count = 0;
+
+	void add(const PointCloudVertex& vertex)
+	{
+		const DirectX::XMFLOAT3& pos = vertex.modelPos;
+		min = { std::min(min.x, pos.x), std::min(min.y, pos.y), std::min(min.z, pos.z) };
+		max = { std::max(max.x, pos.x), std::max(max.y, pos.y), std::max(max.z, pos.z) };
+		sum[0] += pos.x;
+		sum[1] += pos.y;
+		sum[2] += pos.z;
+		++count;
+	}
+
+	void merge(const BoundsAccumulator& other);
+
+	//Box, centroid and the sphere circumscribing the box. Zero sized at the origin if nothing was added.
+	PointCloudBounds result() const;
+};
+
+//Bounds of vertices that didn't come from a loader, reduced in parallel blocks.
+PointCloudBounds calculateBounds(const PointCloudVertex* vertices, std::size_t nVertices);
+
+//Box aligned with the principal axes of the vertices, axes sorted by decreasing variance.
+struct OrientedBoundingBox
+{
+	DirectX::XMFLOAT3 centre;
+	DirectX::XMFLOAT3 axes[3]; //Orthonormal
+	DirectX::XMFLOAT3 halfExtents; //Along each of axes
+};
+
+//Exact smallest sphere enclosing every vertex. Welzl's move-to-front algorithm solves a small core set, the whole cloud
+//is then scanned in parallel for vertices outside the ball and the farthest ones join the core set until none remain.
+//The radius is finally grown to the farthest vertex and padded by its rounding error, so no vertex is left outside.
+BoundingSphere calculateMinimumEnclosingSphere(const PointCloudVertex* vertices, std::size_t nVertices);
+
+//Fits the box axes to the eigenvectors of the covariance about centroid, then projects every vertex for the extents.
+OrientedBoundingBox calculateOrientedBoundingBox(const PointCloudVertex* vertices, std::size_t nVertices,
+	const DirectX::XMFLOAT3& centroid);
@@ -0,0 +1,176 @@
+#include "FrustumCulling.h"
+//C++
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCV_FRUSTUM_SSE2
+#include <xmmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    //Boxes transposed into one array per bound, so each plane test reads four boxes per load.
+    struct BoxLanes
+    {
+        alignas(16) float min[3][8];
+        alignas(16) float max[3][8];
+    };
+}
+
+Frustum extractFrustum(FXMMATRIX MVP)
+{
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, MVP);
+    //Clip coordinates are dot products of the model position with the matrix's columns
+    auto column = [&](int j) { return XMFLOAT4(m.m[0][j], m.m[1][j], m.m[2][j], m.m[3][j]); };
+    auto combine = [](const XMFLOAT4& a, const XMFLOAT4& b, float sign) {
+        return XMFLOAT4(a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z, a.w + sign * b.w);
+    };
+    XMFLOAT4 x = column(0), y = column(1), z = column(2), w = column(3);
+
+    Frustum frustum;
+    frustum.planes[0] = combine(w, x, 1.0f);
+    frustum.planes[1] = combine(w, x, -1.0f);
+    frustum.planes[2] = combine(w, y, 1.0f);
+    frustum.planes[3] = combine(w, y, -1.0f);
+    frustum.planes[4] = z;
+    frustum.planes[5] = combine(w, z, -1.0f);
+    for (XMFLOAT4& plane : frustum.planes)
+    {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f)
+            plane = XMFLOAT4(plane.x / length, plane.y / length, plane.z / length, plane.w / length);
+    }
+    return frustum;
+}
+
+int classifyBoxes(const Frustum& frustum, const BoundingBox* boxes, std::size_t nBoxes, std::uint8_t parentMask,
+    int firstPlane, std::uint8_t* masks)
+{
+    int rejectingPlane = -1;
+    for (std::size_t groupBegin = 0; groupBegin < nBoxes; groupBegin += 8)
+    {
+        std::size_t nGroup = std::min<std::size_t>(nBoxes - groupBegin, 8);
+        BoxLanes lanes;
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            //Pad with copies of the first box so every lane holds a real one
+            const BoundingBox& box = boxes[groupBegin + (i < nGroup ? i : 0)];
+            lanes.min[0][i] = box.min.x;
+            lanes.min[1][i] = box.min.y;
+            lanes.min[2][i] = box.min.z;
+            lanes.max[0][i] = box.max.x;
+            lanes.max[1][i] = box.max.y;
+            lanes.max[2][i] = box.max.z;
+        }
+
+        for (std::size_t quad = 0; quad < nGroup; quad += 4)
+        {
+            int outside = 0;
+            int straddling[nFrustumPlanes] = {};
+            int allOut = (1 << std::min<std::size_t>(nGroup - quad, 4)) - 1;
+            for (int step = 0; step < nFrustumPlanes && (outside & allOut) != allOut; ++step)
+            {
+                int plane = (firstPlane + step) % nFrustumPlanes;
+                if ((parentMask & (1 << plane)) == 0)
+                    continue;
+                const XMFLOAT4& p = frustum.planes[plane];
+                //The corner furthest along the normal decides if a box is outside, the nearest one if it is inside
+                const float* farX = p.x >= 0.0f ? lanes.max[0] : lanes.min[0];
+                const float* farY = p.y >= 0.0f ? lanes.max[1] : lanes.min[1];
+                const float* farZ = p.z >= 0.0f ? lanes.max[2] : lanes.min[2];
+                const float* nearX = p.x >= 0.0f ? lanes.min[0] : lanes.max[0];
+                const float* nearY = p.y >= 0.0f ? lanes.min[1] : lanes.max[1];
+                const float* nearZ = p.z >= 0.0f ? lanes.min[2] : lanes.max[2];
+                int planeOutside, planeStraddling;
+#if defined(PCV_FRUSTUM_SSE2)
+                __m128 a = _mm_set1_ps(p.x), b = _mm_set1_ps(p.y), c = _mm_set1_ps(p.z), d = _mm_set1_ps(p.w);
+                __m128 farDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_load_ps(farX + quad)),
+                    _mm_mul_ps(b, _mm_load_ps(farY + quad))), _mm_add_ps(_mm_mul_ps(c, _mm_load_ps(farZ + quad)), d));
+                __m128 nearDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_load_ps(nearX + quad)),
+                    _mm_mul_ps(b, _mm_load_ps(nearY + quad))), _mm_add_ps(_mm_mul_ps(c, _mm_load_ps(nearZ + quad)), d));
+                planeOutside = _mm_movemask_ps(_mm_cmplt_ps(farDistance, _mm_setzero_ps()));
+                planeStraddling = _mm_movemask_ps(_mm_cmplt_ps(nearDistance, _mm_setzero_ps()));
+#else
+                planeOutside = 0;
+                planeStraddling = 0;
+                for (int lane = 0; lane < 4; ++lane)
+                {
+                    std::size_t i = quad + lane;
+                    if (p.x * farX[i] + p.y * farY[i] + p.z * farZ[i] + p.w < 0.0f)
+                        planeOutside |= 1 << lane;
+                    if (p.x * nearX[i] + p.y * nearY[i] + p.z * nearZ[i] + p.w < 0.0f)
+                        planeStraddling |= 1 << lane;
+                }
+#endif
+                if (rejectingPlane < 0 && (planeOutside & allOut & ~outside) != 0)
+                    rejectingPlane = plane;
+                outside |= planeOutside;
+                straddling[plane] = planeStraddling;
+            }
+
+            for (std::size_t lane = 0; lane < 4 && quad + lane < nGroup; ++lane)
+            {
+                std::uint8_t mask = 0;
+                for (int plane = 0; plane < nFrustumPlanes; ++plane)
+                {
+                    if (straddling[plane] & (1 << lane))
+                        mask |= 1 << plane;
+                }
+                masks[groupBegin + quad + lane] = (outside & (1 << lane)) ? outsideFrustum : mask;
+            }
+        }
+    }
+    return rejectingPlane < 0 ? firstPlane : rejectingPlane;
+}
+
+std::uint8_t FrustumCuller::classifyRoot(const Frustum& frustum, const BoundingBox& rootBounds, std::size_t nNodes)
+{
+    if (firstPlanes.size() != nNodes)
+        firstPlanes.assign(nNodes, 0);
+    std::uint8_t mask;
+    classifyBoxes(frustum, &rootBounds, 1, allFrustumPlanes, 0, &mask);
+    return mask;
+}
+
+const std::vector<DrawRange>& FrustumCuller::cull(const Octree& octree, const Frustum& frustum)
+{
+    ranges.clear();
+    if (octree.nodes.empty())
+        return ranges;
+
+    auto take = [&](const OctreeNode& node) {
+        if (!ranges.empty() && ranges.back().firstVertex + ranges.back().nVertices == node.firstPoint)
+            ranges.back().nVertices += node.nPoints;
+        else
+            ranges.push_back({ node.firstPoint, node.nPoints });
+    };
+
+    //Depth first with the children pushed in reverse, so ranges come out in vertex order
+    stack.clear();
+    stack.push_back({ 0, classifyRoot(frustum, octree.nodes[0].bounds, octree.nodes.size()) });
+    while (!stack.empty())
+    {
+        Pending pending = stack.back();
+        stack.pop_back();
+        if (pending.mask == outsideFrustum)
+            continue;
+        const OctreeNode& node = octree.nodes[pending.node];
+        if (pending.mask == 0 || node.isLeaf())
+        {
+            take(node);
+            continue;
+        }
+        std::uint8_t childMasks[8];
+        classifyChildren(frustum, octree.nodes, pending.node, pending.mask, childMasks);
+        std::uint32_t nChildren = 0;
+        for (std::uint8_t mask = node.childMask; mask != 0; mask &= mask - 1)
+            ++nChildren;
+        for (std::uint32_t child = nChildren; child-- > 0;)
+            stack.push_back({ node.firstChild + child, childMasks[child] });
+    }
+    return ranges;
+}
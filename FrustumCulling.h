@@ -0,0 +1,69 @@
+#pragma once
+#include "Bounds.h"
+#include "Octree.h"
+#include "VertexSegments.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr int nFrustumPlanes = 6;
+//Plane masks: bit i set means the box straddles plane i, so its children still have to be tested against it.
+constexpr std::uint8_t allFrustumPlanes = (1 << nFrustumPlanes) - 1;
+constexpr std::uint8_t outsideFrustum = 0x80;
+
+//Left, right, bottom, top, near and far planes as (a, b, c, d), with a*x + b*y + c*z + d >= 0 on the inside.
+struct Frustum
+{
+	DirectX::XMFLOAT4 planes[nFrustumPlanes];
+};
+
+//Extracts the planes of D3D's clip volume (-w <= x, y <= w and 0 <= z <= w) in model space from a row vector MVP.
+Frustum extractFrustum(DirectX::FXMMATRIX MVP);
+
+//Classifies boxes against the planes in parentMask, four boxes per SSE instruction. masks[i] receives outsideFrustum,
+//or the planes box i straddles, so 0 means it is entirely inside. Planes are tested in order from firstPlane, and a
+//group of four stops early once every box in it is outside. Returns the plane that rejected the first culled box,
+//or firstPlane if none was.
+int classifyBoxes(const Frustum& frustum, const BoundingBox* boxes, std::size_t nBoxes, std::uint8_t parentMask,
+	int firstPlane, std::uint8_t* masks);
+
+//Hierarchical culling with frame to frame coherence: every node remembers the plane that rejected one of its
+//children last frame, and its children are tested against that plane first, which usually rejects them straight
+//away while the camera moves smoothly. Planes a node is entirely inside aren't tested again below it.
+class FrustumCuller
+{
+	std::vector<std::uint8_t> firstPlanes; //Per node
+	struct Pending
+	{
+		std::uint32_t node;
+		std::uint8_t mask;
+	};
+	std::vector<Pending> stack;
+	std::vector<DrawRange> ranges;
+
+public:
+	//Mask of the root, the starting point of a traversal. Sizes the per node state to nNodes.
+	std::uint8_t classifyRoot(const Frustum& frustum, const BoundingBox& rootBounds, std::size_t nNodes);
+
+	//Classifies the children of nodes[parent], which must be straddling parentMask, into childMasks in octant order.
+	template<typename Node>
+	void classifyChildren(const Frustum& frustum, const std::vector<Node>& nodes, std::uint32_t parent,
+		std::uint8_t parentMask, std::uint8_t* childMasks)
+	{
+		BoundingBox boxes[8];
+		std::size_t nChildren = 0;
+		for (std::uint8_t mask = nodes[parent].childMask; mask != 0; mask &= mask - 1)
+		{
+			boxes[nChildren] = nodes[nodes[parent].firstChild + nChildren].bounds;
+			++nChildren;
+		}
+		firstPlanes[parent] = static_cast<std::uint8_t>(
+			classifyBoxes(frustum, boxes, nChildren, parentMask, firstPlanes[parent], childMasks));
+	}
+
+	//Conservative list of the octree's vertex ranges inside the frustum, sorted with adjacent ranges merged.
+	//Subtrees entirely inside are taken as one range without visiting them, since they are contiguous.
+	//The result is valid until the next call.
+	const std::vector<DrawRange>& cull(const Octree& octree, const Frustum& frustum);
+};
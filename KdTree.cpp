@@ -0,0 +1,263 @@
+#include "KdTree.h"
+#include "Bounds.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCV_KDTREE_SSE2
+#include <xmmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr std::size_t kdPointsPerTask = 1 << 16;
+    constexpr std::size_t kdQueriesPerTask = 1 << 10;
+    constexpr std::size_t kdLanes = 4;
+
+    struct KdPoint
+    {
+        float position[3];
+        std::uint32_t id;
+    };
+
+    //Calls visit(lane) for every lane of the four points at coordinates[.][first] that is before end and whose
+    //squared distance to query is at most bound, passing that distance. bound may shrink between calls.
+    template<typename Visit>
+    void scanLanes(const std::vector<float>* coordinates, std::uint64_t first, std::uint64_t end, const float query[3],
+        const float& bound, Visit&& visit)
+    {
+        int valid = (1 << std::min<std::uint64_t>(end - first, kdLanes)) - 1;
+#if defined(PCV_KDTREE_SSE2)
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(coordinates[0].data() + first), _mm_set1_ps(query[0]));
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(coordinates[1].data() + first), _mm_set1_ps(query[1]));
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(coordinates[2].data() + first), _mm_set1_ps(query[2]));
+        __m128 squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        int inside = _mm_movemask_ps(_mm_cmple_ps(squared, _mm_set1_ps(bound))) & valid;
+        if (inside == 0)
+            return;
+        alignas(16) float distances[kdLanes];
+        _mm_store_ps(distances, squared);
+#else
+        float distances[kdLanes];
+        int inside = 0;
+        for (std::size_t lane = 0; lane < kdLanes; ++lane)
+        {
+            float dx = coordinates[0][first + lane] - query[0];
+            float dy = coordinates[1][first + lane] - query[1];
+            float dz = coordinates[2][first + lane] - query[2];
+            distances[lane] = dx * dx + dy * dy + dz * dz;
+            if (distances[lane] <= bound)
+                inside |= 1 << lane;
+        }
+        inside &= valid;
+#endif
+        for (std::size_t lane = 0; lane < kdLanes; ++lane)
+        {
+            //Re-checked because visiting an earlier lane can tighten the bound
+            if ((inside & (1 << lane)) && distances[lane] <= bound)
+                visit(lane, distances[lane]);
+        }
+    }
+}
+
+std::uint64_t KdTree::pointsBefore(std::uint64_t node, unsigned int depth) const
+{
+    //Node j of a level with 2^depth nodes starts at floor(j * n / 2^depth), so each node splits exactly at the point
+    //its two children's ranges meet
+    return node * nPoints >> depth;
+}
+
+template<typename LeafScan>
+void KdTree::searchLeaves(const float query[3], float& bound, LeafScan&& scan) const
+{
+    struct Pending
+    {
+        std::uint64_t node;
+        unsigned int depth;
+        float distance; //No point below the node is nearer to the query than this, squared
+    };
+    //Every step down pushes at most one sibling
+    Pending stack[64];
+    std::size_t nPending = 0;
+    stack[nPending++] = { 0, 0, 0.0f };
+    while (nPending != 0)
+    {
+        Pending pending = stack[--nPending];
+        if (pending.distance > bound)
+            continue;
+        //Down to the leaf on the query's side, leaving the far sides for later
+        std::uint64_t node = pending.node;
+        for (unsigned int depth = pending.depth; depth < leafDepth; ++depth)
+        {
+            const Split& split = splits[node];
+            float offset = query[split.axis] - split.value;
+            std::uint64_t nearChild = 2 * node + (offset < 0.0f ? 1 : 2);
+            float farDistance = std::max(pending.distance, offset * offset);
+            if (farDistance <= bound)
+                stack[nPending++] = { 4 * node + 3 - nearChild, depth + 1, farDistance };
+            node = nearChild;
+        }
+        std::uint64_t leaf = node - ((std::uint64_t(1) << leafDepth) - 1);
+        scan(pointsBefore(leaf, leafDepth), pointsBefore(leaf + 1, leafDepth));
+    }
+}
+
+void KdTree::nearest(const XMFLOAT3& position, unsigned int k, std::uint32_t* indices, float* squaredDistances) const
+{
+    if (k == 0)
+        return;
+    std::fill(indices, indices + k, kdNoNeighbour);
+    std::fill(squaredDistances, squaredDistances + k, std::numeric_limits<float>::infinity());
+    float query[3] = { position.x, position.y, position.z };
+    //The kth nearest so far, nothing further away can enter the list
+    float bound = std::numeric_limits<float>::infinity();
+    searchLeaves(query, bound, [&](std::uint64_t begin, std::uint64_t end) {
+        for (std::uint64_t first = begin; first < end; first += kdLanes)
+        {
+            scanLanes(coordinates, first, end, query, bound, [&](std::size_t lane, float distance) {
+                if (distance >= squaredDistances[k - 1])
+                    return;
+                //Insertion into the sorted list, k is small
+                unsigned int slot = k - 1;
+                for (; slot > 0 && squaredDistances[slot - 1] > distance; --slot)
+                {
+                    squaredDistances[slot] = squaredDistances[slot - 1];
+                    indices[slot] = indices[slot - 1];
+                }
+                squaredDistances[slot] = distance;
+                indices[slot] = ids[first + lane];
+                bound = squaredDistances[k - 1];
+            });
+        }
+    });
+}
+
+void KdTree::withinRadius(const XMFLOAT3& position, float radius, std::vector<std::uint32_t>& indices) const
+{
+    float query[3] = { position.x, position.y, position.z };
+    float bound = radius * radius;
+    searchLeaves(query, bound, [&](std::uint64_t begin, std::uint64_t end) {
+        for (std::uint64_t first = begin; first < end; first += kdLanes)
+        {
+            scanLanes(coordinates, first, end, query, bound, [&](std::size_t lane, float) {
+                indices.push_back(ids[first + lane]);
+            });
+        }
+    });
+}
+
+void KdTree::nearest(const XMFLOAT3* queries, std::size_t nQueries, unsigned int k, std::uint32_t* indices,
+    float* squaredDistances) const
+{
+    std::size_t nTasks = (nQueries + kdQueriesPerTask - 1) / kdQueriesPerTask;
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * kdQueriesPerTask, nQueries);
+        for (std::size_t i = task * kdQueriesPerTask; i < end; ++i)
+            nearest(queries[i], k, indices + i * k, squaredDistances + i * k);
+    });
+}
+
+RadiusNeighbours KdTree::withinRadius(const XMFLOAT3* queries, std::size_t nQueries, float radius) const
+{
+    //Each task gathers its queries' neighbours on its own, then they are copied out behind a prefix sum of the counts
+    RadiusNeighbours neighbours;
+    neighbours.offsets.assign(nQueries + 1, 0);
+    std::size_t nTasks = (nQueries + kdQueriesPerTask - 1) / kdQueriesPerTask;
+    std::vector<std::vector<std::uint32_t>> taskIndices(nTasks);
+    ThreadPool& pool = ThreadPool::shared();
+    pool.parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * kdQueriesPerTask, nQueries);
+        for (std::size_t i = task * kdQueriesPerTask; i < end; ++i)
+        {
+            std::size_t before = taskIndices[task].size();
+            withinRadius(queries[i], radius, taskIndices[task]);
+            neighbours.offsets[i + 1] = taskIndices[task].size() - before;
+        }
+    });
+    for (std::size_t i = 0; i < nQueries; ++i)
+        neighbours.offsets[i + 1] += neighbours.offsets[i];
+    neighbours.indices.resize(neighbours.offsets[nQueries]);
+    pool.parallelFor(nTasks, [&](std::size_t task) {
+        std::copy(taskIndices[task].begin(), taskIndices[task].end(),
+            neighbours.indices.begin() + neighbours.offsets[task * kdQueriesPerTask]);
+        taskIndices[task] = std::vector<std::uint32_t>();
+    });
+    return neighbours;
+}
+
+std::unique_ptr<KdTree> buildKdTree(const PointCloudVertex* vertices, std::size_t nVertices, std::size_t maxLeafPoints)
+{
+    if (nVertices >= kdNoNeighbour)
+        return nullptr;
+    auto tree = std::make_unique<KdTree>();
+    tree->nPoints = nVertices;
+    //The shallowest depth at which the largest leaf fits. Every inner node then has at least two points, so its
+    //median splits it into two non-empty halves.
+    std::uint64_t leafSize = std::max<std::size_t>(maxLeafPoints, 2);
+    while (((nVertices + (std::uint64_t(1) << tree->leafDepth) - 1) >> tree->leafDepth) > leafSize)
+        ++tree->leafDepth;
+    ThreadPool& pool = ThreadPool::shared();
+    std::size_t nTasks = (nVertices + kdPointsPerTask - 1) / kdPointsPerTask;
+
+    std::vector<KdPoint> points(nVertices);
+    pool.parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * kdPointsPerTask, nVertices);
+        for (std::size_t i = task * kdPointsPerTask; i < end; ++i)
+            points[i] = { { vertices[i].modelPos.x, vertices[i].modelPos.y, vertices[i].modelPos.z }, static_cast<std::uint32_t>(i) };
+    });
+
+    //Cells only pick the split axis: the bounds at the root, below it the parent's cell cut at its split
+    std::vector<BoundingBox> cells(1), childCells;
+    if (nVertices != 0)
+        cells[0] = calculateBounds(vertices, nVertices).box;
+    tree->splits.resize((std::size_t(1) << tree->leafDepth) - 1);
+    for (unsigned int depth = 0; depth < tree->leafDepth; ++depth)
+    {
+        std::size_t nNodes = std::size_t(1) << depth;
+        std::size_t firstNode = nNodes - 1;
+        childCells.resize(2 * nNodes);
+        //Deep levels have many small nodes, so several share a task
+        std::size_t nodesPerTask = std::max<std::size_t>(kdPointsPerTask / std::max<std::size_t>(nVertices >> depth, 1), 1);
+        pool.parallelFor((nNodes + nodesPerTask - 1) / nodesPerTask, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * nodesPerTask, nNodes);
+            for (std::size_t node = task * nodesPerTask; node < end; ++node)
+            {
+                const BoundingBox& cell = cells[node];
+                float extent[3] = { cell.max.x - cell.min.x, cell.max.y - cell.min.y, cell.max.z - cell.min.z };
+                std::uint32_t axis = extent[0] >= extent[1] ? (extent[0] >= extent[2] ? 0 : 2) : (extent[1] >= extent[2] ? 1 : 2);
+                KdPoint* begin = points.data() + tree->pointsBefore(node, depth);
+                KdPoint* middle = points.data() + tree->pointsBefore(2 * node + 1, depth + 1);
+                KdPoint* last = points.data() + tree->pointsBefore(node + 1, depth);
+                std::nth_element(begin, middle, last, [axis](const KdPoint& a, const KdPoint& b) {
+                    return a.position[axis] < b.position[axis];
+                });
+                float value = middle->position[axis];
+                tree->splits[firstNode + node] = { value, axis };
+                BoundingBox left = cell, right = cell;
+                (&left.max.x)[axis] = value;
+                (&right.min.x)[axis] = value;
+                childCells[2 * node] = left;
+                childCells[2 * node + 1] = right;
+            }
+        });
+        std::swap(cells, childCells);
+    }
+
+    for (std::vector<float>& axis : tree->coordinates)
+        axis.resize(nVertices + kdLanes - 1);
+    tree->ids.resize(nVertices);
+    pool.parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * kdPointsPerTask, nVertices);
+        for (std::size_t i = task * kdPointsPerTask; i < end; ++i)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+                tree->coordinates[axis][i] = points[i].position[axis];
+            tree->ids[i] = points[i].id;
+        }
+    });
+    return tree;
+}
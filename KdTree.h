@@ -0,0 +1,73 @@
+#pragma once
+#include "PointCloudVertex.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+//Leaves hold between about half and all of this many points, scanned four at a time.
+constexpr std::size_t defaultKdLeafSize = 32;
+//Neighbour slots a query couldn't fill, because the tree has fewer than k points, hold this index.
+constexpr std::uint32_t kdNoNeighbour = std::numeric_limits<std::uint32_t>::max();
+
+//Neighbours of a batch of radius queries: those of query i are indices[offsets[i], offsets[i + 1]).
+struct RadiusNeighbours
+{
+	std::vector<std::uint64_t> offsets;
+	std::vector<std::uint32_t> indices;
+};
+
+//Balanced kd-tree over point positions for nearest neighbour and radius queries.
+//Every node splits its points in half at the median along the widest axis of its cell, and all leaves sit at the same
+//depth, so the tree is complete and stored implicitly: node i's children are 2i + 1 and 2i + 2, and each node's points
+//are a range of the tree order computed from its index. Inner nodes keep only their split, so the top of the tree
+//stays in cache, and the points are stored as one coordinate array per axis in tree order so leaves are scanned with
+//SIMD. Indices returned by queries are those of the vertices the tree was built from.
+//Queries are const and may run on any number of threads at once.
+class KdTree
+{
+	struct Split
+	{
+		float value; //Points in the left child are at most this along axis, those in the right at least
+		std::uint32_t axis;
+	};
+
+	std::size_t nPoints = 0;
+	unsigned int leafDepth = 0; //Depth of every leaf, the root is at 0
+	std::vector<Split> splits; //The inner nodes, 2^leafDepth - 1 of them
+	std::vector<float> coordinates[3]; //Tree order, padded so a leaf's last four points can always be loaded
+	std::vector<std::uint32_t> ids; //Vertex index of each point in tree order
+
+	std::uint64_t pointsBefore(std::uint64_t node, unsigned int depth) const;
+	template<typename LeafScan>
+	void searchLeaves(const float query[3], float& bound, LeafScan&& scan) const;
+
+	friend std::unique_ptr<KdTree> buildKdTree(const PointCloudVertex* vertices, std::size_t nVertices,
+		std::size_t maxLeafPoints);
+
+public:
+	std::size_t size() const { return nPoints; }
+	//Vertex index of each point in tree order. Querying every point in this order keeps consecutive queries in the
+	//same leaves.
+	const std::vector<std::uint32_t>& treeOrder() const { return ids; }
+
+	//Writes the k nearest points to position, nearest first, as vertex indices and squared distances. A query at one
+	//of the tree's own points finds that point first.
+	void nearest(const DirectX::XMFLOAT3& position, unsigned int k, std::uint32_t* indices, float* squaredDistances) const;
+	//Appends the vertex index of every point within radius of position, in no particular order.
+	void withinRadius(const DirectX::XMFLOAT3& position, float radius, std::vector<std::uint32_t>& indices) const;
+
+	//Batched forms on the shared thread pool. Row i of indices and squaredDistances, k entries each, holds the
+	//neighbours of queries[i]. Queries close together in memory that are also close in space, such as a cloud sorted
+	//along a curve, share the nodes they visit in cache.
+	void nearest(const DirectX::XMFLOAT3* queries, std::size_t nQueries, unsigned int k, std::uint32_t* indices,
+		float* squaredDistances) const;
+	RadiusNeighbours withinRadius(const DirectX::XMFLOAT3* queries, std::size_t nQueries, float radius) const;
+};
+
+//Builds the tree one level at a time, each level's nodes partitioned in parallel with nth_element. Clouds of
+//2^32 - 1 points or more can't be indexed with 32 bits and return nullptr.
+std::unique_ptr<KdTree> buildKdTree(const PointCloudVertex* vertices, std::size_t nVertices,
+	std::size_t maxLeafPoints = defaultKdLeafSize);
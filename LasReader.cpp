@@ -0,0 +1,187 @@
+#include "LasReader.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCV_LAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr std::size_t lasRecordsPerTask = 1 << 16;
+    constexpr std::size_t legacyHeaderSize = 227;
+    constexpr std::size_t lasHeaderSize14 = 375;
+
+    template<typename T>
+    T readLittleEndian(std::string_view data, std::size_t offset)
+    {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    //Minimum record size and RGB offset for each supported point data record format, 0 meaning unsupported/no RGB
+    bool lasFormatLayout(std::uint8_t format, std::size_t& minimumRecordLength, std::size_t& rgbOffset)
+    {
+        switch (format)
+        {
+        case 0: minimumRecordLength = 20; rgbOffset = 0; return true;
+        case 1: minimumRecordLength = 28; rgbOffset = 0; return true;
+        case 2: minimumRecordLength = 26; rgbOffset = 20; return true;
+        case 3: minimumRecordLength = 34; rgbOffset = 28; return true;
+        case 6: minimumRecordLength = 30; rgbOffset = 0; return true;
+        case 7: minimumRecordLength = 36; rgbOffset = 30; return true;
+        case 8: minimumRecordLength = 38; rgbOffset = 30; return true;
+        default: return false;
+        }
+    }
+
+    //Scaled integer X/Y/Z -> float position. The three int32s are converted and scaled as two double pairs.
+    struct PositionDecoder
+    {
+        double scale[3];
+        double offset[3];
+
+        DirectX::XMFLOAT3 decode(const char* record) const
+        {
+#if defined(PCV_LAS_SSE2)
+            //Records are at least 20 bytes long, so reading 16 from the start is always in bounds
+            __m128i xyz = _mm_loadu_si128(reinterpret_cast<const __m128i*>(record));
+            __m128d xy = _mm_cvtepi32_pd(xyz);
+            __m128d z = _mm_cvtepi32_pd(_mm_shuffle_epi32(xyz, _MM_SHUFFLE(3, 2, 3, 2)));
+            xy = _mm_add_pd(_mm_mul_pd(xy, _mm_loadu_pd(scale)), _mm_loadu_pd(offset));
+            z = _mm_add_sd(_mm_mul_sd(z, _mm_load_sd(&scale[2])), _mm_load_sd(&offset[2]));
+            __m128 position = _mm_movelh_ps(_mm_cvtpd_ps(xy), _mm_cvtpd_ps(z));
+            alignas(16) float components[4];
+            _mm_store_ps(components, position);
+            return DirectX::XMFLOAT3(components[0], components[1], components[2]);
+#else
+            std::int32_t xyz[3];
+            std::memcpy(xyz, record, sizeof(xyz));
+            return DirectX::XMFLOAT3(static_cast<float>(xyz[0] * scale[0] + offset[0]),
+                static_cast<float>(xyz[1] * scale[1] + offset[1]),
+                static_cast<float>(xyz[2] * scale[2] + offset[2]));
+#endif
+        }
+    };
+}
+
+bool parseLasHeader(std::string_view data, LasHeader& header)
+{
+    if (data.size() < legacyHeaderSize || data.substr(0, 4) != "LASF")
+        return false;
+
+    header.versionMajor = readLittleEndian<std::uint8_t>(data, 24);
+    header.versionMinor = readLittleEndian<std::uint8_t>(data, 25);
+    std::uint16_t headerSize = readLittleEndian<std::uint16_t>(data, 94);
+    header.pointDataOffset = readLittleEndian<std::uint32_t>(data, 96);
+    header.pointDataFormat = readLittleEndian<std::uint8_t>(data, 104);
+    header.pointDataRecordLength = readLittleEndian<std::uint16_t>(data, 105);
+    header.nPoints = readLittleEndian<std::uint32_t>(data, 107);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        header.scale[axis] = readLittleEndian<double>(data, 131 + axis * 8);
+        header.offset[axis] = readLittleEndian<double>(data, 155 + axis * 8);
+        header.max[axis] = readLittleEndian<double>(data, 179 + axis * 16);
+        header.min[axis] = readLittleEndian<double>(data, 187 + axis * 16);
+    }
+
+    //LAS 1.4 moved the point count to a 64-bit field, the legacy one is 0 for large files
+    if (header.versionMajor == 1 && header.versionMinor >= 4 && headerSize >= lasHeaderSize14 && data.size() >= lasHeaderSize14)
+    {
+        std::uint64_t nPoints = readLittleEndian<std::uint64_t>(data, 247);
+        if (nPoints != 0)
+            header.nPoints = nPoints;
+    }
+
+    //LASzip marks compressed data by setting the top bits of the format id
+    return header.versionMajor == 1 && (header.pointDataFormat & 0xC0) == 0;
+}
+
+std::unique_ptr<PointCloud> readPointCloudLAS(const std::filesystem::path& path)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return nullptr;
+
+    LasHeader header;
+    if (!parseLasHeader(file.view(), header))
+        return nullptr;
+
+    std::size_t minimumRecordLength, rgbOffset;
+    if (!lasFormatLayout(header.pointDataFormat, minimumRecordLength, rgbOffset) || header.pointDataRecordLength < minimumRecordLength)
+        return nullptr;
+    std::size_t recordLength = header.pointDataRecordLength;
+    if (header.pointDataOffset > file.size() || header.nPoints > (file.size() - header.pointDataOffset) / recordLength)
+        return nullptr;
+
+    //Positions are made relative to the header's minimum corner, folded into the offset so decoding stays one
+    //multiply-add in double. Projected coordinates are in the millions, where float steps are already decimetres.
+    std::array<double, 3> origin;
+    PositionDecoder positionDecoder;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        origin[axis] = std::isfinite(header.min[axis]) ? header.min[axis] : header.offset[axis];
+        positionDecoder.scale[axis] = header.scale[axis];
+        positionDecoder.offset[axis] = header.offset[axis] - origin[axis];
+    }
+
+    std::size_t nPoints = static_cast<std::size_t>(header.nPoints);
+    std::vector<PointCloudVertex> vertices(nPoints);
+    const char* records = file.data() + header.pointDataOffset;
+    std::size_t nTasks = (nPoints + lasRecordsPerTask - 1) / lasRecordsPerTask;
+    std::atomic<std::uint16_t> maxChannel = 0;
+    std::vector<BoundsAccumulator> taskBounds(nTasks);
+
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t begin = task * lasRecordsPerTask;
+        std::size_t end = std::min(begin + lasRecordsPerTask, nPoints);
+        std::uint16_t taskMaxChannel = 0;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const char* record = records + i * recordLength;
+            DirectX::XMFLOAT3 colour(1.0f, 1.0f, 1.0f);
+            if (rgbOffset != 0)
+            {
+                std::uint16_t rgb[3];
+                std::memcpy(rgb, record + rgbOffset, sizeof(rgb));
+                taskMaxChannel = std::max({ taskMaxChannel, rgb[0], rgb[1], rgb[2] });
+                colour = DirectX::XMFLOAT3(rgb[0] / 65535.0f, rgb[1] / 65535.0f, rgb[2] / 65535.0f);
+            }
+            vertices[i] = PointCloudVertex(positionDecoder.decode(record), colour);
+            taskBounds[task].add(vertices[i]);
+        }
+        std::uint16_t currentMax = maxChannel.load();
+        while (taskMaxChannel > currentMax && !maxChannel.compare_exchange_weak(currentMax, taskMaxChannel));
+    });
+
+    //Some writers store 8-bit colour in the 16-bit fields, rescale those so they aren't drawn near black
+    if (rgbOffset != 0 && maxChannel > 0 && maxChannel <= 255)
+    {
+        ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * lasRecordsPerTask, nPoints);
+            for (std::size_t i = task * lasRecordsPerTask; i < end; ++i)
+            {
+                vertices[i].colour.x *= 257.0f;
+                vertices[i].colour.y *= 257.0f;
+                vertices[i].colour.z *= 257.0f;
+            }
+        });
+    }
+
+    BoundsAccumulator bounds;
+    for (const auto& partialBounds : taskBounds)
+        bounds.merge(partialBounds);
+    auto pointCloud = std::make_unique<PointCloud>(std::move(vertices));
+    pointCloud->bounds = bounds.result();
+    pointCloud->origin = origin;
+    return pointCloud;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "PointCloud.h"
+//C++
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+//Fields of the LAS 1.2-1.4 public header block the reader needs.
+struct LasHeader
+{
+	std::uint8_t versionMajor;
+	std::uint8_t versionMinor;
+	std::uint32_t pointDataOffset;
+	std::uint8_t pointDataFormat;
+	std::uint16_t pointDataRecordLength;
+	std::uint64_t nPoints;
+	double scale[3];
+	double offset[3];
+	double min[3];
+	double max[3];
+};
+
+//Parses the public header block at the start of data. Returns false for anything that isn't an uncompressed LAS file.
+bool parseLasHeader(std::string_view data, LasHeader& header);
+
+//Loads point data record formats 0-3 and 6-8. Positions have the header scale and offset applied and are stored
+//relative to the header's minimum corner, which becomes the cloud's origin. 16-bit RGB becomes the colour (white for
+//formats without RGB). Bounds are reduced while decoding rather than trusted from the header extents.
+std::unique_ptr<PointCloud> readPointCloudLAS(const std::filesystem::path& path);
@@ -0,0 +1,230 @@
+#include "LodHierarchy.h"
+#include "Octree.h"
+#include "QuantizedVertex.h"
+#include "RadixSort.h"
+#include "SpaceFillingCurve.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    constexpr std::size_t lodPointsPerTask = 1 << 16;
+    constexpr std::uint32_t unowned = std::numeric_limits<std::uint32_t>::max();
+
+    struct SamplingTask
+    {
+        std::uint32_t node;
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    //Depth of the grid a node at level samples on, capped at the curve grid's resolution.
+    unsigned int samplingDepth(unsigned int level)
+    {
+        return std::min(level + lodSamplingLevels, curveBitsPerAxis);
+    }
+
+    //Points in one sampling cell share every code bit above cellShift, so each cell is one run of sorted codes.
+    //The run lies inside a single octree node, whose range the caller passes as [begin, nodeEnd).
+    std::uint64_t cellEnd(const std::uint64_t* codes, std::uint64_t begin, std::uint64_t nodeEnd, unsigned int cellShift)
+    {
+        std::uint64_t cell = codes[begin] >> cellShift;
+        return static_cast<std::uint64_t>(std::partition_point(codes + begin, codes + nodeEnd,
+            [&](std::uint64_t code) { return code >> cellShift == cell; }) - codes);
+    }
+
+    //Squared distance, in doubled grid units so it stays integral, from a code's grid point to the centre of its cell.
+    std::uint64_t distanceToCellCentre(std::uint64_t code, unsigned int cellShift)
+    {
+        std::int64_t cellSide = std::int64_t(1) << (cellShift / 3);
+        std::uint64_t local = code & ((std::uint64_t(1) << cellShift) - 1);
+        std::uint64_t distance = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            std::int64_t offset = 2 * std::int64_t(compactBitsBy3(local >> axis)) + 1 - cellSide;
+            distance += static_cast<std::uint64_t>(offset * offset);
+        }
+        return distance;
+    }
+
+    //Picks the representatives of the cells starting in [begin, end). Cells holding a point an ancestor already
+    //owns are skipped. The chosen point keeps its colour, the cell's mean goes to meanColours.
+    void sampleCells(const std::uint64_t* codes, const std::vector<PointCloudVertex>& vertices, std::vector<std::uint32_t>& owners,
+        std::vector<std::uint32_t>& meanColours, const SamplingTask& task, std::uint64_t nodeEnd, unsigned int cellShift)
+    {
+        for (std::uint64_t first = task.begin, last; first < task.end; first = last)
+        {
+            last = cellEnd(codes, first, nodeEnd, cellShift);
+            bool represented = false;
+            std::uint64_t closest = first;
+            std::uint64_t closestDistance = std::numeric_limits<std::uint64_t>::max();
+            double colour[3] = {};
+            for (std::uint64_t point = first; point < last && !represented; ++point)
+            {
+                represented = owners[point] != unowned;
+                std::uint64_t distance = distanceToCellCentre(codes[point], cellShift);
+                if (distance < closestDistance)
+                {
+                    closest = point;
+                    closestDistance = distance;
+                }
+                colour[0] += vertices[point].colour.x;
+                colour[1] += vertices[point].colour.y;
+                colour[2] += vertices[point].colour.z;
+            }
+            if (represented)
+                continue;
+
+            double nPoints = static_cast<double>(last - first);
+            owners[closest] = task.node;
+            meanColours[closest] = packColour(DirectX::XMFLOAT3(static_cast<float>(colour[0] / nPoints),
+                static_cast<float>(colour[1] / nPoints), static_cast<float>(colour[2] / nPoints)));
+        }
+    }
+
+    //Splits every inner node of one level into tasks of about lodPointsPerTask points, moving each split forward
+    //to the next cell boundary so no cell is shared by two tasks.
+    std::vector<SamplingTask> splitLevel(const std::uint64_t* codes, const std::vector<OctreeNode>& nodes,
+        std::size_t levelBegin, std::size_t levelEnd, unsigned int cellShift)
+    {
+        std::vector<SamplingTask> tasks;
+        for (std::size_t i = levelBegin; i < levelEnd; ++i)
+        {
+            const OctreeNode& node = nodes[i];
+            if (node.isLeaf())
+                continue;
+            std::uint64_t nodeEnd = node.firstPoint + node.nPoints;
+            for (std::uint64_t begin = node.firstPoint; begin < nodeEnd;)
+            {
+                std::uint64_t end = std::min<std::uint64_t>(begin + lodPointsPerTask, nodeEnd);
+                if (end < nodeEnd)
+                    end = cellEnd(codes, end - 1, nodeEnd, cellShift);
+                tasks.push_back({ static_cast<std::uint32_t>(i), begin, end });
+                begin = end;
+            }
+        }
+        return tasks;
+    }
+
+    //Radix sorts the point indices by owner, then gathers the vertices so each node's points are contiguous.
+    //Inner nodes' points take their coarse colour from meanColours, leaves' points their own.
+    //Octree vertex i came from input vertex sourceIndices[i]. If normals isn't null its normal is normals[sourceIndices[i]],
+    //and they are gathered too. With keepInputOrder the keys are laid out in input order, and the sort being stable keeps
+    //that order within each node.
+    template<typename Index>
+    void groupByOwner(const std::vector<PointCloudVertex>& vertices, const std::uint32_t* normals,
+        const std::vector<std::uint64_t>& sourceIndices, const std::vector<std::uint32_t>& owners,
+        const std::vector<std::uint32_t>& meanColours, bool keepInputOrder, LodHierarchy& hierarchy)
+    {
+        std::vector<LodNode>& nodes = hierarchy.nodes;
+        std::size_t nVertices = vertices.size();
+        std::vector<std::uint64_t> keys(nVertices);
+        std::vector<Index> indices(nVertices);
+        std::size_t nTasks = (nVertices + lodPointsPerTask - 1) / lodPointsPerTask;
+        ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * lodPointsPerTask, nVertices);
+            for (std::size_t i = task * lodPointsPerTask; i < end; ++i)
+            {
+                std::size_t slot = keepInputOrder ? static_cast<std::size_t>(sourceIndices[i]) : i;
+                keys[slot] = owners[i];
+                indices[slot] = static_cast<Index>(i);
+            }
+        });
+        radixSortPairs(keys, indices);
+
+        ThreadPool::shared().parallelFor(nodes.size(), [&](std::size_t i) {
+            auto owned = std::equal_range(keys.begin(), keys.end(), static_cast<std::uint64_t>(i));
+            nodes[i].firstPoint = static_cast<std::uint64_t>(owned.first - keys.begin());
+            nodes[i].nPoints = static_cast<std::uint64_t>(owned.second - owned.first);
+        });
+
+        std::vector<PointCloudVertex> grouped(nVertices);
+        hierarchy.coarseColours.resize(nVertices);
+        hierarchy.normals.resize(normals ? nVertices : 0);
+        ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * lodPointsPerTask, nVertices);
+            for (std::size_t i = task * lodPointsPerTask; i < end; ++i)
+            {
+                grouped[i] = vertices[indices[i]];
+                hierarchy.coarseColours[i] = nodes[keys[i]].isLeaf() ? packColour(grouped[i].colour) : meanColours[indices[i]];
+            }
+            if (normals)
+            {
+                for (std::size_t i = task * lodPointsPerTask; i < end; ++i)
+                    hierarchy.normals[i] = normals[sourceIndices[indices[i]]];
+            }
+        });
+        hierarchy.vertices = VertexArray(std::move(grouped));
+    }
+}
+
+std::unique_ptr<LodHierarchy> buildLodHierarchy(const PointCloudVertex* vertices, std::size_t nVertices,
+    const BoundingBox& box, const std::uint32_t* normals, std::size_t maxLeafPoints, bool keepInputOrder)
+{
+    std::vector<std::uint64_t> codes;
+    //The octree only sorts vertices, normals and the input order are looked up through where each vertex came from
+    std::vector<std::uint64_t> sourceIndices;
+    std::unique_ptr<Octree> octree = buildOctree(vertices, nVertices, box, maxLeafPoints, &codes,
+        normals || keepInputOrder ? &sourceIndices : nullptr);
+    auto hierarchy = std::make_unique<LodHierarchy>();
+    hierarchy->cube = octree->cube;
+    if (nVertices == 0)
+        return hierarchy;
+
+    //Top down, so a cell only gets a representative if no ancestor already has one inside it.
+    //Nodes of one level cover disjoint ranges, and their cells disjoint runs, so a level's tasks never overlap.
+    const std::vector<OctreeNode>& octreeNodes = octree->nodes;
+    std::vector<std::uint32_t> owners(nVertices, unowned);
+    std::vector<std::uint32_t> meanColours(nVertices); //Only set for representatives
+    for (std::size_t levelBegin = 0, levelEnd; levelBegin < octreeNodes.size(); levelBegin = levelEnd)
+    {
+        unsigned int level = octreeNodes[levelBegin].level;
+        for (levelEnd = levelBegin; levelEnd < octreeNodes.size() && octreeNodes[levelEnd].level == level;)
+            ++levelEnd;
+        unsigned int cellShift = 3 * (curveBitsPerAxis - samplingDepth(level));
+        std::vector<SamplingTask> tasks = splitLevel(codes.data(), octreeNodes, levelBegin, levelEnd, cellShift);
+        ThreadPool::shared().parallelFor(tasks.size(), [&](std::size_t i) {
+            const OctreeNode& node = octreeNodes[tasks[i].node];
+            sampleCells(codes.data(), octree->vertices, owners, meanColours, tasks[i], node.firstPoint + node.nPoints, cellShift);
+        });
+    }
+    codes = std::vector<std::uint64_t>();
+
+    //Leaves own every point sampling left them
+    std::vector<std::uint32_t> leaves;
+    for (std::size_t i = 0; i < octreeNodes.size(); ++i)
+    {
+        if (octreeNodes[i].isLeaf())
+            leaves.push_back(static_cast<std::uint32_t>(i));
+    }
+    ThreadPool::shared().parallelFor(leaves.size(), [&](std::size_t i) {
+        const OctreeNode& leaf = octreeNodes[leaves[i]];
+        for (std::uint64_t point = leaf.firstPoint; point < leaf.firstPoint + leaf.nPoints; ++point)
+        {
+            if (owners[point] == unowned)
+                owners[point] = leaves[i];
+        }
+    });
+
+    float cubeSide = hierarchy->cube.max.x - hierarchy->cube.min.x;
+    std::vector<LodNode>& nodes = hierarchy->nodes;
+    nodes.resize(octreeNodes.size());
+    for (std::size_t i = 0; i < octreeNodes.size(); ++i)
+    {
+        const OctreeNode& node = octreeNodes[i];
+        nodes[i].bounds = node.bounds;
+        nodes[i].firstChild = node.firstChild;
+        nodes[i].childMask = node.childMask;
+        nodes[i].level = node.level;
+        nodes[i].spacing = cubeSide / static_cast<float>(1u << samplingDepth(node.level));
+    }
+
+    //32-bit indices halve the sort's traffic whenever they are wide enough
+    if (nVertices <= std::numeric_limits<std::uint32_t>::max())
+        groupByOwner<std::uint32_t>(octree->vertices, normals, sourceIndices, owners, meanColours, keepInputOrder, *hierarchy);
+    else
+        groupByOwner<std::uint64_t>(octree->vertices, normals, sourceIndices, owners, meanColours, keepInputOrder, *hierarchy);
+    return hierarchy;
+}
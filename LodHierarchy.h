@@ -0,0 +1,54 @@
+#pragma once
+#include "PointCloudVertex.h"
+#include "VertexArray.h"
+#include "Bounds.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//An inner node samples its subtree on a grid this many levels below it, so with up to 128 cells per axis.
+constexpr unsigned int lodSamplingLevels = 7;
+//Octree nodes with more points than this are split, the leaves then own whatever sampling left them.
+constexpr std::size_t defaultLodLeafSize = 1 << 14;
+
+struct LodNode
+{
+	BoundingBox bounds; //Tight around every point in the node's subtree
+	std::uint64_t firstPoint; //The points the node owns are vertices[firstPoint, firstPoint + nPoints)
+	std::uint64_t nPoints;
+	std::uint32_t firstChild; //Children are stored consecutively, in octant order
+	std::uint8_t childMask; //Bit i is set if octant i (x in bit 0, y in bit 1, z in bit 2) has a child
+	std::uint8_t level; //0 for the root
+	float spacing; //Side of the node's sampling cells. Leaves own every remaining point, so they are at least this dense
+
+	bool isLeaf() const { return childMask == 0; }
+};
+
+//Additive (nested octree) level of detail. Every inner node owns one representative for each occupied cell of its
+//sampling grid that no ancestor already represents: the point nearest the cell centre, as it was loaded.
+//The cell's mean colour is kept beside it, for drawing the node while it stands in for children that aren't drawn.
+//Children own the rest. Drawing a node together with all of its ancestors therefore shows its region with one point
+//per occupied cell, so any cut containing the root is a valid rendering, and drawing every node draws each input
+//point exactly once.
+struct LodHierarchy
+{
+	BoundingBox cube; //Root cell
+	std::vector<LodNode> nodes; //Breadth first, nodes[0] is the root
+	VertexArray vertices; //Grouped by owning node, in node order. A cached hierarchy views them in the cache file.
+	std::vector<std::uint32_t> normals; //Octahedral encoded, parallel to vertices, empty if the input had none
+	//Packed (see packColour), parallel to vertices. Mean of the represented cell for an inner node's points, a leaf's
+	//points' own colour.
+	std::vector<std::uint32_t> coarseColours;
+};
+
+//Builds a Morton octree (see buildOctree), samples it level by level from the root down and then groups the
+//points by owner with a radix sort. Every stage runs on the shared thread pool and splits its work independently
+//of the thread count, so the result is deterministic. box must contain every vertex.
+//normals may be null, otherwise it holds one octahedral encoded normal per vertex, which is carried along.
+//A node's points follow the octree's Morton order, or their order in vertices if keepInputOrder is set, which keeps
+//a cloud already sorted along another curve (see reorderAlongCurve) in that order within every node.
+std::unique_ptr<LodHierarchy> buildLodHierarchy(const PointCloudVertex* vertices, std::size_t nVertices,
+	const BoundingBox& box, const std::uint32_t* normals = nullptr, std::size_t maxLeafPoints = defaultLodLeafSize,
+	bool keepInputOrder = false);
@@ -0,0 +1,112 @@
+#include "LodTraversal.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr std::uint32_t noParent = std::numeric_limits<std::uint32_t>::max();
+
+    //Turns world sizes at a clip space w into pixels. w is the view depth for a perspective MVP.
+    struct ScreenProjection
+    {
+        XMFLOAT4 depthRow; //Clip w as a function of the model position
+        float depthScale; //How much w changes per unit of model space distance
+        float pixelsPerUnit; //At w = 1
+
+        ScreenProjection(const LodView& view)
+        {
+            XMFLOAT4X4 mvp;
+            XMStoreFloat4x4(&mvp, view.MVP);
+            depthRow = XMFLOAT4(mvp.m[0][3], mvp.m[1][3], mvp.m[2][3], mvp.m[3][3]);
+            depthScale = std::sqrt(depthRow.x * depthRow.x + depthRow.y * depthRow.y + depthRow.z * depthRow.z);
+            pixelsPerUnit = 0.5f * static_cast<float>(view.rtvHeight) / std::tan(XMConvertToRadians(view.FOV) * 0.5f);
+        }
+
+        //Pixels per unit at the nearest depth of the sphere. A sphere reaching the eye plane is treated as
+        //filling the screen.
+        float nearestScale(const BoundingBox& bounds, float& radius) const
+        {
+            float centre[3] = { (bounds.min.x + bounds.max.x) * 0.5f, (bounds.min.y + bounds.max.y) * 0.5f,
+                (bounds.min.z + bounds.max.z) * 0.5f };
+            float extent[3] = { bounds.max.x - centre[0], bounds.max.y - centre[1], bounds.max.z - centre[2] };
+            radius = std::sqrt(extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]);
+            float nearestDepth = depthRow.x * centre[0] + depthRow.y * centre[1] + depthRow.z * centre[2] + depthRow.w
+                - radius * depthScale;
+            if (nearestDepth <= 0.0f)
+                return std::numeric_limits<float>::max();
+            return pixelsPerUnit / nearestDepth;
+        }
+    };
+}
+
+const std::vector<DrawRange>& LodTraversal::select(const std::vector<LodNode>& nodes, const LodView& view,
+    std::uint64_t pointBudget, float minimumProjectedSpacing)
+{
+    ranges.clear();
+    selected.clear();
+    nodeRanges.clear();
+    candidates.clear();
+    nSelectedPoints = 0;
+    if (nodes.empty())
+        return ranges;
+
+    ScreenProjection projection(view);
+    Frustum frustum = extractFrustum(view.MVP);
+    auto push = [&](std::uint32_t node, std::uint32_t parentSelection, std::uint8_t planeMask) {
+        if (planeMask == outsideFrustum)
+            return;
+        float radius;
+        float scale = projection.nearestScale(nodes[node].bounds, radius);
+        candidates.push_back({ std::min(radius * scale, std::numeric_limits<float>::max()), node, parentSelection, planeMask });
+        std::push_heap(candidates.begin(), candidates.end());
+    };
+    push(0, noParent, culler.classifyRoot(frustum, nodes[0].bounds, nodes.size()));
+
+    while (!candidates.empty())
+    {
+        std::pop_heap(candidates.begin(), candidates.end());
+        Candidate candidate = candidates.back();
+        const LodNode& node = nodes[candidate.node];
+        candidates.pop_back();
+        //The root is always drawn, a budget below it would otherwise show nothing. Later nodes that don't fit are
+        //passed over with their subtrees, while smaller ones further down the queue may still fill the budget.
+        if (candidate.parentSelection != noParent && nSelectedPoints + node.nPoints > pointBudget)
+            continue;
+
+        nSelectedPoints += node.nPoints;
+        std::uint32_t selection = static_cast<std::uint32_t>(selected.size());
+        selected.push_back(candidate.node);
+        nodeRanges.push_back({ node.firstPoint, node.nPoints, !node.isLeaf() });
+        //With a child drawn the parent's points stand for themselves again, not for that child's cells
+        if (candidate.parentSelection != noParent)
+            nodeRanges[candidate.parentSelection].coarse = false;
+
+        float radius;
+        if (node.isLeaf() || node.spacing * projection.nearestScale(node.bounds, radius) < minimumProjectedSpacing)
+            continue;
+        //Children of a node entirely inside the frustum are too, so only straddling nodes test theirs
+        std::uint8_t childMasks[8] = {};
+        if (candidate.planeMask != 0)
+            culler.classifyChildren(frustum, nodes, candidate.node, candidate.planeMask, childMasks);
+        std::uint32_t nChildren = 0;
+        for (std::uint8_t mask = node.childMask; mask != 0; mask &= mask - 1)
+            ++nChildren;
+        for (std::uint32_t child = 0; child < nChildren; ++child)
+            push(node.firstChild + child, selection, childMasks[child]);
+        if (nSelectedPoints >= pointBudget)
+            break;
+    }
+
+    //Siblings own consecutive ranges, so sorting lets most of the selection merge into a few draws
+    for (const DrawRange& range : nodeRanges)
+    {
+        if (range.nVertices != 0)
+            ranges.push_back(range);
+    }
+    sortAndMergeRanges(ranges);
+    return ranges;
+}
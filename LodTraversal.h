@@ -0,0 +1,61 @@
+#pragma once
+#include "LodHierarchy.h"
+#include "FrustumCulling.h"
+#include "VertexSegments.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Points drawn per frame unless configured otherwise.
+constexpr std::uint64_t defaultPointBudget = 10'000'000;
+//Nodes whose sampling cells project smaller than this many pixels aren't refined, their children would add no detail.
+constexpr float defaultMinimumProjectedSpacing = 1.0f;
+
+//Camera state the traversal projects node bounds with.
+struct LodView
+{
+	DirectX::XMMATRIX MVP; //Row vector convention, as produced by recaculateMVP
+	float FOV; //Vertical, in degrees
+	unsigned int rtvHeight; //Pixels
+};
+
+//Per frame cut through a LodHierarchy. Nodes are visited largest on screen first, from a priority queue seeded
+//with the root. The root is always selected; every other node that still fits in the point budget is selected too,
+//and each selected node queues the children that aren't culled by the view frustum. A node that doesn't fit is
+//skipped with its subtree and the traversal goes on with the rest of the queue.
+//Every selected node's ancestors are therefore selected too, so the cut is always a valid rendering.
+//Inner nodes none of whose children are selected stand in for them, so they are drawn with their coarse colours.
+//Only selected nodes and their children are touched, so the cost follows the budget rather than the cloud's size.
+class LodTraversal
+{
+	struct Candidate
+	{
+		float priority; //Projected bounding radius, in pixels
+		std::uint32_t node;
+		std::uint32_t parentSelection; //Index of the parent in selected, noParent for the root
+		std::uint8_t planeMask; //Frustum planes the node straddles
+
+		bool operator<(const Candidate& other) const { return priority < other.priority; }
+	};
+
+	std::vector<Candidate> candidates; //Heap storage, kept so a frame doesn't allocate
+	std::vector<DrawRange> ranges;
+	std::vector<std::uint32_t> selected;
+	std::vector<DrawRange> nodeRanges; //Parallel to selected
+	std::uint64_t nSelectedPoints = 0;
+	FrustumCuller culler;
+
+public:
+	//Selects the root and then every node that still fits in pointBudget, and returns their points as ranges over the
+	//hierarchy's vertices, sorted and with adjacent ranges merged. Only a root larger than pointBudget exceeds it.
+	//The result is valid until the next call.
+	const std::vector<DrawRange>& select(const std::vector<LodNode>& nodes, const LodView& view,
+		std::uint64_t pointBudget = defaultPointBudget, float minimumProjectedSpacing = defaultMinimumProjectedSpacing);
+
+	std::uint64_t selectedPoints() const { return nSelectedPoints; }
+	//Nodes chosen by the last select, in the order they were selected.
+	const std::vector<std::uint32_t>& selectedNodes() const { return selected; }
+	//The points of each of selectedNodes(), marked coarse unless it is a leaf or one of its children was selected too.
+	const std::vector<DrawRange>& selectedRanges() const { return nodeRanges; }
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+//Read-only memory mapping of a whole file.
+//Uses CreateFileMapping/MapViewOfFile on Windows and mmap elsewhere so the loaders stay portable.
+class MappedFile
+{
+	const char* mappedData = nullptr;
+	std::size_t mappedSize = 0;
+#if defined(_WIN32)
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fileDescriptor = -1;
+#endif
+
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	//Returns false if the file could not be opened or mapped. Empty files map to an empty view.
+	bool open(const std::filesystem::path& path);
+	void close();
+
+	bool isOpen() const;
+	const char* data() const { return mappedData; }
+	std::size_t size() const { return mappedSize; }
+	std::string_view view() const { return std::string_view(mappedData, mappedSize); }
+};
@@ -0,0 +1,196 @@
+#include "NormalEstimation.h"
+#include "KdTree.h"
+#include "OctahedralNormal.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCV_NORMALS_SSE2
+#include <xmmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr std::size_t normalPointsPerTask = 1 << 14;
+    constexpr std::size_t normalLanes = 4;
+    //Each sweep roughly squares the off-diagonal error, from float rounding on four is enough for covariances
+    constexpr int jacobiSweeps = 4;
+
+    //One float per point of a batch, so the eigen solve below reads as scalar code
+#if defined(PCV_NORMALS_SSE2)
+    struct Lanes { __m128 v; };
+    struct Mask { __m128 m; };
+    Lanes load(const float* values) { return { _mm_loadu_ps(values) }; }
+    void store(float* values, Lanes a) { _mm_storeu_ps(values, a.v); }
+    Lanes splat(float value) { return { _mm_set1_ps(value) }; }
+    Lanes operator+(Lanes a, Lanes b) { return { _mm_add_ps(a.v, b.v) }; }
+    Lanes operator-(Lanes a, Lanes b) { return { _mm_sub_ps(a.v, b.v) }; }
+    Lanes operator*(Lanes a, Lanes b) { return { _mm_mul_ps(a.v, b.v) }; }
+    Lanes operator/(Lanes a, Lanes b) { return { _mm_div_ps(a.v, b.v) }; }
+    Lanes squareRoot(Lanes a) { return { _mm_sqrt_ps(a.v) }; }
+    Lanes absolute(Lanes a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+    Mask operator<(Lanes a, Lanes b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+    Lanes select(Mask mask, Lanes a, Lanes b) { return { _mm_or_ps(_mm_and_ps(mask.m, a.v), _mm_andnot_ps(mask.m, b.v)) }; }
+#else
+    struct Lanes { float v[normalLanes]; };
+    struct Mask { bool m[normalLanes]; };
+    template<typename Op>
+    Lanes perLane(Op&& op)
+    {
+        Lanes result;
+        for (std::size_t lane = 0; lane < normalLanes; ++lane)
+            result.v[lane] = op(lane);
+        return result;
+    }
+    Lanes load(const float* values) { return perLane([&](std::size_t i) { return values[i]; }); }
+    void store(float* values, Lanes a) { std::copy(a.v, a.v + normalLanes, values); }
+    Lanes splat(float value) { return perLane([&](std::size_t) { return value; }); }
+    Lanes operator+(Lanes a, Lanes b) { return perLane([&](std::size_t i) { return a.v[i] + b.v[i]; }); }
+    Lanes operator-(Lanes a, Lanes b) { return perLane([&](std::size_t i) { return a.v[i] - b.v[i]; }); }
+    Lanes operator*(Lanes a, Lanes b) { return perLane([&](std::size_t i) { return a.v[i] * b.v[i]; }); }
+    Lanes operator/(Lanes a, Lanes b) { return perLane([&](std::size_t i) { return a.v[i] / b.v[i]; }); }
+    Lanes squareRoot(Lanes a) { return perLane([&](std::size_t i) { return std::sqrt(a.v[i]); }); }
+    Lanes absolute(Lanes a) { return perLane([&](std::size_t i) { return std::fabs(a.v[i]); }); }
+    Mask operator<(Lanes a, Lanes b)
+    {
+        Mask mask;
+        for (std::size_t lane = 0; lane < normalLanes; ++lane)
+            mask.m[lane] = a.v[lane] < b.v[lane];
+        return mask;
+    }
+    Lanes select(Mask mask, Lanes a, Lanes b) { return perLane([&](std::size_t i) { return mask.m[i] ? a.v[i] : b.v[i]; }); }
+#endif
+
+    //Jacobi rotation zeroing a[p][q], accumulated into the eigenvector columns of v
+    void rotate(Lanes a[3][3], Lanes v[3][3], int p, int q)
+    {
+        int r = 3 - p - q;
+        Lanes apq = a[p][q], app = a[p][p], aqq = a[q][q], arp = a[r][p], arq = a[r][q];
+        Lanes difference = aqq - app;
+        Lanes denominator = absolute(difference) + squareRoot(difference * difference + splat(4.0f) * apq * apq);
+        //Lanes that are already diagonal get no rotation
+        Lanes sign = select(difference < splat(0.0f), splat(-1.0f), splat(1.0f));
+        Lanes t = select(splat(0.0f) < denominator, splat(2.0f) * apq * sign / denominator, splat(0.0f));
+        Lanes c = splat(1.0f) / squareRoot(splat(1.0f) + t * t);
+        Lanes s = t * c;
+        a[p][p] = app - t * apq;
+        a[q][q] = aqq + t * apq;
+        a[p][q] = a[q][p] = splat(0.0f);
+        a[r][p] = a[p][r] = c * arp - s * arq;
+        a[r][q] = a[q][r] = s * arp + c * arq;
+        for (int i = 0; i < 3; ++i)
+        {
+            Lanes vip = v[i][p], viq = v[i][q];
+            v[i][p] = c * vip - s * viq;
+            v[i][q] = s * vip + c * viq;
+        }
+    }
+
+    //Eigenvector of the smallest eigenvalue of four symmetric 3x3 matrices, given as their xx, xy, xz, yy, yz, zz
+    //entries per lane
+    void smallestEigenvectors(const float covariance[6][normalLanes], float eigenvectors[3][normalLanes])
+    {
+        Lanes a[3][3], v[3][3];
+        a[0][0] = load(covariance[0]);
+        a[0][1] = a[1][0] = load(covariance[1]);
+        a[0][2] = a[2][0] = load(covariance[2]);
+        a[1][1] = load(covariance[3]);
+        a[1][2] = a[2][1] = load(covariance[4]);
+        a[2][2] = load(covariance[5]);
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+                v[i][j] = splat(i == j ? 1.0f : 0.0f);
+        }
+        for (int sweep = 0; sweep < jacobiSweeps; ++sweep)
+        {
+            rotate(a, v, 0, 1);
+            rotate(a, v, 0, 2);
+            rotate(a, v, 1, 2);
+        }
+        //a is now diagonal, pick the column of the smallest entry
+        Mask firstBelowSecond = a[0][0] < a[1][1];
+        Lanes smallest = select(firstBelowSecond, a[0][0], a[1][1]);
+        Mask thirdSmallest = a[2][2] < smallest;
+        for (int i = 0; i < 3; ++i)
+            store(eigenvectors[i], select(thirdSmallest, v[i][2], select(firstBelowSecond, v[i][0], v[i][1])));
+    }
+}
+
+bool estimateNormals(const PointCloud& pointCloud, std::vector<std::uint32_t>& normals, unsigned int nNeighbours,
+    const std::optional<XMFLOAT3>& viewpoint)
+{
+    const PointCloudVertex* vertices = pointCloud.data();
+    std::size_t nVertices = pointCloud.size();
+    std::unique_ptr<KdTree> tree = buildKdTree(vertices, nVertices);
+    if (!tree)
+        return false;
+    XMFLOAT3 centroid = pointCloud.bounds ? pointCloud.bounds->centroid : calculateBounds(vertices, nVertices).centroid;
+    nNeighbours = std::max(nNeighbours, 1u);
+
+    //Points are taken in tree order, so the queries of a batch and of consecutive batches share leaves
+    normals.resize(nVertices);
+    const std::vector<std::uint32_t>& treeOrder = tree->treeOrder();
+    std::size_t nTasks = (nVertices + normalPointsPerTask - 1) / normalPointsPerTask;
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::vector<std::uint32_t> neighbours(nNeighbours);
+        std::vector<float> squaredDistances(nNeighbours);
+        std::size_t end = std::min((task + 1) * normalPointsPerTask, nVertices);
+        for (std::size_t batch = task * normalPointsPerTask; batch < end; batch += normalLanes)
+        {
+            //Covariance of each lane's neighbourhood about its mean, unused lanes repeat the last point
+            float covariance[6][normalLanes];
+            std::uint32_t batchVertices[normalLanes];
+            for (std::size_t lane = 0; lane < normalLanes; ++lane)
+            {
+                std::uint32_t vertex = treeOrder[std::min(batch + lane, end - 1)];
+                batchVertices[lane] = vertex;
+                tree->nearest(vertices[vertex].modelPos, nNeighbours, neighbours.data(), squaredDistances.data());
+                float mean[3] = {};
+                unsigned int nFound = 0;
+                for (; nFound < nNeighbours && neighbours[nFound] != kdNoNeighbour; ++nFound)
+                {
+                    const XMFLOAT3& position = vertices[neighbours[nFound]].modelPos;
+                    mean[0] += position.x;
+                    mean[1] += position.y;
+                    mean[2] += position.z;
+                }
+                for (float& axis : mean)
+                    axis /= static_cast<float>(nFound);
+                float sums[6] = {};
+                for (unsigned int i = 0; i < nFound; ++i)
+                {
+                    const XMFLOAT3& position = vertices[neighbours[i]].modelPos;
+                    float dx = position.x - mean[0], dy = position.y - mean[1], dz = position.z - mean[2];
+                    sums[0] += dx * dx;
+                    sums[1] += dx * dy;
+                    sums[2] += dx * dz;
+                    sums[3] += dy * dy;
+                    sums[4] += dy * dz;
+                    sums[5] += dz * dz;
+                }
+                for (int entry = 0; entry < 6; ++entry)
+                    covariance[entry][lane] = sums[entry];
+            }
+
+            float eigenvectors[3][normalLanes];
+            smallestEigenvectors(covariance, eigenvectors);
+            for (std::size_t lane = 0; lane < normalLanes && batch + lane < end; ++lane)
+            {
+                const XMFLOAT3& position = vertices[batchVertices[lane]].modelPos;
+                XMFLOAT3 towards = viewpoint
+                    ? XMFLOAT3(viewpoint->x - position.x, viewpoint->y - position.y, viewpoint->z - position.z)
+                    : XMFLOAT3(position.x - centroid.x, position.y - centroid.y, position.z - centroid.z);
+                XMFLOAT3 normal(eigenvectors[0][lane], eigenvectors[1][lane], eigenvectors[2][lane]);
+                if (normal.x * towards.x + normal.y * towards.y + normal.z * towards.z < 0.0f)
+                    normal = XMFLOAT3(-normal.x, -normal.y, -normal.z);
+                normals[batchVertices[lane]] = encodeOctahedral(normal);
+            }
+        }
+    });
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "PointCloud.h"
+//C++
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//Neighbours whose covariance gives each point's normal.
+constexpr unsigned int defaultNormalNeighbours = 16;
+
+//Estimates a unit normal for every vertex as the direction of least variance of its nNeighbours nearest neighbours,
+//itself included. The neighbours come from batched kd-tree queries on the shared thread pool. The covariances are
+//solved four at a time with a fixed number of Jacobi sweeps, on SSE2 where available.
+//Normals are turned towards viewpoint, for example the scanner's position, or if none is given away from the cloud's
+//centroid, which is outward for closed objects. They are written octahedral encoded to normals, in vertex order.
+//Returns false if the cloud is too large for the kd-tree.
+bool estimateNormals(const PointCloud& pointCloud, std::vector<std::uint32_t>& normals,
+	unsigned int nNeighbours = defaultNormalNeighbours, const std::optional<DirectX::XMFLOAT3>& viewpoint = std::nullopt);
@@ -0,0 +1,240 @@
+#include "OcclusionCulling.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr std::size_t occluderPointsPerTask = 1 << 16;
+
+    std::uint32_t depthToBits(float depth)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return bits;
+    }
+
+    float bitsToDepth(std::uint32_t bits)
+    {
+        float depth;
+        std::memcpy(&depth, &bits, sizeof(depth));
+        return depth;
+    }
+
+    struct OccluderTask
+    {
+        std::uint64_t firstPoint;
+        std::uint64_t nPoints;
+        float cellSide; //Of the node the points belong to
+    };
+}
+
+void OcclusionCuller::resize(unsigned int newWidth, unsigned int newHeight)
+{
+    if (newWidth == width && newHeight == height)
+        return;
+    width = newWidth;
+    height = newHeight;
+    depthBits.reset(new std::atomic<std::uint32_t>[static_cast<std::size_t>(width) * height]);
+    pyramid.clear();
+    for (unsigned int levelWidth = width, levelHeight = height;; levelWidth = (levelWidth + 1) / 2, levelHeight = (levelHeight + 1) / 2)
+    {
+        pyramid.emplace_back(static_cast<std::size_t>(levelWidth) * levelHeight);
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+    }
+}
+
+bool OcclusionCuller::occluded(const Footprint& footprint) const
+{
+    if (footprint.crossesEye)
+        return false;
+    float minX = std::max(footprint.minX, 0.0f);
+    float minY = std::max(footprint.minY, 0.0f);
+    float maxX = std::min(footprint.maxX, static_cast<float>(width) - 1.0f);
+    float maxY = std::min(footprint.maxY, static_cast<float>(height) - 1.0f);
+    if (minX > maxX || minY > maxY)
+        return false;
+
+    //The level where the footprint spans at most two texels per axis, so at most three are read per axis
+    unsigned int x0 = static_cast<unsigned int>(minX), x1 = static_cast<unsigned int>(maxX);
+    unsigned int y0 = static_cast<unsigned int>(minY), y1 = static_cast<unsigned int>(maxY);
+    std::size_t level = 0;
+    while (level + 1 < pyramid.size() && ((x1 - x0) >> level > 1 || (y1 - y0) >> level > 1))
+        ++level;
+    unsigned int levelWidth = (width + (1u << level) - 1) >> level;
+    const std::vector<float>& depths = pyramid[level];
+    for (unsigned int y = y0 >> level; y <= y1 >> level; ++y)
+    {
+        for (unsigned int x = x0 >> level; x <= x1 >> level; ++x)
+        {
+            if (footprint.nearestDepth <= depths[static_cast<std::size_t>(y) * levelWidth + x])
+                return false;
+        }
+    }
+    return true;
+}
+
+const std::vector<DrawRange>& OcclusionCuller::cull(const std::vector<LodNode>& nodes,
+    const std::vector<std::uint32_t>& selectedNodes, const std::vector<DrawRange>& selectedRanges, const PointCloudVertex* vertices,
+    FXMMATRIX MVP, unsigned int rtvWidth, unsigned int rtvHeight, OccluderSplat splat, std::uint64_t occluderPointBudget)
+{
+    ranges.clear();
+    nOccluded = 0;
+    unsigned int downscale = splat == OccluderSplat::Cell ? occlusionBufferDownscale : 1;
+    resize(std::max((rtvWidth + downscale - 1) / downscale, 1u), std::max((rtvHeight + downscale - 1) / downscale, 1u));
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, MVP);
+    auto project = [&](float x, float y, float z, float clip[4]) {
+        for (int j = 0; j < 4; ++j)
+            clip[j] = x * m.m[0][j] + y * m.m[1][j] + z * m.m[2][j] + m.m[3][j];
+    };
+    float halfWidth = 0.5f * static_cast<float>(width);
+    float halfHeight = 0.5f * static_cast<float>(height);
+
+    //Screen rectangle and nearest depth of every selected node's box, from its eight corners
+    footprints.resize(selectedNodes.size());
+    for (std::size_t i = 0; i < selectedNodes.size(); ++i)
+    {
+        const BoundingBox& box = nodes[selectedNodes[i]].bounds;
+        Footprint footprint = { INFINITY, INFINITY, -INFINITY, -INFINITY, INFINITY, false };
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            float clip[4];
+            project(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y,
+                corner & 4 ? box.max.z : box.min.z, clip);
+            if (clip[3] <= 0.0f)
+            {
+                footprint.crossesEye = true;
+                break;
+            }
+            float screenX = (clip[0] / clip[3] + 1.0f) * halfWidth;
+            float screenY = (1.0f - clip[1] / clip[3]) * halfHeight;
+            footprint.minX = std::min(footprint.minX, screenX);
+            footprint.maxX = std::max(footprint.maxX, screenX);
+            footprint.minY = std::min(footprint.minY, screenY);
+            footprint.maxY = std::max(footprint.maxY, screenY);
+            footprint.nearestDepth = std::min(footprint.nearestDepth, clip[2] / clip[3]);
+        }
+        footprints[i] = footprint;
+    }
+
+    //Front to back, the nearest nodes up to the budget become occluders
+    order.resize(selectedNodes.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = static_cast<std::uint32_t>(i);
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return footprints[a].nearestDepth < footprints[b].nearestDepth;
+    });
+    std::size_t nOccluders = 0;
+    std::uint64_t nOccluderPoints = 0;
+    std::vector<OccluderTask> tasks;
+    for (; nOccluders < order.size(); ++nOccluders)
+    {
+        const LodNode& node = nodes[selectedNodes[order[nOccluders]]];
+        if (nOccluderPoints + node.nPoints > occluderPointBudget)
+            break;
+        nOccluderPoints += node.nPoints;
+        for (std::uint64_t first = node.firstPoint; first < node.firstPoint + node.nPoints; first += occluderPointsPerTask)
+            tasks.push_back({ first, std::min<std::uint64_t>(occluderPointsPerTask, node.firstPoint + node.nPoints - first),
+                node.spacing });
+    }
+
+    //A model space length along the view direction changes clip z and w by the lengths of those columns, and
+    //across the screen changes clip y by the length of the y column
+    auto columnLength = [&](int j) { return std::sqrt(m.m[0][j] * m.m[0][j] + m.m[1][j] * m.m[1][j] + m.m[2][j] * m.m[2][j]); };
+    float pixelsPerUnit = halfHeight * columnLength(1);
+    float zPerUnit = columnLength(2);
+    float wPerUnit = columnLength(3);
+
+    std::size_t nPixels = static_cast<std::size_t>(width) * height;
+    for (std::size_t pixel = 0; pixel < nPixels; ++pixel)
+        depthBits[pixel].store(depthToBits(1.0f), std::memory_order_relaxed);
+    auto lowerDepth = [&](unsigned int x, unsigned int y, std::uint32_t bits) {
+        std::atomic<std::uint32_t>& texel = depthBits[static_cast<std::size_t>(y) * width + x];
+        std::uint32_t current = texel.load(std::memory_order_relaxed);
+        while (bits < current && !texel.compare_exchange_weak(current, bits, std::memory_order_relaxed))
+        {
+        }
+    };
+    ThreadPool::shared().parallelFor(tasks.size(), [&](std::size_t task) {
+        float cellSide = tasks[task].cellSide;
+        for (std::uint64_t point = tasks[task].firstPoint; point < tasks[task].firstPoint + tasks[task].nPoints; ++point)
+        {
+            float clip[4];
+            const XMFLOAT3& position = vertices[point].modelPos;
+            project(position.x, position.y, position.z, clip);
+            if (clip[3] <= 0.0f || clip[2] < 0.0f)
+                continue;
+            float screenX = (clip[0] / clip[3] + 1.0f) * halfWidth;
+            float screenY = (1.0f - clip[1] / clip[3]) * halfHeight;
+            if (splat == OccluderSplat::Point)
+            {
+                //The pixel whose centre the drawn point covers, unless it's clipped
+                float depth = clip[2] / clip[3];
+                if (!(screenX >= 0.0f && screenX < static_cast<float>(width) && screenY >= 0.0f && screenY < static_cast<float>(height))
+                    || depth > 1.0f)
+                    continue;
+                lowerDepth(static_cast<unsigned int>(screenX), static_cast<unsigned int>(screenY), depthToBits(depth));
+                continue;
+            }
+            float depth = std::min((clip[2] + cellSide * zPerUnit) / (clip[3] + cellSide * wPerUnit), 1.0f);
+            float radius = std::min(cellSide * pixelsPerUnit / clip[3], maximumOccluderSplatRadius);
+
+            //Texels whose centres lie inside the splat
+            if (!(screenX + radius > 0.0f && screenX - radius < static_cast<float>(width)
+                && screenY + radius > 0.0f && screenY - radius < static_cast<float>(height)))
+                continue;
+            int x0 = std::max(static_cast<int>(std::ceil(screenX - radius - 0.5f)), 0);
+            int x1 = std::min(static_cast<int>(std::floor(screenX + radius - 0.5f)), static_cast<int>(width) - 1);
+            int y0 = std::max(static_cast<int>(std::ceil(screenY - radius - 0.5f)), 0);
+            int y1 = std::min(static_cast<int>(std::floor(screenY + radius - 0.5f)), static_cast<int>(height) - 1);
+            std::uint32_t bits = depthToBits(depth);
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                    lowerDepth(x, y, bits);
+            }
+        }
+    });
+
+    //Farthest depth pyramid, each texel covering the 2x2 texels below it
+    for (std::size_t pixel = 0; pixel < nPixels; ++pixel)
+        pyramid[0][pixel] = bitsToDepth(depthBits[pixel].load(std::memory_order_relaxed));
+    for (std::size_t level = 1; level < pyramid.size(); ++level)
+    {
+        unsigned int belowWidth = (width + (1u << (level - 1)) - 1) >> (level - 1);
+        unsigned int belowHeight = (height + (1u << (level - 1)) - 1) >> (level - 1);
+        unsigned int levelWidth = (belowWidth + 1) / 2, levelHeight = (belowHeight + 1) / 2;
+        const std::vector<float>& below = pyramid[level - 1];
+        std::vector<float>& depths = pyramid[level];
+        for (unsigned int y = 0; y < levelHeight; ++y)
+        {
+            for (unsigned int x = 0; x < levelWidth; ++x)
+            {
+                unsigned int belowX = std::min(2 * x + 1, belowWidth - 1), belowY = std::min(2 * y + 1, belowHeight - 1);
+                depths[static_cast<std::size_t>(y) * levelWidth + x] = std::max(
+                    std::max(below[static_cast<std::size_t>(2 * y) * belowWidth + 2 * x], below[static_cast<std::size_t>(2 * y) * belowWidth + belowX]),
+                    std::max(below[static_cast<std::size_t>(belowY) * belowWidth + 2 * x], below[static_cast<std::size_t>(belowY) * belowWidth + belowX]));
+            }
+        }
+    }
+
+    //Occluders are always drawn, every other node only if some texel it covers could show it
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        if (i >= nOccluders && occluded(footprints[order[i]]))
+        {
+            ++nOccluded;
+            continue;
+        }
+        if (selectedRanges[order[i]].nVertices != 0)
+            ranges.push_back(selectedRanges[order[i]]);
+    }
+    sortAndMergeRanges(ranges);
+    return ranges;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "LodHierarchy.h"
+#include "VertexSegments.h"
+//C++
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//Points of the front-most selected nodes rasterized as occluders each frame.
+constexpr std::uint64_t defaultOccluderPointBudget = 1 << 20;
+//Cell splats are clipped to this radius in pixels, which bounds the cost of points right in front of the camera.
+constexpr float maximumOccluderSplatRadius = 4.0f;
+//With cell splats the depth buffer has one texel per this many pixels along each axis of the render target.
+constexpr unsigned int occlusionBufferDownscale = 2;
+
+//How occluder points are rasterized into the depth buffer.
+enum class OccluderSplat
+{
+	//Into the one pixel each point is drawn to, at its own depth, in a buffer the size of the render target. Every
+	//depth written is one the drawn point itself writes, so only what the drawn points hide is culled. Sparse
+	//occluders, whose points leave gaps between them, hide little.
+	Point,
+	//Lossy: as squares the projected size of their node's sampling cell, which is the surface a point stands for in
+	//the cut, pushed one cell further away, into a buffer downscaled by occlusionBufferDownscale. Gaps narrower than
+	//a sampling cell close up, so points seen only through them are culled too. Wider openings such as doors and
+	//windows stay open.
+	Cell
+};
+
+class OcclusionCuller
+{
+	struct Footprint
+	{
+		float minX, minY, maxX, maxY; //Pixels
+		float nearestDepth; //Clip z / w
+		bool crossesEye; //Part of the box is behind the eye, so it can't be projected
+	};
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	std::unique_ptr<std::atomic<std::uint32_t>[]> depthBits; //Float bits, positive depths order as integers
+	std::vector<std::vector<float>> pyramid; //Level 0 is the depth buffer, each level after half the size
+	std::vector<Footprint> footprints;
+	std::vector<std::uint32_t> order;
+	std::vector<DrawRange> ranges;
+	std::size_t nOccluded = 0;
+
+	void resize(unsigned int newWidth, unsigned int newHeight);
+	bool occluded(const Footprint& footprint) const;
+
+public:
+	//Culls selectedNodes, whose points are vertices, and returns the selectedRanges of the remaining ones (see
+	//LodTraversal::selectedRanges) sorted and merged. The result is valid until the next call.
+	const std::vector<DrawRange>& cull(const std::vector<LodNode>& nodes, const std::vector<std::uint32_t>& selectedNodes,
+		const std::vector<DrawRange>& selectedRanges, const PointCloudVertex* vertices, DirectX::FXMMATRIX MVP,
+		unsigned int rtvWidth, unsigned int rtvHeight, OccluderSplat splat = OccluderSplat::Point,
+		std::uint64_t occluderPointBudget = defaultOccluderPointBudget);
+
+	std::size_t occludedNodes() const { return nOccluded; }
+	unsigned int bufferWidth() const { return width; }
+	unsigned int bufferHeight() const { return height; }
+	//Farthest depth per texel of a pyramid level, row major. Level 0 is bufferWidth() texels wide.
+	const std::vector<float>& depthLevel(std::size_t level) const { return pyramid[level]; }
+};
@@ -0,0 +1,112 @@
+#include "OctahedralNormal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PCV_OCTAHEDRAL_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+#if defined(PCV_OCTAHEDRAL_SSE2)
+namespace
+{
+    inline __m128 absolute(__m128 a)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+    }
+
+    inline __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    //Compared rather than copied from the sign bit, so -0 counts as positive like in the scalar version
+    inline __m128 signNotZero(__m128 a)
+    {
+        return select(_mm_cmpge_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f), _mm_set1_ps(-1.0f));
+    }
+
+    //Swaps the u and v of the folded half: (1 - |v|) * sign(u), (1 - |u|) * sign(v)
+    inline void fold(__m128 mask, __m128& u, __m128& v)
+    {
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 foldedU = _mm_mul_ps(_mm_sub_ps(one, absolute(v)), signNotZero(u));
+        __m128 foldedV = _mm_mul_ps(_mm_sub_ps(one, absolute(u)), signNotZero(v));
+        u = select(mask, foldedU, u);
+        v = select(mask, foldedV, v);
+    }
+
+    //Clamps to [-1, 1] and scales to 16 bits, rounding halves away from zero like std::lround
+    inline __m128i quantize(__m128 coordinate)
+    {
+        __m128 scaled = _mm_mul_ps(_mm_min_ps(_mm_max_ps(coordinate, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f)), _mm_set1_ps(octahedralScale));
+        __m128i truncated = _mm_cvttps_epi32(scaled);
+        __m128 fraction = _mm_sub_ps(scaled, _mm_cvtepi32_ps(truncated));
+        //Comparison masks are -1 where set
+        truncated = _mm_sub_epi32(truncated, _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f))));
+        return _mm_add_epi32(truncated, _mm_castps_si128(_mm_cmple_ps(fraction, _mm_set1_ps(-0.5f))));
+    }
+
+    //Four packed XMFLOAT3s (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3) to one register per axis and back
+    inline void transposeToLanes(const float* source, __m128& x, __m128& y, __m128& z)
+    {
+        __m128 a = _mm_loadu_ps(source), b = _mm_loadu_ps(source + 4), c = _mm_loadu_ps(source + 8);
+        x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+    }
+
+    inline void transposeFromLanes(__m128 x, __m128 y, __m128 z, float* destination)
+    {
+        __m128 lowXY = _mm_unpacklo_ps(x, y), highXY = _mm_unpackhi_ps(x, y);
+        _mm_storeu_ps(destination, _mm_shuffle_ps(lowXY, _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(destination + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), highXY, _MM_SHUFFLE(1, 0, 2, 0)));
+        _mm_storeu_ps(destination + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, highXY, _MM_SHUFFLE(2, 2, 2, 2)),
+            _mm_shuffle_ps(highXY, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+}
+#endif
+
+void encodeOctahedral(const XMFLOAT3* normals, std::size_t nNormals, std::uint32_t* packed)
+{
+    std::size_t i = 0;
+#if defined(PCV_OCTAHEDRAL_SSE2)
+    static_assert(sizeof(XMFLOAT3) == 3 * sizeof(float), "XMFLOAT3 must be three packed floats");
+    for (; i + 4 <= nNormals; i += 4)
+    {
+        __m128 x, y, z;
+        transposeToLanes(&normals[i].x, x, y, z);
+        __m128 length = _mm_add_ps(_mm_add_ps(absolute(x), absolute(y)), absolute(z));
+        __m128 u = _mm_div_ps(x, length), v = _mm_div_ps(y, length);
+        fold(_mm_cmplt_ps(z, _mm_setzero_ps()), u, v);
+        __m128i encoded = _mm_or_si128(_mm_and_si128(quantize(u), _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(quantize(v), 16));
+        //Normals that can't be folded, including NaNs, become (0, 0, 1)
+        __m128i valid = _mm_castps_si128(_mm_cmpgt_ps(length, _mm_setzero_ps()));
+        encoded = _mm_and_si128(valid, encoded);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i), encoded);
+    }
+#endif
+    for (; i < nNormals; ++i)
+        packed[i] = encodeOctahedral(normals[i]);
+}
+
+void decodeOctahedral(const std::uint32_t* packed, std::size_t nNormals, XMFLOAT3* normals)
+{
+    std::size_t i = 0;
+#if defined(PCV_OCTAHEDRAL_SSE2)
+    for (; i + 4 <= nNormals; i += 4)
+    {
+        //Shifting the halves to the top and back sign extends them
+        __m128i encoded = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i));
+        __m128 scale = _mm_set1_ps(octahedralScale);
+        __m128 u = _mm_div_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(encoded, 16), 16)), scale);
+        __m128 v = _mm_div_ps(_mm_cvtepi32_ps(_mm_srai_epi32(encoded, 16)), scale);
+        __m128 z = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), absolute(u)), absolute(v));
+        fold(_mm_cmplt_ps(z, _mm_setzero_ps()), u, v);
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u, u), _mm_mul_ps(v, v)), _mm_mul_ps(z, z)));
+        transposeFromLanes(_mm_div_ps(u, length), _mm_div_ps(v, length), _mm_div_ps(z, length), &normals[i].x);
+    }
+#endif
+    for (; i < nNormals; ++i)
+        normals[i] = decodeOctahedral(packed[i]);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <DirectXMath.h>
+//C++
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+//Unit normals folded onto the octahedron |x| + |y| + |z| = 1, whose lower half is unfolded over the corners of the
+//upper half's square, and stored as two 16-bit signed normalized coordinates: u in the low half, v in the high half.
+//The angular error is below 0.01 degrees over the whole sphere.
+constexpr float octahedralScale = 32767.0f;
+
+inline float signNotZero(float v)
+{
+	return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+inline std::uint32_t encodeOctahedral(const DirectX::XMFLOAT3& normal)
+{
+	float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (!(length > 0.0f))
+		return 0; //(0, 0, 1), the centre of the upper half, for normals that can't be folded
+	float u = normal.x / length, v = normal.y / length;
+	if (normal.z < 0.0f)
+	{
+		float foldedU = (1.0f - std::fabs(v)) * signNotZero(u);
+		v = (1.0f - std::fabs(u)) * signNotZero(v);
+		u = foldedU;
+	}
+	auto quantize = [](float coordinate) {
+		return static_cast<std::uint16_t>(static_cast<std::int16_t>(std::lround(std::min(std::max(coordinate, -1.0f), 1.0f) * octahedralScale)));
+	};
+	return quantize(u) | static_cast<std::uint32_t>(quantize(v)) << 16;
+}
+
+inline DirectX::XMFLOAT3 decodeOctahedral(std::uint32_t packed)
+{
+	float u = static_cast<float>(static_cast<std::int16_t>(packed & 0xFFFF)) / octahedralScale;
+	float v = static_cast<float>(static_cast<std::int16_t>(packed >> 16)) / octahedralScale;
+	float z = 1.0f - std::fabs(u) - std::fabs(v);
+	if (z < 0.0f)
+	{
+		float unfoldedU = (1.0f - std::fabs(v)) * signNotZero(u);
+		v = (1.0f - std::fabs(u)) * signNotZero(v);
+		u = unfoldedU;
+	}
+	float length = std::sqrt(u * u + v * v + z * z);
+	return DirectX::XMFLOAT3(u / length, v / length, z / length);
+}
+
+//Batch versions of the two above, four normals per step on SSE2 where available. Their results are bit identical
+//to the scalar ones.
+void encodeOctahedral(const DirectX::XMFLOAT3* normals, std::size_t nNormals, std::uint32_t* packed);
+void decodeOctahedral(const std::uint32_t* packed, std::size_t nNormals, DirectX::XMFLOAT3* normals);
+
+//Collects the normals a parser produces one at a time and encodes them in batches, writing them consecutively from
+//destination. flush must be called once the last normal has been pushed.
+class OctahedralNormalWriter
+{
+	static constexpr std::size_t batchSize = 64;
+	DirectX::XMFLOAT3 pending[batchSize];
+	std::size_t nPending = 0;
+	std::uint32_t* destination;
+
+public:
+	explicit OctahedralNormalWriter(std::uint32_t* destination) : destination(destination) {}
+
+	void push(const DirectX::XMFLOAT3& normal)
+	{
+		pending[nPending++] = normal;
+		if (nPending == batchSize)
+			flush();
+	}
+
+	void flush()
+	{
+		encodeOctahedral(pending, nPending, destination);
+		destination += nPending;
+		nPending = 0;
+	}
+};
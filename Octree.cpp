@@ -0,0 +1,121 @@
+#include "Octree.h"
+#include "SpaceFillingCurve.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+
+namespace
+{
+    struct ChildRanges
+    {
+        std::uint64_t first[8];
+        std::uint64_t count[8];
+        std::uint8_t mask = 0;
+    };
+
+    //Splits a node's range of sorted codes at the octant digit below its level. Codes in the range share every
+    //higher digit, so each octant is one contiguous run found by binary search.
+    ChildRanges splitByOctant(const std::uint64_t* codes, const OctreeNode& node)
+    {
+        ChildRanges children;
+        unsigned int shift = 3 * (curveBitsPerAxis - 1 - node.level);
+        const std::uint64_t* begin = codes + node.firstPoint;
+        const std::uint64_t* end = begin + node.nPoints;
+        for (std::uint8_t octant = 0; octant < 8; ++octant)
+        {
+            const std::uint64_t* octantEnd = std::partition_point(begin, end,
+                [&](std::uint64_t code) { return ((code >> shift) & 7) <= octant; });
+            children.first[octant] = static_cast<std::uint64_t>(begin - codes);
+            children.count[octant] = static_cast<std::uint64_t>(octantEnd - begin);
+            if (octantEnd != begin)
+                children.mask |= 1 << octant;
+            begin = octantEnd;
+        }
+        return children;
+    }
+
+    int popCount(std::uint8_t mask)
+    {
+        int count = 0;
+        for (; mask != 0; mask &= mask - 1)
+            ++count;
+        return count;
+    }
+}
+
+std::unique_ptr<Octree> buildOctree(const PointCloudVertex* vertices, std::size_t nVertices, const BoundingBox& box,
+    std::size_t maxLeafPoints, std::vector<std::uint64_t>* sortedCodes, std::vector<std::uint64_t>* sourceIndices)
+{
+    auto octree = std::make_unique<Octree>();
+    octree->cube = boundingCube(box);
+    if (nVertices == 0)
+        return octree;
+
+    std::vector<std::uint64_t> localCodes;
+    std::vector<std::uint64_t>& codes = sortedCodes ? *sortedCodes : localCodes;
+    sortAlongCurve(vertices, nVertices, octree->cube, CurveType::Morton, octree->vertices, &codes, sourceIndices);
+
+    std::vector<OctreeNode>& nodes = octree->nodes;
+    OctreeNode root = {};
+    root.nPoints = nVertices;
+    nodes.push_back(root);
+
+    //Breadth first: split the current level in parallel, then append its children as the next level
+    std::vector<ChildRanges> levelChildren;
+    std::size_t levelBegin = 0;
+    std::size_t levelEnd = 1;
+    while (levelBegin < levelEnd)
+    {
+        levelChildren.assign(levelEnd - levelBegin, ChildRanges());
+        ThreadPool::shared().parallelFor(levelEnd - levelBegin, [&](std::size_t i) {
+            const OctreeNode& node = nodes[levelBegin + i];
+            if (node.nPoints > maxLeafPoints && node.level < curveBitsPerAxis)
+                levelChildren[i] = splitByOctant(codes.data(), node);
+        });
+
+        for (std::size_t i = 0; i < levelChildren.size(); ++i)
+        {
+            OctreeNode& node = nodes[levelBegin + i];
+            node.childMask = levelChildren[i].mask;
+            node.firstChild = static_cast<std::uint32_t>(nodes.size());
+            for (std::uint8_t octant = 0; octant < 8; ++octant)
+            {
+                if ((levelChildren[i].mask & (1 << octant)) == 0)
+                    continue;
+                OctreeNode child = {};
+                child.firstPoint = levelChildren[i].first[octant];
+                child.nPoints = levelChildren[i].count[octant];
+                child.level = static_cast<std::uint8_t>(node.level + 1);
+                nodes.push_back(child);
+            }
+        }
+        levelBegin = levelEnd;
+        levelEnd = nodes.size();
+    }
+    localCodes = std::vector<std::uint64_t>();
+
+    //Tight bounds: leaves scan their points in parallel, inner nodes then merge their children bottom up
+    std::vector<std::uint32_t> leaves;
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes[i].isLeaf())
+            leaves.push_back(static_cast<std::uint32_t>(i));
+    }
+    ThreadPool::shared().parallelFor(leaves.size(), [&](std::size_t i) {
+        OctreeNode& leaf = nodes[leaves[i]];
+        BoundsAccumulator bounds;
+        for (std::uint64_t point = leaf.firstPoint; point < leaf.firstPoint + leaf.nPoints; ++point)
+            bounds.add(octree->vertices[point]);
+        leaf.bounds = { bounds.min, bounds.max };
+    });
+    for (std::size_t i = nodes.size(); i-- > 0;)
+    {
+        OctreeNode& node = nodes[i];
+        if (node.isLeaf())
+            continue;
+        node.bounds = nodes[node.firstChild].bounds;
+        for (int child = 1; child < popCount(node.childMask); ++child)
+            node.bounds = mergeBoundingBoxes(node.bounds, nodes[node.firstChild + child].bounds);
+    }
+    return octree;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "PointCloudVertex.h"
+#include "Bounds.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//Leaves are split until they hold at most this many points or reach the curve grid's resolution.
+constexpr std::size_t defaultOctreeLeafSize = 4096;
+
+struct OctreeNode
+{
+	BoundingBox bounds; //Tight around the node's points
+	std::uint64_t firstPoint; //The node's points are vertices[firstPoint, firstPoint + nPoints)
+	std::uint64_t nPoints;
+	std::uint32_t firstChild; //Children are stored consecutively, in octant order
+	std::uint8_t childMask; //Bit i is set if octant i (x in bit 0, y in bit 1, z in bit 2) has a child
+	std::uint8_t level; //0 for the root
+
+	bool isLeaf() const { return childMask == 0; }
+};
+
+//Pointerless octree: nodes are stored breadth first, and the vertices in Morton order so every node covers one
+//contiguous range that is the concatenation of its children's ranges.
+struct Octree
+{
+	BoundingBox cube; //Root cell
+	std::vector<OctreeNode> nodes; //nodes[0] is the root
+	std::vector<PointCloudVertex> vertices;
+};
+
+//Computes Morton codes over cube (see boundingCube), radix sorts them in parallel, gathers the vertices into that order
+//and splits nodes level by level, each level's nodes in parallel. box must contain every vertex.
+//If codes isn't null it receives the sorted Morton codes, and if sourceIndices isn't null the input index of every
+//vertex, both parallel to the octree's vertices.
+std::unique_ptr<Octree> buildOctree(const PointCloudVertex* vertices, std::size_t nVertices, const BoundingBox& box,
+	std::size_t maxLeafPoints = defaultOctreeLeafSize, std::vector<std::uint64_t>* codes = nullptr,
+	std::vector<std::uint64_t>* sourceIndices = nullptr);
@@ -0,0 +1,92 @@
+#include "OutlierFilter.h"
+#include "KdTree.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr std::size_t outlierPointsPerTask = 1 << 14;
+}
+
+std::unique_ptr<PointCloud> removeStatisticalOutliers(const PointCloud& pointCloud, unsigned int nNeighbours, float deviations)
+{
+    const PointCloudVertex* vertices = pointCloud.data();
+    std::size_t nVertices = pointCloud.size();
+    std::unique_ptr<KdTree> tree = buildKdTree(vertices, nVertices);
+    if (!tree)
+        return nullptr;
+    ThreadPool& pool = ThreadPool::shared();
+    std::size_t nTasks = (nVertices + outlierPointsPerTask - 1) / outlierPointsPerTask;
+
+    //Each query finds its own point first, so one more neighbour is asked for and the first skipped
+    std::vector<float> meanDistances(nVertices);
+    const std::vector<std::uint32_t>& treeOrder = tree->treeOrder();
+    pool.parallelFor(nTasks, [&](std::size_t task) {
+        std::vector<std::uint32_t> indices(nNeighbours + 1);
+        std::vector<float> squaredDistances(nNeighbours + 1);
+        std::size_t end = std::min((task + 1) * outlierPointsPerTask, nVertices);
+        for (std::size_t i = task * outlierPointsPerTask; i < end; ++i)
+        {
+            std::uint32_t vertex = treeOrder[i];
+            tree->nearest(vertices[vertex].modelPos, nNeighbours + 1, indices.data(), squaredDistances.data());
+            float sum = 0.0f;
+            unsigned int nFound = 0;
+            for (unsigned int neighbour = 1; neighbour <= nNeighbours && indices[neighbour] != kdNoNeighbour; ++neighbour, ++nFound)
+                sum += std::sqrt(squaredDistances[neighbour]);
+            meanDistances[vertex] = nFound == 0 ? 0.0f : sum / static_cast<float>(nFound);
+        }
+    });
+    tree.reset();
+
+    //Mean and standard deviation from per task sums, combined in task order so the threshold is deterministic
+    std::vector<double> sums(nTasks), squaredSums(nTasks);
+    pool.parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * outlierPointsPerTask, nVertices);
+        for (std::size_t i = task * outlierPointsPerTask; i < end; ++i)
+        {
+            sums[task] += meanDistances[i];
+            squaredSums[task] += static_cast<double>(meanDistances[i]) * meanDistances[i];
+        }
+    });
+    double sum = 0.0, squaredSum = 0.0;
+    for (std::size_t task = 0; task < nTasks; ++task)
+    {
+        sum += sums[task];
+        squaredSum += squaredSums[task];
+    }
+    double mean = nVertices == 0 ? 0.0 : sum / static_cast<double>(nVertices);
+    double variance = nVertices == 0 ? 0.0 : std::max(squaredSum / static_cast<double>(nVertices) - mean * mean, 0.0);
+    float threshold = static_cast<float>(mean + deviations * std::sqrt(variance));
+
+    //Count the survivors of each task, then every task scatters its own into place
+    std::vector<std::size_t> firstKept(nTasks + 1, 0);
+    pool.parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * outlierPointsPerTask, nVertices);
+        for (std::size_t i = task * outlierPointsPerTask; i < end; ++i)
+            firstKept[task + 1] += meanDistances[i] <= threshold;
+    });
+    for (std::size_t task = 0; task < nTasks; ++task)
+        firstKept[task + 1] += firstKept[task];
+    std::vector<PointCloudVertex> kept(firstKept[nTasks]);
+    std::vector<std::uint32_t> keptNormals(pointCloud.normals.empty() ? 0 : kept.size());
+    pool.parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t output = firstKept[task];
+        std::size_t end = std::min((task + 1) * outlierPointsPerTask, nVertices);
+        for (std::size_t i = task * outlierPointsPerTask; i < end; ++i)
+        {
+            if (meanDistances[i] > threshold)
+                continue;
+            if (!keptNormals.empty())
+                keptNormals[output] = pointCloud.normals[i];
+            kept[output++] = vertices[i];
+        }
+    });
+
+    auto filtered = std::make_unique<PointCloud>(std::move(kept));
+    filtered->normals = std::move(keptNormals);
+    filtered->origin = pointCloud.origin;
+    filtered->bounds = calculateBounds(filtered->data(), filtered->size());
+    return filtered;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "PointCloud.h"
+//C++
+#include <memory>
+
+//Neighbours whose distances are averaged for each point.
+constexpr unsigned int defaultOutlierNeighbours = 8;
+//Points whose mean neighbour distance is more than this many standard deviations above the cloud's mean are removed.
+constexpr float defaultOutlierDeviations = 2.0f;
+
+//Load stage that removes statistical outliers such as airborne noise and mixed pixels at depth edges.
+//Every point's mean distance to its nNeighbours nearest neighbours is found with batched kd-tree queries on the shared
+//thread pool, in the tree's order. Points whose mean lies beyond the mean of all of them plus deviations standard
+//deviations are dropped, and the rest are compacted in their original order, with their normals, by one parallel
+//scatter. Bounds are recomputed and the origin kept. Like voxelDownsample, the result has no sourceOrder.
+//Returns nullptr if the cloud is too large for the kd-tree.
+std::unique_ptr<PointCloud> removeStatisticalOutliers(const PointCloud& pointCloud,
+	unsigned int nNeighbours = defaultOutlierNeighbours, float deviations = defaultOutlierDeviations);
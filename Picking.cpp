@@ -0,0 +1,165 @@
+#include "Picking.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr std::size_t pickBlocksPerTask = 256;
+    constexpr float missed = std::numeric_limits<float>::infinity();
+
+    float radiusAt(const PickRay& ray, float distance)
+    {
+        return ray.nearRadius + (ray.farRadius - ray.nearRadius) * (distance / ray.length);
+    }
+
+    //Distance along the ray at which the cone can first reach box, or missed. Every point of box inside the cone
+    //projects onto the ray within the box grown by the cone's widest radius over the box, so the ray's entry into
+    //that grown box bounds them all.
+    float coneEntry(const PickRay& ray, const BoundingBox& box)
+    {
+        const float* origin = &ray.origin.x;
+        const float* direction = &ray.direction.x;
+        const float* minimum = &box.min.x;
+        const float* maximum = &box.max.x;
+        float farthest = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+            farthest += direction[axis] * ((direction[axis] >= 0.0f ? maximum[axis] : minimum[axis]) - origin[axis]);
+        float margin = std::max(radiusAt(ray, std::min(std::max(farthest, 0.0f), ray.length)), ray.nearRadius);
+
+        float entry = 0.0f, exit = ray.length;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float low = minimum[axis] - margin - origin[axis];
+            float high = maximum[axis] + margin - origin[axis];
+            if (direction[axis] == 0.0f)
+            {
+                if (low > 0.0f || high < 0.0f)
+                    return missed;
+                continue;
+            }
+            float t0 = low / direction[axis], t1 = high / direction[axis];
+            entry = std::max(entry, std::min(t0, t1));
+            exit = std::min(exit, std::max(t0, t1));
+        }
+        return entry <= exit ? entry : missed;
+    }
+}
+
+PickRay pickRay(FXMMATRIX MVP, float pixelX, float pixelY, unsigned int rtvWidth, unsigned int rtvHeight, float pixelRadius)
+{
+    XMMATRIX inverseMVP = XMMatrixInverse(nullptr, MVP);
+    auto unproject = [&](float x, float y, float depth) {
+        //Through the pixel's centre, y pointing down on screen and up in clip space
+        float clipX = 2.0f * (x + 0.5f) / static_cast<float>(rtvWidth) - 1.0f;
+        float clipY = 1.0f - 2.0f * (y + 0.5f) / static_cast<float>(rtvHeight);
+        return XMVector3TransformCoord(XMVectorSet(clipX, clipY, depth, 1.0f), inverseMVP);
+    };
+    XMVECTOR nearPoint = unproject(pixelX, pixelY, 0.0f);
+    XMVECTOR farPoint = unproject(pixelX, pixelY, 1.0f);
+    XMVECTOR axis = XMVectorSubtract(farPoint, nearPoint);
+
+    PickRay ray;
+    XMStoreFloat3(&ray.origin, nearPoint);
+    XMStoreFloat3(&ray.direction, XMVector3Normalize(axis));
+    ray.length = XMVectorGetX(XMVector3Length(axis));
+    ray.nearRadius = XMVectorGetX(XMVector3Length(XMVectorSubtract(unproject(pixelX + pixelRadius, pixelY, 0.0f), nearPoint)));
+    ray.farRadius = XMVectorGetX(XMVector3Length(XMVectorSubtract(unproject(pixelX + pixelRadius, pixelY, 1.0f), farPoint)));
+    return ray;
+}
+
+void PointPicker::build(const std::vector<LodNode>& nodes, const PointCloudVertex* vertices)
+{
+    nodeBlocks.assign(nodes.size() + 1, 0);
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+        nodeBlocks[i + 1] = nodeBlocks[i] + (nodes[i].nPoints + pickBlockSize - 1) / pickBlockSize;
+    blocks.resize(nodeBlocks.back());
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        for (std::uint64_t block = nodeBlocks[i]; block < nodeBlocks[i + 1]; ++block)
+        {
+            std::uint64_t first = nodes[i].firstPoint + (block - nodeBlocks[i]) * pickBlockSize;
+            blocks[block].firstPoint = first;
+            blocks[block].nPoints = std::min<std::uint64_t>(pickBlockSize, nodes[i].firstPoint + nodes[i].nPoints - first);
+        }
+    }
+
+    std::size_t nTasks = (blocks.size() + pickBlocksPerTask - 1) / pickBlocksPerTask;
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * pickBlocksPerTask, blocks.size());
+        for (std::size_t i = task * pickBlocksPerTask; i < end; ++i)
+        {
+            Block& block = blocks[i];
+            const PointCloudVertex* first = vertices + block.firstPoint;
+            block.bounds = { first->modelPos, first->modelPos };
+            for (const PointCloudVertex* vertex = first; vertex != first + block.nPoints; ++vertex)
+                block.bounds = mergeBoundingBoxes(block.bounds, { vertex->modelPos, vertex->modelPos });
+        }
+    });
+}
+
+std::optional<PickedPoint> PointPicker::pick(const std::vector<LodNode>& nodes, const PointCloudVertex* vertices,
+    const PickRay& ray)
+{
+    float nearest = missed;
+    std::uint64_t nearestPoint = 0;
+    auto testPoints = [&](const Block& block) {
+        for (std::uint64_t point = block.firstPoint; point < block.firstPoint + block.nPoints; ++point)
+        {
+            const XMFLOAT3& position = vertices[point].modelPos;
+            float offset[3] = { position.x - ray.origin.x, position.y - ray.origin.y, position.z - ray.origin.z };
+            float along = offset[0] * ray.direction.x + offset[1] * ray.direction.y + offset[2] * ray.direction.z;
+            if (along < 0.0f || along > ray.length || along >= nearest)
+                continue;
+            float radius = radiusAt(ray, along);
+            float squaredDistance = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+            if (squaredDistance - along * along <= radius * radius)
+            {
+                nearest = along;
+                nearestPoint = point;
+            }
+        }
+    };
+
+    candidates.clear();
+    if (!nodes.empty())
+    {
+        float rootEntry = coneEntry(ray, nodes[0].bounds);
+        if (rootEntry != missed)
+            candidates.push_back({ rootEntry, 0 });
+    }
+    while (!candidates.empty())
+    {
+        std::pop_heap(candidates.begin(), candidates.end());
+        Candidate candidate = candidates.back();
+        candidates.pop_back();
+        //Every node left starts behind the nearest point found
+        if (candidate.entry >= nearest)
+            break;
+
+        for (std::uint64_t block = nodeBlocks[candidate.node]; block < nodeBlocks[candidate.node + 1]; ++block)
+        {
+            if (coneEntry(ray, blocks[block].bounds) < nearest)
+                testPoints(blocks[block]);
+        }
+        const LodNode& node = nodes[candidate.node];
+        std::uint32_t child = node.firstChild;
+        for (std::uint8_t mask = node.childMask; mask != 0; mask &= mask - 1, ++child)
+        {
+            float entry = coneEntry(ray, nodes[child].bounds);
+            if (entry < nearest)
+            {
+                candidates.push_back({ entry, child });
+                std::push_heap(candidates.begin(), candidates.end());
+            }
+        }
+    }
+
+    if (nearest == missed)
+        return std::nullopt;
+    return PickedPoint{ nearestPoint, vertices[nearestPoint], nearest };
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "LodHierarchy.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//Points within this many pixels of the cursor can be picked.
+constexpr float defaultPickPixelRadius = 3.0f;
+//Each node's points are split into blocks of at most this many, in the hierarchy's order, for culling against the ray.
+constexpr std::size_t pickBlockSize = 256;
+
+//A pixel's cone of sight in model space, from the near plane to the far plane. Its radius grows linearly from
+//nearRadius at the origin to farRadius at length.
+struct PickRay
+{
+	DirectX::XMFLOAT3 origin;
+	DirectX::XMFLOAT3 direction; //Unit length
+	float length;
+	float nearRadius;
+	float farRadius;
+};
+
+struct PickedPoint
+{
+	std::uint64_t index; //Into the hierarchy's vertices
+	PointCloudVertex vertex; //With its own colour, not its cell's mean
+	float distance; //Along the ray from its origin
+};
+
+//Unprojects pixel (pixelX, pixelY) of a rtvWidth by rtvHeight target through the inverse of MVP, with the cone widened
+//to pixelRadius pixels.
+PickRay pickRay(DirectX::FXMMATRIX MVP, float pixelX, float pixelY, unsigned int rtvWidth, unsigned int rtvHeight,
+	float pixelRadius = defaultPickPixelRadius);
+
+//Finds the point of a LodHierarchy nearest the eye inside a pick ray's cone.
+//The hierarchy's nodes are walked front to back by where the cone enters their boxes, and inside a node only the
+//blocks of points it enters are tested. Nodes' points follow a space filling curve, so each block is compact.
+//The walk stops once the next node starts behind the best point so far.
+class PointPicker
+{
+	struct Block
+	{
+		BoundingBox bounds;
+		std::uint64_t firstPoint;
+		std::uint64_t nPoints;
+	};
+	struct Candidate
+	{
+		float entry; //Where the cone enters the node's box
+		std::uint32_t node;
+
+		bool operator<(const Candidate& other) const { return entry > other.entry; } //Nearest at the top of the heap
+	};
+
+	std::vector<Block> blocks;
+	std::vector<std::uint64_t> nodeBlocks; //Node i's blocks are blocks[nodeBlocks[i], nodeBlocks[i + 1])
+	std::vector<Candidate> candidates;
+
+public:
+	//Splits every node's points into blocks, in parallel on the shared thread pool.
+	void build(const std::vector<LodNode>& nodes, const PointCloudVertex* vertices);
+	//nodes and vertices must be those the picker was built from.
+	std::optional<PickedPoint> pick(const std::vector<LodNode>& nodes, const PointCloudVertex* vertices, const PickRay& ray);
+};
@@ -0,0 +1,373 @@
+#include "PlyReader.h"
+#include "AsciiParser.h"
+#include "MappedFile.h"
+#include "OctahedralNormal.h"
+#include "PointCloudLoader.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+    constexpr std::size_t plyRecordsPerTask = 1 << 16;
+
+    //Where each PointCloudVertex component and normal component comes from in a vertex record
+    enum VertexTarget { TargetX, TargetY, TargetZ, TargetRed, TargetGreen, TargetBlue, TargetNormalX, TargetNormalY, TargetNormalZ, TargetCount };
+
+    struct PropertySource
+    {
+        bool present = false;
+        std::size_t propertyIndex = 0;
+        PlyType type = PlyType::Float32;
+        std::size_t offset = 0;
+        float scale = 1.0f; //Normalises integer colours to [0, 1]
+    };
+
+    bool parsePlyType(const std::string& name, PlyType& type)
+    {
+        if (name == "char" || name == "int8") type = PlyType::Int8;
+        else if (name == "uchar" || name == "uint8") type = PlyType::UInt8;
+        else if (name == "short" || name == "int16") type = PlyType::Int16;
+        else if (name == "ushort" || name == "uint16") type = PlyType::UInt16;
+        else if (name == "int" || name == "int32") type = PlyType::Int32;
+        else if (name == "uint" || name == "uint32") type = PlyType::UInt32;
+        else if (name == "float" || name == "float32") type = PlyType::Float32;
+        else if (name == "double" || name == "float64") type = PlyType::Float64;
+        else return false;
+        return true;
+    }
+
+    std::size_t plyTypeSize(PlyType type)
+    {
+        switch (type)
+        {
+        case PlyType::Int8: case PlyType::UInt8: return 1;
+        case PlyType::Int16: case PlyType::UInt16: return 2;
+        case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+        case PlyType::Float64: return 8;
+        default: return 0;
+        }
+    }
+
+    float colourScale(PlyType type)
+    {
+        switch (type)
+        {
+        case PlyType::UInt8: case PlyType::Int8: return 1.0f / 255.0f;
+        case PlyType::UInt16: case PlyType::Int16: return 1.0f / 65535.0f;
+        case PlyType::UInt32: case PlyType::Int32: return 1.0f / 4294967295.0f;
+        default: return 1.0f;
+        }
+    }
+
+    template<typename T>
+    T loadValue(const char* data, bool swapBytes)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, data, sizeof(T));
+        if (swapBytes)
+            std::reverse(bytes, bytes + sizeof(T));
+        T value;
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    float readBinaryValue(const char* data, PlyType type, bool swapBytes)
+    {
+        switch (type)
+        {
+        case PlyType::Int8: return static_cast<float>(loadValue<std::int8_t>(data, false));
+        case PlyType::UInt8: return static_cast<float>(loadValue<std::uint8_t>(data, false));
+        case PlyType::Int16: return static_cast<float>(loadValue<std::int16_t>(data, swapBytes));
+        case PlyType::UInt16: return static_cast<float>(loadValue<std::uint16_t>(data, swapBytes));
+        case PlyType::Int32: return static_cast<float>(loadValue<std::int32_t>(data, swapBytes));
+        case PlyType::UInt32: return static_cast<float>(loadValue<std::uint32_t>(data, swapBytes));
+        case PlyType::Float32: return loadValue<float>(data, swapBytes);
+        case PlyType::Float64: return static_cast<float>(loadValue<double>(data, swapBytes));
+        default: return 0.0f;
+        }
+    }
+
+    bool findVertexSources(const PlyElement& vertexElement, PropertySource (&sources)[TargetCount])
+    {
+        static const char* const names[TargetCount][3] = {
+            { "x", "x", "x" }, { "y", "y", "y" }, { "z", "z", "z" },
+            { "red", "r", "diffuse_red" }, { "green", "g", "diffuse_green" }, { "blue", "b", "diffuse_blue" },
+            { "nx", "normal_x", "nx" }, { "ny", "normal_y", "ny" }, { "nz", "normal_z", "nz" }
+        };
+        for (std::size_t i = 0; i < vertexElement.properties.size(); ++i)
+        {
+            const PlyProperty& property = vertexElement.properties[i];
+            for (int target = 0; target < TargetCount; ++target)
+            {
+                if (std::find(std::begin(names[target]), std::end(names[target]), property.name) == std::end(names[target]))
+                    continue;
+                sources[target].present = true;
+                sources[target].propertyIndex = i;
+                sources[target].type = property.type;
+                sources[target].offset = property.offset;
+                sources[target].scale = (target >= TargetRed && target <= TargetBlue) ? colourScale(property.type) : 1.0f;
+            }
+        }
+        return sources[TargetX].present && sources[TargetY].present && sources[TargetZ].present;
+    }
+
+    bool hasNormals(const PropertySource (&sources)[TargetCount])
+    {
+        return sources[TargetNormalX].present && sources[TargetNormalY].present && sources[TargetNormalZ].present;
+    }
+
+    PointCloudVertex makeVertex(const float (&values)[TargetCount])
+    {
+        return PointCloudVertex(DirectX::XMFLOAT3(values[TargetX], values[TargetY], values[TargetZ]),
+            DirectX::XMFLOAT3(values[TargetRed], values[TargetGreen], values[TargetBlue]));
+    }
+
+    DirectX::XMFLOAT3 makeNormal(const float (&values)[TargetCount])
+    {
+        return DirectX::XMFLOAT3(values[TargetNormalX], values[TargetNormalY], values[TargetNormalZ]);
+    }
+
+    std::unique_ptr<PointCloud> decodeBinaryVertices(const char* records, const PlyElement& vertexElement,
+        const PropertySource (&sources)[TargetCount], bool swapBytes)
+    {
+        std::vector<PointCloudVertex> vertices(vertexElement.count);
+        bool withNormals = hasNormals(sources);
+        std::vector<std::uint32_t> normals(withNormals ? vertexElement.count : 0);
+        std::size_t nTasks = (vertexElement.count + plyRecordsPerTask - 1) / plyRecordsPerTask;
+        std::vector<BoundsAccumulator> taskBounds(nTasks);
+
+        //Float positions stored back to back in host order can be copied as one block
+        bool packedPositions = !swapBytes && sources[TargetX].type == PlyType::Float32 && sources[TargetY].type == PlyType::Float32
+            && sources[TargetZ].type == PlyType::Float32 && sources[TargetY].offset == sources[TargetX].offset + 4
+            && sources[TargetZ].offset == sources[TargetX].offset + 8;
+
+        ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t begin = task * plyRecordsPerTask;
+            std::size_t end = std::min(begin + plyRecordsPerTask, vertexElement.count);
+            PointCloudVertex* out = vertices.data();
+            BoundsAccumulator& bounds = taskBounds[task];
+            OctahedralNormalWriter normalWriter(withNormals ? normals.data() + begin : nullptr);
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                const char* record = records + i * vertexElement.recordSize;
+                float values[TargetCount] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f };
+                int firstTarget = TargetX;
+                if (packedPositions)
+                {
+                    std::memcpy(values, record + sources[TargetX].offset, 3 * sizeof(float));
+                    firstTarget = TargetRed;
+                }
+                for (int target = firstTarget; target < TargetCount; ++target)
+                {
+                    if (sources[target].present)
+                        values[target] = readBinaryValue(record + sources[target].offset, sources[target].type, swapBytes) * sources[target].scale;
+                }
+                out[i] = makeVertex(values);
+                bounds.add(out[i]);
+                if (withNormals)
+                    normalWriter.push(makeNormal(values));
+            }
+            if (withNormals)
+                normalWriter.flush();
+        });
+
+        BoundsAccumulator bounds;
+        for (const auto& partialBounds : taskBounds)
+            bounds.merge(partialBounds);
+        auto pointCloud = std::make_unique<PointCloud>(std::move(vertices));
+        pointCloud->normals = std::move(normals);
+        pointCloud->bounds = bounds.result();
+        return pointCloud;
+    }
+
+    std::size_t parseAsciiVertexBlock(std::string_view block, const PlyElement& vertexElement, const PropertySource (&sources)[TargetCount],
+        PointCloudVertex* destination, std::uint32_t* normals, BoundsAccumulator& bounds)
+    {
+        //Property index -> target, so each token is parsed once in file order
+        int targetOfProperty[64];
+        std::size_t nProperties = std::min<std::size_t>(vertexElement.properties.size(), 64);
+        std::fill(targetOfProperty, targetOfProperty + nProperties, -1);
+        for (int target = 0; target < TargetCount; ++target)
+        {
+            if (sources[target].present && sources[target].propertyIndex < nProperties)
+                targetOfProperty[sources[target].propertyIndex] = target;
+        }
+
+        const char* cursor = block.data();
+        const char* last = block.data() + block.size();
+        PointCloudVertex* out = destination;
+        bool withNormals = hasNormals(sources);
+        OctahedralNormalWriter normalWriter(normals);
+        while (cursor < last)
+        {
+            const char* endOfLine = findNewline(cursor, last);
+            float values[TargetCount] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f };
+            const char* p = cursor;
+            bool valid = true;
+            for (std::size_t i = 0; i < nProperties && valid; ++i)
+            {
+                float value;
+                p = skipBlanks(p, endOfLine);
+                valid = parseFloatASC(p, endOfLine, value);
+                if (valid && targetOfProperty[i] >= 0)
+                    values[targetOfProperty[i]] = value * sources[targetOfProperty[i]].scale;
+            }
+            if (valid)
+            {
+                *out = makeVertex(values);
+                bounds.add(*out++);
+                if (withNormals)
+                    normalWriter.push(makeNormal(values));
+            }
+            cursor = endOfLine + 1;
+        }
+        if (withNormals)
+            normalWriter.flush();
+        return static_cast<std::size_t>(out - destination);
+    }
+
+    //Advances past nLines lines of text and returns the new offset.
+    std::size_t skipLines(std::string_view text, std::size_t offset, std::size_t nLines)
+    {
+        const char* cursor = text.data() + offset;
+        const char* last = text.data() + text.size();
+        for (std::size_t i = 0; i < nLines && cursor < last; ++i)
+            cursor = findNewline(cursor, last) + 1;
+        return static_cast<std::size_t>(std::min(cursor, last) - text.data());
+    }
+}
+
+bool parsePlyHeader(std::string_view text, PlyHeader& header)
+{
+    header = PlyHeader();
+    std::size_t lineStart = 0;
+    bool sawMagic = false;
+    bool sawFormat = false;
+
+    while (lineStart < text.size())
+    {
+        std::size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos)
+            return false;
+        std::string line(text.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+
+        if (!sawMagic)
+        {
+            if (keyword != "ply")
+                return false;
+            sawMagic = true;
+        }
+        else if (keyword == "format")
+        {
+            std::string format;
+            tokens >> format;
+            if (format == "ascii") header.format = PlyFormat::Ascii;
+            else if (format == "binary_little_endian") header.format = PlyFormat::BinaryLittleEndian;
+            else if (format == "binary_big_endian") header.format = PlyFormat::BinaryBigEndian;
+            else return false;
+            sawFormat = true;
+        }
+        else if (keyword == "element")
+        {
+            PlyElement element;
+            if (!(tokens >> element.name >> element.count))
+                return false;
+            element.recordSize = 0;
+            header.elements.push_back(element);
+        }
+        else if (keyword == "property")
+        {
+            if (header.elements.empty())
+                return false;
+            PlyElement& element = header.elements.back();
+            std::string typeName;
+            tokens >> typeName;
+            PlyProperty property;
+            if (typeName == "list")
+            {
+                std::string countType, itemType;
+                tokens >> countType >> itemType;
+                property.type = PlyType::List;
+            }
+            else if (!parsePlyType(typeName, property.type))
+                return false;
+            if (!(tokens >> property.name))
+                return false;
+            property.offset = element.recordSize;
+            element.properties.push_back(property);
+
+            bool fixedSize = std::none_of(element.properties.begin(), element.properties.end(),
+                [](const PlyProperty& p) { return p.type == PlyType::List; });
+            element.recordSize = fixedSize ? element.recordSize + plyTypeSize(property.type) : 0;
+        }
+        else if (keyword == "end_header")
+        {
+            header.bodyOffset = lineStart;
+            return sawFormat;
+        }
+        //"comment", "obj_info" and unknown keywords are ignored
+    }
+    return false;
+}
+
+std::unique_ptr<PointCloud> readPointCloudPLY(const std::filesystem::path& path)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return nullptr;
+
+    PlyHeader header;
+    if (!parsePlyHeader(file.view(), header))
+        return nullptr;
+
+    auto vertexElement = std::find_if(header.elements.begin(), header.elements.end(),
+        [](const PlyElement& element) { return element.name == "vertex"; });
+    if (vertexElement == header.elements.end())
+        return nullptr;
+
+    PropertySource sources[TargetCount];
+    if (!findVertexSources(*vertexElement, sources))
+        return nullptr;
+
+    if (header.format == PlyFormat::Ascii)
+    {
+        //Every element item is one line, so skipping earlier elements is a line count
+        std::size_t offset = header.bodyOffset;
+        for (auto element = header.elements.begin(); element != vertexElement; ++element)
+            offset = skipLines(file.view(), offset, element->count);
+        std::size_t vertexEnd = skipLines(file.view(), offset, vertexElement->count);
+
+        return parseLinesInParallel(file.view().substr(offset, vertexEnd - offset), hasNormals(sources),
+            [&](std::string_view block, PointCloudVertex* destination, std::uint32_t* normals, BoundsAccumulator& bounds) {
+                return parseAsciiVertexBlock(block, *vertexElement, sources, destination, normals, bounds);
+            });
+    }
+
+    //Binary records are only addressable if every element before the vertices has a fixed size
+    if (vertexElement->recordSize == 0)
+        return nullptr;
+    std::size_t offset = header.bodyOffset;
+    for (auto element = header.elements.begin(); element != vertexElement; ++element)
+    {
+        if (element->recordSize == 0)
+            return nullptr;
+        offset += element->recordSize * element->count;
+    }
+    if (offset > file.size() || vertexElement->count > (file.size() - offset) / vertexElement->recordSize)
+        return nullptr;
+
+    //Hosts are assumed little endian, as every platform Direct3D 12 runs on is
+    bool swapBytes = header.format == PlyFormat::BinaryBigEndian;
+    return decodeBinaryVertices(file.data() + offset, *vertexElement, sources, swapBytes);
+}
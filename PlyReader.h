@@ -0,0 +1,43 @@
+#pragma once
+#include "PointCloudVertex.h"
+#include "PointCloud.h"
+//C++
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, List };
+
+struct PlyProperty
+{
+	std::string name;
+	PlyType type;
+	std::size_t offset; //Byte offset inside a binary record
+};
+
+struct PlyElement
+{
+	std::string name;
+	std::size_t count;
+	std::vector<PlyProperty> properties;
+	std::size_t recordSize; //0 if the element has list properties and so no fixed size
+};
+
+struct PlyHeader
+{
+	PlyFormat format;
+	std::vector<PlyElement> elements;
+	std::size_t bodyOffset; //First byte after "end_header"
+};
+
+//Parses the header at the start of text. Returns false if it is not a well formed PLY header.
+bool parsePlyHeader(std::string_view text, PlyHeader& header);
+
+//Loads the "vertex" element of an ASCII or binary PLY file. x/y/z are required, red/green/blue (integer or float)
+//map onto the colour and default to white. nx/ny/nz, if all present, are kept as octahedral encoded normals.
+//Binary bodies are decoded in parallel over fixed size record ranges, each range reducing its own bounds.
+std::unique_ptr<PointCloud> readPointCloudPLY(const std::filesystem::path& path);
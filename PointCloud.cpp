@@ -0,0 +1,25 @@
+#include "PointCloud.h"
+//C++
+#include <utility>
+
+PointCloud::PointCloud(std::vector<PointCloudVertex>&& vertices)
+    : vertices(std::move(vertices))
+{
+}
+
+PointCloud::PointCloud(VertexArray&& vertices)
+    : vertices(std::move(vertices))
+{
+}
+
+const PointCloudBounds& PointCloud::tightBounds()
+{
+    if (!bounds)
+        bounds = calculateBounds(data(), size());
+    if (!bounds->minimalSphere)
+    {
+        bounds->sphere = calculateMinimumEnclosingSphere(data(), size());
+        bounds->minimalSphere = true;
+    }
+    return *bounds;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "PointCloudVertex.h"
+#include "Bounds.h"
+#include "VertexArray.h"
+#include "LodHierarchy.h"
+//C++
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+//A loaded cloud. The vertices are either owned or viewed directly inside a memory mapped cache file.
+class PointCloud
+{
+	VertexArray vertices;
+
+public:
+	//Set by loaders, which reduce the bounds while decoding, otherwise computed by the renderer.
+	std::optional<PointCloudBounds> bounds;
+	//Index each vertex had in the source file, empty while the vertices are still in file order.
+	std::vector<std::uint64_t> sourceOrder;
+	//Octahedral encoded unit normal of each vertex (see encodeOctahedral), empty if the cloud has none.
+	std::vector<std::uint32_t> normals;
+	//Source coordinates of the model space origin. Georeferenced positions are far too large for float, so their
+	//reader subtracts this in double precision first. Adding it back gives a position in the file's own units.
+	std::array<double, 3> origin = {};
+	//Level of detail hierarchy over the vertices, only set by loadPointCloud when asked for one.
+	std::unique_ptr<LodHierarchy> lod;
+
+	explicit PointCloud(std::vector<PointCloudVertex>&& vertices);
+	explicit PointCloud(VertexArray&& vertices);
+
+	//Bounds with the minimum enclosing sphere, which frames the cloud much more tightly than the circumsphere of the box
+	//loaders reduce. Fitting it takes several passes over the vertices, so it is only done the first time it is asked for.
+	const PointCloudBounds& tightBounds();
+
+	const PointCloudVertex* data() const { return vertices.data(); }
+	std::size_t size() const { return vertices.size(); }
+};
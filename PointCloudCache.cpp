@@ -0,0 +1,219 @@
+#include "PointCloudCache.h"
+//C++
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+    constexpr char cacheMagic[8] = { 'P', 'C', 'V', 'C', 'A', 'C', 'H', 'E' };
+    constexpr std::uint32_t cacheVersion = 8;
+    constexpr std::uint64_t payloadAlignment = 64;
+    constexpr std::size_t hashSampleSize = 64 << 10;
+
+    struct CacheHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t vertexSize;
+        std::uint32_t lodNodeSize;
+        std::uint64_t sourceSize;
+        std::int64_t sourceModifiedTime;
+        std::uint64_t sourceHash;
+        std::uint64_t nVertices;
+        std::uint64_t nNormals; //0 or nVertices, the encoded normals follow the vertices
+        //0 if no hierarchy is stored. Otherwise the vertices are in its order, and its coarse colours (nVertices of them)
+        //and then its nodes follow the normals.
+        std::uint64_t nLodNodes;
+        std::uint64_t payloadOffset;
+        PointCloudBounds bounds; //Plain data, so stored as is
+        BoundingBox lodCube;
+        double origin[3];
+    };
+
+    constexpr std::uint64_t payloadOffset = (sizeof(CacheHeader) + payloadAlignment - 1) / payloadAlignment * payloadAlignment;
+
+    std::uint64_t fnv1a(const char* data, std::size_t size, std::uint64_t hash = 14695981039346656037ull)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    //Only structural checks, enough that drawing and picking the nodes stays within the vertices and the nodes.
+    //Children must come after their parent, as they do breadth first, or walking down the tree could loop forever.
+    bool validLodNodes(const std::vector<LodNode>& nodes, std::uint64_t nVertices)
+    {
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            const LodNode& node = nodes[i];
+            std::uint64_t nChildren = 0;
+            for (std::uint8_t mask = node.childMask; mask != 0; mask &= mask - 1)
+                ++nChildren;
+            if (node.firstPoint > nVertices || node.nPoints > nVertices - node.firstPoint
+                || (nChildren != 0 && (node.firstChild <= i || node.firstChild + nChildren > nodes.size())))
+                return false;
+        }
+        return true;
+    }
+}
+
+std::optional<SourceFingerprint> fingerprintSource(const std::filesystem::path& sourcePath)
+{
+    std::error_code error;
+    std::uint64_t size = std::filesystem::file_size(sourcePath, error);
+    if (error)
+        return std::nullopt;
+    auto modifiedTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error)
+        return std::nullopt;
+
+    std::ifstream in(sourcePath, std::ios::binary);
+    if (!in)
+        return std::nullopt;
+    std::vector<char> sample(static_cast<std::size_t>(std::min<std::uint64_t>(size, hashSampleSize)));
+    std::uint64_t hash = fnv1a(reinterpret_cast<const char*>(&size), sizeof(size));
+    in.read(sample.data(), sample.size());
+    hash = fnv1a(sample.data(), static_cast<std::size_t>(in.gcount()), hash);
+    if (size > hashSampleSize)
+    {
+        in.seekg(static_cast<std::streamoff>(size - sample.size()));
+        in.read(sample.data(), sample.size());
+        hash = fnv1a(sample.data(), static_cast<std::size_t>(in.gcount()), hash);
+    }
+    if (in.bad())
+        return std::nullopt;
+
+    return SourceFingerprint{ size, static_cast<std::int64_t>(modifiedTime.time_since_epoch().count()), hash };
+}
+
+std::filesystem::path cachePathFor(const std::filesystem::path& sourcePath)
+{
+    std::filesystem::path cachePath = sourcePath;
+    cachePath += ".pcvcache";
+    return cachePath;
+}
+
+bool writePointCloudCache(const std::filesystem::path& cachePath, const SourceFingerprint& fingerprint, const PointCloud& pointCloud)
+{
+    CacheHeader header = {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.vertexSize = sizeof(PointCloudVertex);
+    header.lodNodeSize = sizeof(LodNode);
+    header.sourceSize = fingerprint.size;
+    header.sourceModifiedTime = fingerprint.modifiedTime;
+    header.sourceHash = fingerprint.hash;
+    header.nVertices = pointCloud.size();
+    header.nNormals = pointCloud.lod ? pointCloud.lod->normals.size() : pointCloud.normals.size();
+    header.nLodNodes = pointCloud.lod ? pointCloud.lod->nodes.size() : 0;
+    header.payloadOffset = payloadOffset;
+    header.bounds = pointCloud.bounds ? *pointCloud.bounds : calculateBounds(pointCloud.data(), pointCloud.size());
+    if (pointCloud.lod)
+        header.lodCube = pointCloud.lod->cube;
+    std::copy(pointCloud.origin.begin(), pointCloud.origin.end(), header.origin);
+
+    //Written under a temporary name so a crash never leaves a truncated cache that looks valid
+    std::filesystem::path temporaryPath = cachePath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        char padding[payloadAlignment] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(padding, payloadOffset - sizeof(header));
+        if (pointCloud.lod)
+        {
+            const LodHierarchy& lod = *pointCloud.lod;
+            out.write(reinterpret_cast<const char*>(lod.vertices.data()), lod.vertices.size() * sizeof(PointCloudVertex));
+            out.write(reinterpret_cast<const char*>(lod.normals.data()), lod.normals.size() * sizeof(std::uint32_t));
+            out.write(reinterpret_cast<const char*>(lod.coarseColours.data()), lod.coarseColours.size() * sizeof(std::uint32_t));
+            out.write(reinterpret_cast<const char*>(lod.nodes.data()), lod.nodes.size() * sizeof(LodNode));
+        }
+        else
+        {
+            out.write(reinterpret_cast<const char*>(pointCloud.data()), pointCloud.size() * sizeof(PointCloudVertex));
+            out.write(reinterpret_cast<const char*>(pointCloud.normals.data()), pointCloud.normals.size() * sizeof(std::uint32_t));
+        }
+        if (!out)
+        {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<PointCloud> openPointCloudCache(const std::filesystem::path& cachePath, const SourceFingerprint& fingerprint,
+    bool withLod)
+{
+    MappedFile file;
+    if (!file.open(cachePath) || file.size() < payloadOffset)
+        return nullptr;
+
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion
+        || header.vertexSize != sizeof(PointCloudVertex) || header.lodNodeSize != sizeof(LodNode) || header.payloadOffset != payloadOffset)
+        return nullptr;
+    if (header.sourceSize != fingerprint.size || header.sourceModifiedTime != fingerprint.modifiedTime
+        || header.sourceHash != fingerprint.hash)
+        return nullptr;
+    if (header.nVertices > (file.size() - payloadOffset) / sizeof(PointCloudVertex))
+        return nullptr;
+    std::uint64_t normalsOffset = payloadOffset + header.nVertices * sizeof(PointCloudVertex);
+    if ((header.nNormals != 0 && header.nNormals != header.nVertices)
+        || header.nNormals > (file.size() - normalsOffset) / sizeof(std::uint32_t))
+        return nullptr;
+    std::uint64_t coarseColoursOffset = normalsOffset + header.nNormals * sizeof(std::uint32_t);
+    std::uint64_t nodesOffset = coarseColoursOffset + (header.nLodNodes != 0 ? header.nVertices * sizeof(std::uint32_t) : 0);
+    if (header.nLodNodes != 0 && (nodesOffset > file.size() || header.nLodNodes > (file.size() - nodesOffset) / sizeof(LodNode)))
+        return nullptr;
+
+    //The cloud and its hierarchy view the same vertices in place
+    auto mapping = std::make_shared<const MappedFile>(std::move(file));
+    const char* data = mapping->data();
+    std::unique_ptr<LodHierarchy> lod;
+    if (withLod && header.nLodNodes != 0)
+    {
+        lod = std::make_unique<LodHierarchy>();
+        //The nodes follow 4 byte payloads, so they may not be aligned for LodNode
+        lod->nodes.resize(static_cast<std::size_t>(header.nLodNodes));
+        std::memcpy(lod->nodes.data(), data + nodesOffset, lod->nodes.size() * sizeof(LodNode));
+        if (!validLodNodes(lod->nodes, header.nVertices))
+            return nullptr;
+        lod->vertices = VertexArray(mapping, static_cast<std::size_t>(payloadOffset), static_cast<std::size_t>(header.nVertices));
+        const std::uint32_t* coarseColours = reinterpret_cast<const std::uint32_t*>(data + coarseColoursOffset);
+        lod->coarseColours.assign(coarseColours, coarseColours + header.nVertices);
+        const std::uint32_t* normals = reinterpret_cast<const std::uint32_t*>(data + normalsOffset);
+        lod->normals.assign(normals, normals + header.nNormals);
+        lod->cube = header.lodCube;
+    }
+
+    //The normals are a sixth of the vertices' size, so they are copied out rather than given a view of their own
+    const std::uint32_t* normals = reinterpret_cast<const std::uint32_t*>(data + normalsOffset);
+    std::vector<std::uint32_t> normalsCopy(normals, normals + header.nNormals);
+    auto pointCloud = std::make_unique<PointCloud>(VertexArray(std::move(mapping), static_cast<std::size_t>(payloadOffset),
+        static_cast<std::size_t>(header.nVertices)));
+    pointCloud->normals = std::move(normalsCopy);
+    pointCloud->bounds = header.bounds;
+    std::copy(header.origin, header.origin + 3, pointCloud->origin.begin());
+    pointCloud->lod = std::move(lod);
+    return pointCloud;
+}
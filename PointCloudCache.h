@@ -0,0 +1,32 @@
+#pragma once
+#include "PointCloud.h"
+//C++
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+//Identifies the source file a cache was built from.
+struct SourceFingerprint
+{
+	std::uint64_t size;
+	std::int64_t modifiedTime;
+	std::uint64_t hash; //FNV-1a over the size and the first and last 64 KiB
+};
+
+std::optional<SourceFingerprint> fingerprintSource(const std::filesystem::path& sourcePath);
+
+//Sidecar file next to the source, e.g. "scan.asc" -> "scan.asc.pcvcache".
+std::filesystem::path cachePathFor(const std::filesystem::path& sourcePath);
+
+//Writes header, vertices and any normals to a temporary file and renames it into place. Returns false on any I/O error.
+//If the cloud has its lod set, the hierarchy's vertices and normals are written in place of the cloud's, followed by its
+//coarse colours and nodes, so the next launch doesn't have to rebuild it.
+bool writePointCloudCache(const std::filesystem::path& cachePath, const SourceFingerprint& fingerprint, const PointCloud& pointCloud);
+
+//Maps the cache if its header matches this build's vertex and node layouts and the fingerprint, otherwise returns nullptr.
+//The returned cloud views the vertex payload in place and carries the stored bounds, origin and a copy of the stored normals.
+//With withLod a stored hierarchy is read into its lod, which stays null if the cache has none. The hierarchy's vertices
+//are the cloud's, so it views them in the same mapping, its coarse colours and normals are copied.
+std::unique_ptr<PointCloud> openPointCloudCache(const std::filesystem::path& cachePath, const SourceFingerprint& fingerprint,
+	bool withLod = false);
@@ -0,0 +1,357 @@
+#include "PointCloudLoader.h"
+#include "MappedFile.h"
+#include "PointCloudCache.h"
+#include "PlyReader.h"
+#include "LasReader.h"
+#include "AsciiParser.h"
+#include "AsciiSchema.h"
+#include "ThreadPool.h"
+#include "BoundedQueue.h"
+//C++
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <thread>
+
+std::vector<std::string_view> splitAtLineBoundaries(std::string_view text, std::size_t nChunks)
+{
+    std::vector<std::string_view> chunks;
+    nChunks = std::max<std::size_t>(nChunks, 1);
+    std::size_t chunkSize = text.size() / nChunks;
+    std::size_t begin = 0;
+
+    for (std::size_t i = 0; i < nChunks && begin < text.size(); ++i)
+    {
+        std::size_t end = text.size();
+        if (i + 1 < nChunks)
+        {
+            //Snap the nominal boundary forward to the start of the next line
+            std::size_t endOfLineIndex = text.find('\n', std::max(begin, (i + 1) * chunkSize));
+            end = (endOfLineIndex == std::string_view::npos) ? text.size() : endOfLineIndex + 1;
+        }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+void processPointCloudChunkASC(std::string_view chunk, const AsciiSchema& schema, std::vector<PointCloudVertex>& verts,
+    std::vector<std::uint32_t>& normals, BoundsAccumulator& bounds)
+{
+    std::size_t offset = verts.size();
+    std::size_t nLines = countLinesASC(chunk.data(), chunk.data() + chunk.size());
+    bool withNormals = hasNormals(schema);
+    verts.resize(offset + nLines);
+    if (withNormals)
+        normals.resize(offset + nLines);
+    std::size_t nParsed = selectAsciiBlockParser(schema)(chunk, verts.data() + offset, withNormals ? normals.data() + offset : nullptr,
+        schema, bounds);
+    verts.resize(offset + nParsed);
+    if (withNormals)
+        normals.resize(offset + nParsed);
+}
+
+std::unique_ptr<PointCloud> parseLinesInParallel(std::string_view text, bool withNormals,
+    const std::function<std::size_t(std::string_view, PointCloudVertex*, std::uint32_t*, BoundsAccumulator&)>& parseBlock)
+{
+    //Many small blocks rather than one per thread, so a slow block only delays its own worker
+    std::size_t nBlocks = (text.size() + asciiBlockSize - 1) / asciiBlockSize;
+    std::vector<std::string_view> blocks = splitAtLineBoundaries(text, nBlocks);
+    ThreadPool& pool = ThreadPool::shared();
+
+    //Pass 1: count lines per block, their prefix sum gives every block its slot in the final array
+    std::vector<std::size_t> blockOffsets(blocks.size() + 1, 0);
+    pool.parallelFor(blocks.size(), [&](std::size_t i) {
+        blockOffsets[i + 1] = countLinesASC(blocks[i].data(), blocks[i].data() + blocks[i].size());
+    });
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+        blockOffsets[i + 1] += blockOffsets[i];
+
+    //Pass 2: parse every block straight into its slot, reducing its bounds on the way
+    auto vertices = std::make_unique<std::vector<PointCloudVertex>>(blockOffsets.back());
+    std::vector<std::uint32_t> normals(withNormals ? blockOffsets.back() : 0);
+    std::vector<std::size_t> blockCounts(blocks.size());
+    std::vector<BoundsAccumulator> blockBounds(blocks.size());
+    pool.parallelFor(blocks.size(), [&](std::size_t i) {
+        blockCounts[i] = parseBlock(blocks[i], vertices->data() + blockOffsets[i], withNormals ? normals.data() + blockOffsets[i] : nullptr,
+            blockBounds[i]);
+    });
+
+    //Blank or malformed lines leave gaps at the end of their block's slot, close them in place
+    std::size_t nVertices = blockCounts.empty() ? 0 : blockCounts[0];
+    for (std::size_t i = 1; i < blocks.size(); ++i)
+    {
+        if (nVertices != blockOffsets[i])
+        {
+            std::memmove(vertices->data() + nVertices, vertices->data() + blockOffsets[i], blockCounts[i] * sizeof(PointCloudVertex));
+            if (withNormals)
+                std::memmove(normals.data() + nVertices, normals.data() + blockOffsets[i], blockCounts[i] * sizeof(std::uint32_t));
+        }
+        nVertices += blockCounts[i];
+    }
+    vertices->resize(nVertices);
+    normals.resize(withNormals ? nVertices : 0);
+
+    BoundsAccumulator bounds;
+    for (const auto& partialBounds : blockBounds)
+        bounds.merge(partialBounds);
+    auto pointCloud = std::make_unique<PointCloud>(std::move(*vertices));
+    pointCloud->normals = std::move(normals);
+    pointCloud->bounds = bounds.result();
+    return pointCloud;
+}
+
+std::unique_ptr<PointCloud> readPointCloudASC(const std::filesystem::path& path, const std::vector<ColumnRole>& columns)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return nullptr;
+
+    std::optional<AsciiSchema> schema = detectAsciiSchema(file.view().substr(0, schemaSampleSize), columns);
+    if (!schema)
+        return std::make_unique<PointCloud>(std::vector<PointCloudVertex>()); //Nothing that looks like a record
+
+    AsciiBlockParser parser = selectAsciiBlockParser(*schema);
+    return parseLinesInParallel(file.view().substr(schema->headerLength), hasNormals(*schema),
+        [&](std::string_view block, PointCloudVertex* destination, std::uint32_t* normals, BoundsAccumulator& bounds) {
+            return parser(block, destination, normals, *schema, bounds);
+        });
+}
+
+namespace
+{
+    //Text buffer owned by the streaming pipeline. Only the first parseLength bytes end on a line boundary.
+    struct IoBuffer
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t parseLength = 0;
+        std::size_t sequence = 0;
+    };
+
+    struct VertexBlock
+    {
+        std::size_t sequence = 0;
+        std::size_t bufferIndex = 0; //The text it was parsed from, held until the block is appended
+        std::size_t textLength = 0; //Bytes of that text
+        std::vector<PointCloudVertex> vertices;
+        std::vector<std::uint32_t> normals; //Empty unless the schema has normals
+        BoundsAccumulator bounds;
+    };
+}
+
+std::unique_ptr<PointCloud> readPointCloudASCStreamed(const std::filesystem::path& path, const std::vector<ColumnRole>& columns,
+    std::size_t memoryBudget)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return nullptr;
+
+    std::string sample(schemaSampleSize, '\0');
+    in.read(sample.data(), sample.size());
+    sample.resize(static_cast<std::size_t>(in.gcount()));
+    std::optional<AsciiSchema> schema = detectAsciiSchema(sample, columns);
+    if (!schema)
+        return std::make_unique<PointCloud>(std::vector<PointCloudVertex>()); //Nothing that looks like a record
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(schema->headerLength));
+
+    //The budget is split into fixed buffers: at least two (of 64 KiB or more) so reading and parsing can overlap
+    std::size_t bufferSize = std::min(asciiBlockSize, std::max<std::size_t>(memoryBudget / 2, 64 << 10));
+    std::size_t nBuffers = std::max<std::size_t>(memoryBudget / bufferSize, 2);
+    unsigned int nParsers = std::max(1U, std::min(std::thread::hardware_concurrency(), static_cast<unsigned int>(nBuffers)));
+
+    std::vector<IoBuffer> buffers(nBuffers);
+    BoundedQueue<std::size_t> freeBuffers(nBuffers);
+    BoundedQueue<std::size_t> filledBuffers(nBuffers);
+    BoundedQueue<VertexBlock> completedBlocks(nBuffers);
+    for (std::size_t i = 0; i < nBuffers; ++i)
+    {
+        buffers[i].data.reset(new char[bufferSize]); //Left uninitialised, pages are only committed once read into
+        freeBuffers.tryPush(i);
+    }
+
+    std::atomic<bool> readFailed = false;
+
+    //Reader stage: fill free buffers, carrying the partial last line over to the next one
+    std::thread reader([&] {
+        std::string carry;
+        std::size_t sequence = 0;
+        while (in)
+        {
+            std::size_t bufferIndex;
+            freeBuffers.pop(bufferIndex);
+
+            IoBuffer& buffer = buffers[bufferIndex];
+            std::memcpy(buffer.data.get(), carry.data(), carry.size());
+            in.read(buffer.data.get() + carry.size(), bufferSize - carry.size());
+            std::size_t filled = carry.size() + static_cast<std::size_t>(in.gcount());
+            if (in.bad())
+                readFailed = true;
+
+            //A line longer than the whole buffer can't be carried, it is handed over as is
+            std::size_t parseLength = filled;
+            if (in)
+            {
+                std::string_view text(buffer.data.get(), filled);
+                std::size_t endOfLineIndex = text.rfind('\n');
+                if (endOfLineIndex != std::string_view::npos)
+                    parseLength = endOfLineIndex + 1;
+            }
+            carry.assign(buffer.data.get() + parseLength, filled - parseLength);
+
+            buffer.parseLength = parseLength;
+            buffer.sequence = sequence++;
+            filledBuffers.push(bufferIndex);
+        }
+        filledBuffers.close();
+    });
+
+    //Parser stages: turn filled buffers into vertex blocks. The last one to run out of buffers ends the final stage.
+    std::vector<std::thread> parsers;
+    std::atomic<unsigned int> nRunningParsers = nParsers;
+    for (unsigned int i = 0; i < nParsers; ++i)
+    {
+        parsers.emplace_back([&] {
+            std::size_t bufferIndex;
+            while (filledBuffers.pop(bufferIndex))
+            {
+                IoBuffer& buffer = buffers[bufferIndex];
+                VertexBlock block;
+                block.sequence = buffer.sequence;
+                block.bufferIndex = bufferIndex;
+                block.textLength = buffer.parseLength;
+                processPointCloudChunkASC(std::string_view(buffer.data.get(), buffer.parseLength), *schema, block.vertices, block.normals,
+                    block.bounds);
+                completedBlocks.push(std::move(block));
+            }
+            if (--nRunningParsers == 0)
+                completedBlocks.close();
+        });
+    }
+
+    //Final stage on the calling thread: append blocks in file order, holding back any that finish early.
+    //Records can be far longer than their shortest form, so rather than reserving for the worst case up front the
+    //output is grown to the record count projected from the text appended so far. That is about the whole file after
+    //the first block, and is only redone if later records turn out shorter.
+    auto combinedVerts = std::make_unique<std::vector<PointCloudVertex>>();
+    std::vector<std::uint32_t> combinedNormals;
+    std::error_code sizeError;
+    std::uintmax_t fileSize = std::filesystem::file_size(path, sizeError);
+    std::uintmax_t textSize = sizeError ? 0 : fileSize - std::min<std::uintmax_t>(fileSize, schema->headerLength);
+    std::uintmax_t appendedText = 0;
+    auto reserveFor = [&](std::size_t nNeeded) {
+        //Without the file size the vector's own growth has to do
+        if (nNeeded <= combinedVerts->capacity() || textSize == 0)
+            return;
+        std::uintmax_t nReserved = nNeeded;
+        if (appendedText < textSize)
+        {
+            double projected = static_cast<double>(nNeeded) * static_cast<double>(textSize) / static_cast<double>(appendedText);
+            nReserved = static_cast<std::uintmax_t>(projected + projected / 16.0); //Slack for shorter records further on
+            //A PTS count is only a hint: it narrows the reserve until the records outnumber it, then it is ignored
+            if (schema->declaredCount && *schema->declaredCount >= nNeeded)
+                nReserved = std::min<std::uintmax_t>(nReserved, *schema->declaredCount);
+        }
+        nReserved = std::max<std::uintmax_t>(nReserved, nNeeded);
+        combinedVerts->reserve(static_cast<std::size_t>(nReserved));
+        if (hasNormals(*schema))
+            combinedNormals.reserve(static_cast<std::size_t>(nReserved));
+    };
+    //A block only returns its text buffer once it has been appended, so the blocks waiting here and in flight
+    //never outnumber the buffers even if one block is much slower than those after it
+    std::map<std::size_t, VertexBlock> pendingBlocks;
+    BoundsAccumulator bounds;
+    std::size_t nextSequence = 0;
+    VertexBlock block;
+    while (completedBlocks.pop(block))
+    {
+        bounds.merge(block.bounds); //Order doesn't matter for the bounds
+        pendingBlocks.emplace(block.sequence, std::move(block));
+        for (auto next = pendingBlocks.begin(); next != pendingBlocks.end() && next->first == nextSequence; next = pendingBlocks.erase(next))
+        {
+            appendedText += next->second.textLength;
+            reserveFor(combinedVerts->size() + next->second.vertices.size());
+            combinedVerts->insert(combinedVerts->end(), next->second.vertices.begin(), next->second.vertices.end());
+            combinedNormals.insert(combinedNormals.end(), next->second.normals.begin(), next->second.normals.end());
+            freeBuffers.push(next->second.bufferIndex);
+            ++nextSequence;
+        }
+    }
+
+    reader.join();
+    for (auto& t : parsers) {
+        t.join();
+    }
+
+    if (readFailed)
+        return nullptr;
+    auto pointCloud = std::make_unique<PointCloud>(std::move(*combinedVerts));
+    pointCloud->normals = std::move(combinedNormals);
+    pointCloud->bounds = bounds.result();
+    return pointCloud;
+}
+
+std::unique_ptr<PointCloud> loadPointCloud(const std::filesystem::path& path, bool streamed, const std::vector<ColumnRole>& columns,
+    bool withLod)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    auto attachLod = [withLod](std::unique_ptr<PointCloud> pointCloud) {
+        if (withLod && pointCloud && !pointCloud->lod)
+        {
+            BoundingBox box = pointCloud->bounds ? pointCloud->bounds->box : calculateBounds(pointCloud->data(), pointCloud->size()).box;
+            pointCloud->lod = buildLodHierarchy(pointCloud->data(), pointCloud->size(), box,
+                pointCloud->normals.empty() ? nullptr : pointCloud->normals.data());
+        }
+        return pointCloud;
+    };
+
+    //Binary formats are already cheap to decode so they aren't cached
+    if (extension == ".ply")
+        return attachLod(readPointCloudPLY(path));
+    if (extension == ".las")
+        return attachLod(readPointCloudLAS(path));
+
+    //The cache only describes the detected schema, an explicit one always reparses
+    std::optional<SourceFingerprint> fingerprint = fingerprintSource(path);
+    if (!fingerprint)
+        return nullptr;
+    bool useCache = columns.empty();
+
+    std::filesystem::path cachePath = cachePathFor(path);
+    std::unique_ptr<PointCloud> pointCloud;
+    if (useCache)
+    {
+        if (std::unique_ptr<PointCloud> cachedPointCloud = openPointCloudCache(cachePath, *fingerprint, withLod))
+        {
+            if (!withLod || cachedPointCloud->lod)
+                return cachedPointCloud;
+            //Cached without a hierarchy. The points are copied out so the cache is unmapped before it is rewritten with one.
+            pointCloud = std::make_unique<PointCloud>(std::vector<PointCloudVertex>(cachedPointCloud->data(),
+                cachedPointCloud->data() + cachedPointCloud->size()));
+            pointCloud->normals = std::move(cachedPointCloud->normals);
+            pointCloud->bounds = cachedPointCloud->bounds;
+            pointCloud->origin = cachedPointCloud->origin;
+        }
+    }
+
+    if (!pointCloud)
+        pointCloud = streamed ? readPointCloudASCStreamed(path, columns) : readPointCloudASC(path, columns);
+    pointCloud = attachLod(std::move(pointCloud));
+    if (!pointCloud)
+        return nullptr;
+
+    if (useCache)
+    {
+        //Fitted while the slow path is taken anyway, so launches that hit the cache get the tight sphere for free
+        pointCloud->tightBounds();
+        writePointCloudCache(cachePath, *fingerprint, *pointCloud); //A failed write only costs the next launch a reparse
+    }
+    return pointCloud;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "PointCloudVertex.h"
+#include "PointCloud.h"
+#include "AsciiSchema.h"
+//C++
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+//Nominal size of the newline aligned blocks handed to the loader's worker threads.
+constexpr std::size_t asciiBlockSize = 4 << 20;
+//Default cap on the text buffered by readPointCloudASCStreamed.
+constexpr std::size_t defaultStreamingBudget = 256 << 20;
+//Bytes from the start of an ASCII file inspected by detectAsciiSchema.
+constexpr std::size_t schemaSampleSize = 64 << 10;
+
+//Splits text into at most nChunks views whose boundaries fall directly after a '\n'.
+//The views alias the input, so no text is copied.
+std::vector<std::string_view> splitAtLineBoundaries(std::string_view text, std::size_t nChunks);
+
+//Appends the records in chunk to verts, growing it once to the chunk's line count, and adds them to bounds.
+//If the schema has normals their octahedral encodings are appended to normals in step with verts.
+void processPointCloudChunkASC(std::string_view chunk, const AsciiSchema& schema, std::vector<PointCloudVertex>& verts,
+	std::vector<std::uint32_t>& normals, BoundsAccumulator& bounds);
+
+//Splits text into newline aligned blocks and runs parseBlock on them on the shared thread pool.
+//Lines are counted first so every block parses directly into its slot of one preallocated array.
+//parseBlock writes at most one vertex per line, adds each to the block's bounds and returns how many it wrote.
+//With withNormals it also writes each vertex's encoded normal to the matching slot of a second array, otherwise that
+//pointer is null. The block bounds are merged into the cloud's bounds.
+std::unique_ptr<PointCloud> parseLinesInParallel(std::string_view text, bool withNormals,
+	const std::function<std::size_t(std::string_view, PointCloudVertex*, std::uint32_t*, BoundsAccumulator&)>& parseBlock);
+
+//Memory maps an ASCII point cloud and parses it with parseLinesInParallel. Returns nullptr if the file can't be opened.
+//The schema is detected from the first lines, columns optionally overrides the detected column roles.
+std::unique_ptr<PointCloud> readPointCloudASC(const std::filesystem::path& path,
+	const std::vector<ColumnRole>& columns = {});
+
+//Reads and parses concurrently through a fixed pool of I/O buffers connected by bounded queues, idle stages sleep.
+//Buffered text stays within memoryBudget (minimum two 64 KiB buffers), so files larger than RAM can be loaded.
+//A buffer is only reused once its records are appended in file order, which also caps the parsed blocks held back.
+std::unique_ptr<PointCloud> readPointCloudASCStreamed(const std::filesystem::path& path,
+	const std::vector<ColumnRole>& columns = {}, std::size_t memoryBudget = defaultStreamingBudget);
+
+//Loads a cloud chosen by extension: ".ply" and ".las" go to their binary readers, anything else is treated as ASCII.
+//For ASCII the source's binary cache is used if it is still valid, otherwise the text is parsed (streamed or mapped)
+//and a fresh cache is written for the next launch. An explicit columns list bypasses the cache. Returns nullptr on failure.
+//With withLod the cloud comes with its level of detail hierarchy set, read from the cache when it holds one, otherwise
+//built with the defaults of buildLodHierarchy and cached with the points.
+std::unique_ptr<PointCloud> loadPointCloud(const std::filesystem::path& path, bool streamed,
+	const std::vector<ColumnRole>& columns = {}, bool withLod = false);
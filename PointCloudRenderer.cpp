@@ -1,21 +1,33 @@
 #include "PointCloudRenderer.h"
+#include "OctahedralNormal.h"
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
 
+//Root constants after the MVP: the headlight direction and the weight of the lighting, 0 when there are no normals
+constexpr UINT nLightingConstants = 4;
+//Then 1 while drawing inner nodes that stand in for their children, so they take their cells' mean colours
+constexpr UINT coarseConstant = sizeof(XMMATRIX) / 4 + nLightingConstants;
+
 PointCloudRenderer::PointCloudRenderer(HWND windowHandle, UINT rtvWidth, UINT rtvHeight, BOOL screenTearingEnabled,
-    std::shared_ptr<std::vector<PointCloudVertex>> pointCloudVertices)
+    const PointCloud& pointCloud, LodHierarchy&& hierarchy, std::optional<OccluderSplat> occlusionCulling)
 {
     PointCloudRenderer::windowHandle = windowHandle;
     PointCloudRenderer::rtvWidth = rtvWidth;
     PointCloudRenderer::rtvHeight = rtvHeight;
     PointCloudRenderer::screenTearingEnabled = screenTearingEnabled;
     PointCloudRenderer::fsbw = false;
-    nVerts = pointCloudVertices->size();
+    PointCloudRenderer::occlusionCulling = occlusionCulling;
+    nVerts = pointCloud.size();
 
     initDirect3D();
     createPointCloudPipeline();
-    CalculateMinimumBoundingSphere(*pointCloudVertices);
-    uploadPointCloudDataToGPU(*pointCloudVertices);
+    PointCloudBounds bounds = pointCloud.bounds ? *pointCloud.bounds : calculateBounds(pointCloud.data(), pointCloud.size());
+    viewingSphere = bounds.sphere;
+    //Upload the points grouped by level of detail node, each frame then draws a cut through the hierarchy
+    uploadPointCloudDataToGPU(hierarchy.vertices.data(), hierarchy.normals, hierarchy.coarseColours, hierarchy.vertices.size());
+    lodNodes = std::move(hierarchy.nodes);
+    lodVertices = std::move(hierarchy.vertices);
+    picker.build(lodNodes, lodVertices.data());
 
     //DeltaTime
     previousFrameTime = std::chrono::steady_clock::now();
@@ -30,6 +42,8 @@ void PointCloudRenderer::draw()
 
     cmdList->SetPipelineState(PSO.Get());
     cmdList->SetGraphicsRootSignature(rootSignature.Get());
+    float lighting[nLightingConstants] = { headlightDirection.x, headlightDirection.y, headlightDirection.z, hasNormals ? 1.0f : 0.0f };
+    cmdList->SetGraphicsRoot32BitConstants(0, nLightingConstants, lighting, sizeof(XMMATRIX) / 4);
     cmdList->RSSetViewports(1, &viewportDescription);
     cmdList->RSSetScissorRects(1, &scissorRec);
 
@@ -39,8 +53,6 @@ void PointCloudRenderer::draw()
 
     cmdList->OMSetRenderTargets(1, &activeBackBufferDescriptorHandle, FALSE, &dsvDescriptorHeapHandle);
     cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_POINTLIST);
-    cmdList->IASetVertexBuffers(0, 1, &vertexBufferView);
-    cmdList->SetGraphicsRoot32BitConstants(0, sizeof(MVP) / 4, &MVP, 0);
 
     CD3DX12_RESOURCE_BARRIER present2RTV = CD3DX12_RESOURCE_BARRIER::Transition(backBufferResources[activeBuffer].Get(),
         D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
@@ -52,7 +64,38 @@ void PointCloudRenderer::draw()
 
     cmdList->ClearRenderTargetView(activeBackBufferDescriptorHandle, Colors::Black, 0, NULL);
     cmdList->ClearDepthStencilView(dsvDescriptorHeapHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, NULL);
-    cmdList->DrawInstanced(nVerts, 1, 0, 0);
+    //Pick this frame's cut through the hierarchy and draw its ranges segment by segment
+    LodView view = { MVP, FOV, rtvHeight };
+    const std::vector<DrawRange>* ranges = &lodTraversal.select(lodNodes, view, pointBudget);
+    //Then drop the nodes hidden behind the nearest ones
+    if (occlusionCulling)
+        ranges = &occlusionCuller.cull(lodNodes, lodTraversal.selectedNodes(), lodTraversal.selectedRanges(), lodVertices.data(), MVP,
+            rtvWidth, rtvHeight, *occlusionCulling);
+    std::size_t boundSegment = vertexBufferSegments.size();
+    std::optional<bool> boundCoarse;
+    splitRangesAtSegments(segmentLayout, *ranges, [&](std::size_t segmentIndex, std::uint32_t firstVertex, std::uint32_t nVertices, bool coarse) {
+        if (segmentIndex != boundSegment)
+        {
+            //Fold the segment's dequantization into the transform, so the shader only converts the packed integers
+            const VertexBufferSegment& segment = vertexBufferSegments[segmentIndex];
+            const QuantizationBlock& block = segment.quantization;
+            XMMATRIX dequantization = XMMatrixMultiply(XMMatrixScaling(block.step.x, block.step.y, block.step.z),
+                XMMatrixTranslation(block.origin.x, block.origin.y, block.origin.z));
+            XMMATRIX segmentMVP = XMMatrixMultiply(dequantization, MVP);
+            cmdList->SetGraphicsRoot32BitConstants(0, sizeof(segmentMVP) / 4, &segmentMVP, 0);
+            D3D12_VERTEX_BUFFER_VIEW views[3] = { segment.vertexBufferView, hasNormals ? segment.normalBufferView : defaultNormalBufferView,
+                segment.coarseColourBufferView };
+            cmdList->IASetVertexBuffers(0, 3, views);
+            boundSegment = segmentIndex;
+        }
+        if (boundCoarse != coarse)
+        {
+            float coarseWeight = coarse ? 1.0f : 0.0f;
+            cmdList->SetGraphicsRoot32BitConstants(0, 1, &coarseWeight, coarseConstant);
+            boundCoarse = coarse;
+        }
+        cmdList->DrawInstanced(nVertices, 1, firstVertex, 0);
+    });
 
     cmdList->ResourceBarrier(1, &RTV2Present);
     cmdList->Close();
@@ -69,41 +112,107 @@ void PointCloudRenderer::draw()
     WaitForSingleObject(swapChainPresentedEvent, INFINITE);
 }
 
-void PointCloudRenderer::uploadPointCloudDataToGPU(const std::vector<PointCloudVertex>& vertices)
+void PointCloudRenderer::uploadPointCloudDataToGPU(const PointCloudVertex* vertices, const std::vector<std::uint32_t>& normals,
+    const std::vector<std::uint32_t>& coarseColours, std::size_t nVertices)
 {
-    UINT64 bufferSize = sizeof(PointCloudVertex) * vertices.size();
+    hasNormals = !normals.empty();
+    if (!hasNormals)
+    {
+        //Small enough to live in the upload heap, the shader ignores it anyway while the lighting weight is 0
+        D3D12_RESOURCE_DESC normalResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(std::uint32_t));
+        HANDLE_RETURN(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+            &normalResourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&defaultNormalResource)));
+        std::uint32_t* defaultNormal = nullptr;
+        CD3DX12_RANGE noRead(0, 0);
+        HANDLE_RETURN(defaultNormalResource->Map(0, &noRead, reinterpret_cast<void**>(&defaultNormal)));
+        *defaultNormal = encodeOctahedral(XMFLOAT3(0.0f, 0.0f, 1.0f));
+        defaultNormalResource->Unmap(0, nullptr);
+        defaultNormalBufferView.BufferLocation = defaultNormalResource->GetGPUVirtualAddress();
+        defaultNormalBufferView.SizeInBytes = sizeof(std::uint32_t);
+        defaultNormalBufferView.StrideInBytes = 0;
+    }
 
-    D3D12_SUBRESOURCE_DATA vertexSubResourceData = {};
-    vertexSubResourceData.pData = vertices.data();
-    vertexSubResourceData.RowPitch = bufferSize;
-    vertexSubResourceData.SlicePitch = vertexSubResourceData.RowPitch;
+    std::vector<VertexSegment> segments = partitionIntoSegments(nVertices, sizeof(QuantizedVertex));
+    segmentLayout = segments;
+    if (segments.empty())
+        return;
 
-    //Transfer data to VRAM
+    //One staging buffer sized for the largest segment is reused, so the upload heap never holds the whole cloud.
+    //A segment's coarse colours are staged after its vertices, then its normals.
+    UINT64 stagingCoarseColoursOffset = sizeof(QuantizedVertex) * static_cast<UINT64>(segments.front().nVertices);
+    UINT64 stagingNormalsOffset = stagingCoarseColoursOffset + sizeof(std::uint32_t) * static_cast<UINT64>(segments.front().nVertices);
+    UINT64 stagingBufferSize = stagingNormalsOffset + (hasNormals ? sizeof(std::uint32_t) * static_cast<UINT64>(segments.front().nVertices) : 0);
     ComPtr<ID3D12Resource> vertexStagingBufferResource;
-    D3D12_RESOURCE_DESC vertexResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
-
-    HANDLE_RETURN(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
-        &vertexResourceDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&vertexResource)));
-
+    D3D12_RESOURCE_DESC stagingResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(stagingBufferSize);
     HANDLE_RETURN(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
-        &vertexResourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&vertexStagingBufferResource)));
-
-    cmdList->Reset(allocators[activeBuffer].Get(), nullptr);
-    UpdateSubresources(cmdList.Get(), vertexResource.Get(), vertexStagingBufferResource.Get(), 0, 0, 1, &vertexSubResourceData);
-    cmdList->Close();
-
+        &stagingResourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&vertexStagingBufferResource)));
 
-    //Execute Command queue
-    ID3D12CommandList* lists[] = { cmdList.Get() };
-    cmdQueue->ExecuteCommandLists(1, lists);
-    flushGPU();
+    //Vertices are quantized straight into the mapped staging buffer
+    QuantizedVertex* stagingVertices = nullptr;
+    CD3DX12_RANGE noRead(0, 0);
+    HANDLE_RETURN(vertexStagingBufferResource->Map(0, &noRead, reinterpret_cast<void**>(&stagingVertices)));
 
-    //Create vertex buffer view
-    vertexBufferView.BufferLocation = vertexResource->GetGPUVirtualAddress();
-    vertexBufferView.SizeInBytes = bufferSize;
-    vertexBufferView.StrideInBytes = sizeof(PointCloudVertex);
+    vertexBufferSegments.clear();
+    for (const auto& segment : segments)
+    {
+        UINT64 bufferSize = sizeof(QuantizedVertex) * static_cast<UINT64>(segment.nVertices);
+        const PointCloudVertex* segmentVertices = vertices + segment.firstVertex;
+
+        VertexBufferSegment bufferSegment = {};
+        bufferSegment.quantization = computeQuantizationBlock(segmentVertices, segment.nVertices);
+        quantizeVertices(segmentVertices, segment.nVertices, bufferSegment.quantization, stagingVertices);
+        UINT64 normalBufferSize = sizeof(std::uint32_t) * static_cast<UINT64>(segment.nVertices);
+        UINT64 coarseColourBufferSize = sizeof(std::uint32_t) * static_cast<UINT64>(segment.nVertices);
+        std::memcpy(reinterpret_cast<std::byte*>(stagingVertices) + stagingCoarseColoursOffset, coarseColours.data() + segment.firstVertex,
+            static_cast<std::size_t>(coarseColourBufferSize));
+        D3D12_RESOURCE_DESC coarseColourResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(coarseColourBufferSize);
+        HANDLE_RETURN(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+            &coarseColourResourceDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&bufferSegment.coarseColourResource)));
+        if (hasNormals)
+        {
+            std::memcpy(reinterpret_cast<std::byte*>(stagingVertices) + stagingNormalsOffset, normals.data() + segment.firstVertex,
+                static_cast<std::size_t>(normalBufferSize));
+            D3D12_RESOURCE_DESC normalResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(normalBufferSize);
+            HANDLE_RETURN(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+                &normalResourceDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&bufferSegment.normalResource)));
+        }
 
+        //Transfer data to VRAM
+        D3D12_RESOURCE_DESC vertexResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
+        HANDLE_RETURN(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+            &vertexResourceDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&bufferSegment.vertexResource)));
+
+        cmdList->Reset(allocators[activeBuffer].Get(), nullptr);
+        cmdList->CopyBufferRegion(bufferSegment.vertexResource.Get(), 0, vertexStagingBufferResource.Get(), 0, bufferSize);
+        cmdList->CopyBufferRegion(bufferSegment.coarseColourResource.Get(), 0, vertexStagingBufferResource.Get(), stagingCoarseColoursOffset,
+            coarseColourBufferSize);
+        if (hasNormals)
+            cmdList->CopyBufferRegion(bufferSegment.normalResource.Get(), 0, vertexStagingBufferResource.Get(), stagingNormalsOffset, normalBufferSize);
+        cmdList->Close();
+
+        //Execute Command queue, waiting before the staging buffer is reused
+        ID3D12CommandList* lists[] = { cmdList.Get() };
+        cmdQueue->ExecuteCommandLists(1, lists);
+        flushGPU();
+
+        //Create vertex buffer view
+        bufferSegment.vertexBufferView.BufferLocation = bufferSegment.vertexResource->GetGPUVirtualAddress();
+        bufferSegment.vertexBufferView.SizeInBytes = static_cast<UINT>(bufferSize);
+        bufferSegment.vertexBufferView.StrideInBytes = sizeof(QuantizedVertex);
+        bufferSegment.coarseColourBufferView.BufferLocation = bufferSegment.coarseColourResource->GetGPUVirtualAddress();
+        bufferSegment.coarseColourBufferView.SizeInBytes = static_cast<UINT>(coarseColourBufferSize);
+        bufferSegment.coarseColourBufferView.StrideInBytes = sizeof(std::uint32_t);
+        if (hasNormals)
+        {
+            bufferSegment.normalBufferView.BufferLocation = bufferSegment.normalResource->GetGPUVirtualAddress();
+            bufferSegment.normalBufferView.SizeInBytes = static_cast<UINT>(normalBufferSize);
+            bufferSegment.normalBufferView.StrideInBytes = sizeof(std::uint32_t);
+        }
+        bufferSegment.nVerts = segment.nVertices;
+        vertexBufferSegments.push_back(bufferSegment);
+    }
 
+    vertexStagingBufferResource->Unmap(0, nullptr);
 }
 
 void PointCloudRenderer::createPointCloudPipeline()
@@ -151,13 +260,17 @@ void PointCloudRenderer::createPointCloudPipeline()
 
     //Input layout
 
-    D3D12_INPUT_ELEMENT_DESC vertexColourPositionLayoutDescription[2] =
+    //Normals come from a second stream, the two 16-bit octahedral coordinates arrive in the shader as snorm floats.
+    //The coarse colours come from a third.
+    D3D12_INPUT_ELEMENT_DESC vertexColourPositionLayoutDescription[4] =
     {
-        {"POSITION",0,DXGI_FORMAT_R32G32B32_FLOAT,0,D3D12_APPEND_ALIGNED_ELEMENT,D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,0},
-        {"COLOR",0,DXGI_FORMAT_R32G32B32_FLOAT,0,D3D12_APPEND_ALIGNED_ELEMENT,D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,0}
+        {"POSITION",0,DXGI_FORMAT_R32G32_UINT,0,D3D12_APPEND_ALIGNED_ELEMENT,D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,0},
+        {"COLOR",0,DXGI_FORMAT_R8G8B8A8_UNORM,0,D3D12_APPEND_ALIGNED_ELEMENT,D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,0},
+        {"NORMAL",0,DXGI_FORMAT_R16G16_SNORM,1,0,D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,0},
+        {"COLOR",1,DXGI_FORMAT_R8G8B8A8_UNORM,2,0,D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,0}
     };
 
-    D3D12_INPUT_LAYOUT_DESC layoutDescription = { vertexColourPositionLayoutDescription,2 };
+    D3D12_INPUT_LAYOUT_DESC layoutDescription = { vertexColourPositionLayoutDescription,4 };
 
     //Render Target View format
     D3D12_RT_FORMAT_ARRAY rtvFormat;
@@ -178,7 +291,7 @@ void PointCloudRenderer::createPointCloudPipeline()
         );
 
     CD3DX12_ROOT_PARAMETER1  rootSignatureParameters[1];
-    rootSignatureParameters[0].InitAsConstants(sizeof(XMMATRIX) / 4, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+    rootSignatureParameters[0].InitAsConstants(coarseConstant + 1, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDescription;
     rootSignatureDescription.Init_1_1(1, rootSignatureParameters, 0, 0, rootSignatureFlags);
 
@@ -417,8 +530,14 @@ void PointCloudRenderer::recaculateMVP()
 {
     //Update Model matrix
     modelMatrix = XMMatrixIdentity();
-    //Update View matrix
-    float radius = viewingSphere.radius * 2.0f;
+    //Update View matrix, orbiting at the distance where the bounding sphere just fills the default field of view.
+    //The distance ignores FOV itself, so changing FOV still zooms.
+    constexpr float framingFOV = 45.0f;
+    float aspectRatio = static_cast<float>(rtvWidth) / static_cast<float>(rtvHeight);
+    float verticalHalfFOV = XMConvertToRadians(framingFOV) * 0.5f;
+    float horizontalHalfFOV = std::atan(std::tan(verticalHalfFOV) * aspectRatio);
+    float sphereRadius = std::max(viewingSphere.radius, 1e-3f);
+    float radius = sphereRadius / XMScalarSin(std::min(verticalHalfFOV, horizontalHalfFOV));
     float theta = XMConvertToRadians(pitch + 90.0f);
     float phi = XMConvertToRadians(yaw); 
     float x = radius * XMScalarSin(theta) * XMScalarCos(phi);
@@ -428,46 +547,24 @@ void PointCloudRenderer::recaculateMVP()
     XMVECTOR target = XMVectorSet(viewingSphere.centre.x, viewingSphere.centre.y, viewingSphere.centre.z, 1.0f);
     XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 1.0f);
     viewMatrix = XMMatrixLookAtLH(cameraPos, target, up);
-    //Update Projection matrix
-    float aspectRatio = static_cast<float>(rtvWidth) / static_cast<float>(rtvHeight);
-    projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(FOV), aspectRatio, 0.1, 100);
+    //Update Projection matrix, with clip planes hugging the sphere
+    float nearZ = std::max(radius - sphereRadius, radius * 1e-3f);
+    float farZ = radius + sphereRadius;
+    projectionMatrix = XMMatrixPerspectiveFovLH(XMConvertToRadians(FOV), aspectRatio, nearZ, farZ);
     MVP = XMMatrixMultiply(XMMatrixMultiply(modelMatrix, viewMatrix), projectionMatrix);
+    //The model matrix is the identity, so the view direction needs no transforming
+    XMStoreFloat3(&headlightDirection, XMVector3Normalize(XMVectorSubtract(cameraPos, target)));
 
 }
 
 
 
-void PointCloudRenderer::CalculateMinimumBoundingSphere(const std::vector<PointCloudVertex>& vertices) {
-    //Caclulate centroid
-    XMVECTOR sumPos = XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-
-    for (const auto& vert : vertices) {
-        XMVECTOR pos = XMLoadFloat3(&vert.modelPos);
-        sumPos = XMVectorAdd(sumPos, pos);
-    }
-
-    sumPos = XMVectorScale(sumPos, 1.0f / vertices.size());
-
-    XMFLOAT3 centre;
-    XMStoreFloat3(&centre, sumPos);
-    XMVECTOR centroidVec = XMLoadFloat3(&centre);
-
-    //Calcualte radius 
-    float maxDistance = 0.0f;
-    for (const auto& vert : vertices) {
-        XMVECTOR pos = XMLoadFloat3(&vert.modelPos);
-        XMVECTOR distance = XMVector3Length(XMVectorSubtract(pos, centroidVec));
-        float distanceValue;
-        XMStoreFloat(&distanceValue, distance);
-        maxDistance = std::max(maxDistance, distanceValue);
-
-    }
-
-    viewingSphere = { centre,maxDistance };
+std::optional<PickedPoint> PointCloudRenderer::pickPoint(int pixelX, int pixelY)
+{
+    PickRay ray = pickRay(MVP, static_cast<float>(pixelX), static_cast<float>(pixelY), rtvWidth, rtvHeight);
+    return picker.pick(lodNodes, lodVertices.data(), ray);
 }
 
-
-
 std::optional<std::vector<std::byte>> PointCloudRenderer::loadByteCode(std::filesystem::path path)
 {
     if (!std::filesystem::exists(path))
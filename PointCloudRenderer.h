@@ -8,6 +8,14 @@
 #include "d3dx12.h" 
 #include<DirectXMath.h>
 #include <DirectXColors.h>
+#include "PointCloudVertex.h"
+#include "PointCloud.h"
+#include "QuantizedVertex.h"
+#include "VertexSegments.h"
+#include "LodHierarchy.h"
+#include "LodTraversal.h"
+#include "OcclusionCulling.h"
+#include "Picking.h"
 
 
 //C++
@@ -15,13 +23,9 @@
 #include<fstream>
 #include <vector>
 #include <optional>
-
-struct PointCloudVertex {
-	DirectX::XMFLOAT3 modelPos;
-	DirectX::XMFLOAT3 colour;
-	PointCloudVertex(const DirectX::XMFLOAT3& pos, const DirectX::XMFLOAT3& col)
-		: modelPos(pos), colour(col) {}
-};
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 //State and functionality for point cloud.
 //State and functionality for pipeline
@@ -49,7 +53,6 @@ class PointCloudRenderer
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> cmdList;
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsvHeap;
 	Microsoft::WRL::ComPtr<ID3D12Resource> dsvResource;
-	D3D12_VERTEX_BUFFER_VIEW vertexBufferView = {};
 	//Window State
 	HWND windowHandle;
 	//Synchronisation State
@@ -67,20 +70,38 @@ class PointCloudRenderer
 	DirectX::XMMATRIX viewMatrix;
 	DirectX::XMMATRIX modelMatrix;
 	//Point Cloud State
-	struct ViewingSphere
+	BoundingSphere viewingSphere;
+	struct VertexBufferSegment
 	{
-		DirectX::XMFLOAT3 centre;
-		float radius;
+		Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource;
+		D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+		Microsoft::WRL::ComPtr<ID3D12Resource> normalResource; //Octahedral encoded normals, null if the cloud has none
+		D3D12_VERTEX_BUFFER_VIEW normalBufferView;
+		Microsoft::WRL::ComPtr<ID3D12Resource> coarseColourResource; //Packed RGBA8, see LodHierarchy::coarseColours
+		D3D12_VERTEX_BUFFER_VIEW coarseColourBufferView;
+		UINT nVerts;
+		QuantizationBlock quantization; //Each segment is quantized against its own bounding box
 	};
-	ViewingSphere viewingSphere;
-	Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource;
-	unsigned int nVerts;
+	std::vector<VertexBufferSegment> vertexBufferSegments;
+	std::vector<VertexSegment> segmentLayout; //Where each buffer segment starts in the hierarchy's vertex order
+	bool hasNormals = false;
+	//Bound in place of the segments' normals when the cloud has none, its stride of 0 repeats one normal for every vertex
+	Microsoft::WRL::ComPtr<ID3D12Resource> defaultNormalResource;
+	D3D12_VERTEX_BUFFER_VIEW defaultNormalBufferView;
+	DirectX::XMFLOAT3 headlightDirection; //Towards the camera in model space, lights the points when they have normals
+	std::uint64_t nVerts;
+	std::vector<LodNode> lodNodes;
+	LodTraversal lodTraversal;
+	VertexArray lodVertices; //The uploaded vertices, kept for picking and occlusion culling
+	PointPicker picker;
+	std::optional<OccluderSplat> occlusionCulling; //Empty if every selected node is drawn
+	OcclusionCuller occlusionCuller;
 
 	void initDirect3D();
-	void uploadPointCloudDataToGPU(const std::vector<PointCloudVertex>& vertices);
+	void uploadPointCloudDataToGPU(const PointCloudVertex* vertices, const std::vector<std::uint32_t>& normals,
+		const std::vector<std::uint32_t>& coarseColours, std::size_t nVertices);
 	void createPointCloudPipeline();
 	std::optional<std::vector<std::byte>> loadByteCode(std::filesystem::path path);
-	void CalculateMinimumBoundingSphere(const std::vector<PointCloudVertex>& vertices);
 
 public:
 	//Exposed Camera state
@@ -91,6 +112,7 @@ public:
 	int oldMousePosY = 0.0f;
 	bool leftMouseButtonHeld = false;
 	DirectX::XMMATRIX MVP;
+	std::uint64_t pointBudget = defaultPointBudget; //Most points drawn per frame
 	std::chrono::steady_clock::time_point previousFrameTime;
 	std::chrono::duration<float, std::ratio<1, 1>> deltaTime;
 	bool firstMove = true;
@@ -102,13 +124,16 @@ public:
 	RECT previousClientArea;
 
 	~PointCloudRenderer();
+	//hierarchy must be built over pointCloud's points, its nodes and vertices are moved into the renderer.
 	PointCloudRenderer(HWND windowHandle, UINT rtvWidth, UINT rtvHeight, BOOL screenTearingEnabled,
-		std::shared_ptr<std::vector<PointCloudVertex>> pointCloudVertices);
+		const PointCloud& pointCloud, LodHierarchy&& hierarchy, std::optional<OccluderSplat> occlusionCulling = std::nullopt);
 	void flushGPU();
 	void uploadNewDepthStencilBufferAndCreateView(UINT newWidth, UINT newHeight);
 	void resizeRenderTargetView(UINT newWidth, UINT newHeight);
 	void PointCloudRenderer::resizeViewPort(UINT newWidth, UINT newHeight);
 	void recaculateMVP();
+	//Point under pixel (pixelX, pixelY) of the last frame's view, if any lies within defaultPickPixelRadius of it
+	std::optional<PickedPoint> pickPoint(int pixelX, int pixelY);
 	void draw();
 #if defined(DEBUG)
 	void outputDebugLayer();
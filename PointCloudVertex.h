@@ -0,0 +1,11 @@
+#pragma once
+#include <DirectXMath.h>
+
+//Vertex layout shared by the loaders and the renderer's input assembler.
+struct PointCloudVertex {
+	DirectX::XMFLOAT3 modelPos;
+	DirectX::XMFLOAT3 colour;
+	PointCloudVertex() = default;
+	PointCloudVertex(const DirectX::XMFLOAT3& pos, const DirectX::XMFLOAT3& col)
+		: modelPos(pos), colour(col) {}
+};
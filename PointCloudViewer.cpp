@@ -6,11 +6,21 @@
 //C++
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
 #include <tchar.h>
 #include <thread>
 // Helper headers 
 #include "PointCloudRenderer.h"
+#include "PointCloudLoader.h"
+#include "SpaceFillingCurve.h"
+#include "VoxelFilter.h"
+#include "OutlierFilter.h"
+#include "NormalEstimation.h"
 #include "debug.h"
 //DirectXMath
 #include<DirectXMath.h>
@@ -18,6 +28,7 @@
 
 HWND createWindow(LONG clientAreaWidth, LONG clientAreaHeight, HINSTANCE hInstance, TCHAR* windowName);
 std::unique_ptr<PointCloudRenderer> pcr;
+std::array<double, 3> pointCloudOrigin; //Added to picked positions to show them in the file's coordinates
 
 
 void onUpdate()
@@ -124,7 +135,20 @@ LRESULT WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
             }
             break;
         case WM_LBUTTONDOWN:
-            pcr->leftMouseButtonHeld = true;
+            {
+                pcr->leftMouseButtonHeld = true;
+                //Show the clicked point in the title bar
+                std::optional<PickedPoint> picked = pcr->pickPoint(GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+                if (!picked)
+                    break;
+                const PointCloudVertex& vertex = picked->vertex;
+                std::ostringstream title;
+                title << std::fixed << std::setprecision(3) << "Point Cloud Viewer - (" << vertex.modelPos.x + pointCloudOrigin[0]
+                    << ", " << vertex.modelPos.y + pointCloudOrigin[1] << ", " << vertex.modelPos.z + pointCloudOrigin[2]
+                    << ") RGB(" << std::lround(vertex.colour.x * 255.0f) << ", " << std::lround(vertex.colour.y * 255.0f)
+                    << ", " << std::lround(vertex.colour.z * 255.0f) << ")";
+                SetWindowTextA(hWnd, title.str().c_str());
+            }
             break;
         case WM_LBUTTONUP: //or if mouse leaves the screen
             pcr->leftMouseButtonHeld = false;
@@ -153,104 +177,154 @@ LRESULT WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     return 0;
 }
 
-void processPointCloudChunkASC(const std::string &chunk, std::vector<PointCloudVertex>&verts)
-{
-    verts.reserve(chunk.size()/64); //approximate number of verts
-
-    float x, y, z;
-    int r, g, b;
-    float nx, ny, nz;
-    std::istringstream in(chunk);
-
-    while (in >> x >> y >> z >> r >> g >> b >> nx >> ny >> nz) {
-        verts.emplace_back(
-            DirectX::XMFLOAT3(x, y, z),
-            DirectX::XMFLOAT3(r / 255.0f, g / 255.0f, b / 255.0f)
-        );
-    }
-}
-
-std::unique_ptr<std::vector<PointCloudVertex>> readPointCloudASC(std::string path)
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nCmdShow)
 {
-    std::filesystem::path objPath = path;
-    if(!std::filesystem::exists(objPath))
-        return nullptr;
-    std::filesystem::path filePath(objPath);
 
-    auto size = std::filesystem::file_size(objPath);
-    std::ifstream in(filePath, std::ios::binary);
-    unsigned int nThreads = std::min(4U, std::thread::hardware_concurrency());
-    if (nThreads < 0)
-        nThreads = 1;
-
-    std::vector<std::vector<PointCloudVertex>> threadVertices(nThreads);
-
-    unsigned int chunkSize = size / nThreads;
-    unsigned int remainder = size % nThreads;
-
-    std::vector<std::string>chunks(nThreads);
-    int endOfLineIndex = 0;
+    constexpr LONG defaultClientAreaWidth = 960;
+    constexpr LONG defaultClientAreaHeight = 540;
+    HWND windowHandle = createWindow(defaultClientAreaWidth,defaultClientAreaHeight,hInstance,_T("Point Cloud Viewer"));
 
-    for (int i = 0; i < nThreads; ++i)
+    //Command line: <point-cloud> [--schema x,y,z,...] [--order morton|hilbert] [--budget points] [--occlusion on|lossy|off] [--voxel size] [--outliers deviations] [--normals file|estimate|off]
+    std::string commandLine = lpCmdLine;
+    std::size_t firstOption = commandLine.find("--");
+    std::string pointCloudPath = commandLine.substr(0, firstOption);
+    pointCloudPath.erase(pointCloudPath.find_last_not_of(' ') + 1);
+    std::vector<ColumnRole> columns;
+    std::optional<CurveType> order;
+    std::uint64_t pointBudget = defaultPointBudget;
+    std::optional<OccluderSplat> occlusionCulling;
+    float voxelSize = 0.0f;
+    float outlierDeviations = 0.0f;
+    std::string normals = "file";
+    std::istringstream options(firstOption == std::string::npos ? std::string() : commandLine.substr(firstOption));
+    std::string option, value;
+    while (options >> option)
     {
-        chunks[i].resize(chunkSize + (i == (nThreads - 1) ? remainder : 0));
-        in.read(chunks[i].data(), chunkSize + (i == (nThreads - 1) ? remainder : 0));
-
-        if (i > 0 || endOfLineIndex >= chunks[0].length())
+        options >> value;
+        if (option == "--schema")
+        {
+            if (!parseColumnRoles(value, columns))
+            {
+                displayErrorMessage("Invalid schema \"" + value + "\", expected a comma separated list such as x,y,z,_,r,g,b.");
+                return 1;
+            }
+        }
+        else if (option == "--order" && (value == "morton" || value == "hilbert"))
         {
-            chunks[i] = chunks[i - 1].substr(endOfLineIndex, chunks[i - 1].length() - endOfLineIndex) + chunks[i];
-            chunks[i - 1] = chunks[i - 1].substr(0, endOfLineIndex);
+            order = value == "morton" ? CurveType::Morton : CurveType::Hilbert;
+        }
+        else if (option == "--budget")
+        {
+            std::istringstream budget(value);
+            if (!(budget >> pointBudget) || pointBudget == 0)
+            {
+                displayErrorMessage("Invalid point budget \"" + value + "\", expected a positive number of points.");
+                return 1;
+            }
+        }
+        else if (option == "--voxel")
+        {
+            std::istringstream size(value);
+            if (!(size >> voxelSize) || !(voxelSize > 0.0f))
+            {
+                displayErrorMessage("Invalid voxel size \"" + value + "\", expected a positive length.");
+                return 1;
+            }
+        }
+        else if (option == "--outliers")
+        {
+            std::istringstream deviations(value);
+            if (!(deviations >> outlierDeviations) || !(outlierDeviations > 0.0f))
+            {
+                displayErrorMessage("Invalid outlier threshold \"" + value + "\", expected a positive number of standard deviations.");
+                return 1;
+            }
+        }
+        else if (option == "--normals" && (value == "file" || value == "estimate" || value == "off"))
+        {
+            normals = value;
+        }
+        else if (option == "--occlusion" && (value == "on" || value == "lossy" || value == "off"))
+        {
+            if (value == "off")
+                occlusionCulling.reset();
+            else
+                occlusionCulling = value == "on" ? OccluderSplat::Point : OccluderSplat::Cell;
+        }
+        else
+        {
+            displayErrorMessage("Invalid option \"" + option + " " + value + "\".");
+            return 1;
         }
-
-        endOfLineIndex = chunks[i].rfind('\n');
-        endOfLineIndex = (endOfLineIndex == std::string::npos) ? 0 : endOfLineIndex + 1;
     }
-   
-    std::vector<std::thread> threads;
-
 
+    //Try Load data to SysRam
     auto start = std::chrono::steady_clock::now();
-    for(int i = 0; i < nThreads; ++i)
-        threads.push_back(std::thread(processPointCloudChunkASC,chunks[i],std::ref(threadVertices[i])));
-
-    for (auto& t : threads) {
-        t.join();
+    //Stream files that won't fit in free memory instead of mapping them whole
+    MEMORYSTATUSEX memoryStatus = {};
+    memoryStatus.dwLength = sizeof(MEMORYSTATUSEX);
+    std::error_code fileSizeError;
+    auto fileSize = std::filesystem::file_size(pointCloudPath, fileSizeError);
+    bool streamed = !fileSizeError && GlobalMemoryStatusEx(&memoryStatus) && fileSize > memoryStatus.ullAvailPhys / 2;
+    //The hierarchy is cached with the points unless a later stage changes them or their order
+    bool withLod = !order && outlierDeviations == 0.0f && voxelSize == 0.0f && normals == "file";
+    std::unique_ptr<PointCloud> pointCloud = loadPointCloud(pointCloudPath, streamed, columns, withLod);
+    if (!pointCloud) 
+    {
+        displayErrorMessage("Failed to load data from " + pointCloudPath + ".");
+        return 1;
     }
-
-    auto combinedVerts = std::make_unique<std::vector<PointCloudVertex>>();;
-
-    for (const auto& vec : threadVertices) {
-        combinedVerts->insert(combinedVerts->end(), vec.begin(), vec.end());
+    //Optionally drop isolated noise before anything is fitted to the points
+    if (outlierDeviations > 0.0f)
+    {
+        pointCloud = removeStatisticalOutliers(*pointCloud, defaultOutlierNeighbours, outlierDeviations);
+        if (!pointCloud)
+        {
+            displayErrorMessage("The point cloud is too large for outlier removal.");
+            return 1;
+        }
     }
-
-    auto end = std::chrono::steady_clock::now();
-    auto time = std::chrono::duration_cast<std::chrono::seconds>(end - start);
-    displayErrorMessage("Point cloud loaded took: " + std::to_string(time.count())+"s.");
-
-
-    return combinedVerts;
-}
-
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, int nCmdShow)
-{
-
-    constexpr LONG defaultClientAreaWidth = 960;
-    constexpr LONG defaultClientAreaHeight = 540;
-    HWND windowHandle = createWindow(defaultClientAreaWidth,defaultClientAreaHeight,hInstance,_T("Point Cloud Viewer"));
-
-    //Try Load data to SysRam
-    std::shared_ptr<std::vector<PointCloudVertex>> vertices = readPointCloudASC(lpCmdLine);
-    if (!vertices) 
+    //Optionally thin oversampled scans down to one point per voxel
+    if (voxelSize > 0.0f)
     {
-        displayErrorMessage("Failed to load data from " + std::string(lpCmdLine) + ".");
+        pointCloud = voxelDownsample(*pointCloud, voxelSize);
+        if (!pointCloud)
+        {
+            displayErrorMessage("Voxel size " + std::to_string(voxelSize) + " is too small for the point cloud's extent.");
+            return 1;
+        }
+    }
+    //Optionally replace or drop the normals that shade the points, after thinning so fewer have to be fitted
+    if (normals == "off")
+        pointCloud->normals.clear();
+    else if (normals == "estimate" && !estimateNormals(*pointCloud, pointCloud->normals))
+    {
+        displayErrorMessage("The point cloud is too large for normal estimation.");
         return 1;
     }
-    UINT64 bufferSize = sizeof(PointCloudVertex) * vertices->size();
+    //Optionally lay the points out along a space filling curve, which keeps neighbours together in memory
+    if (order)
+        pointCloud = reorderAlongCurve(*pointCloud, *order);
+    //Group the final points by level of detail node, keeping a chosen curve order within each node
+    std::unique_ptr<LodHierarchy> hierarchy = std::move(pointCloud->lod);
+    if (!hierarchy)
+    {
+        BoundingBox box = pointCloud->bounds ? pointCloud->bounds->box : calculateBounds(pointCloud->data(), pointCloud->size()).box;
+        hierarchy = buildLodHierarchy(pointCloud->data(), pointCloud->size(), box,
+            pointCloud->normals.empty() ? nullptr : pointCloud->normals.data(), defaultLodLeafSize, order.has_value());
+    }
+    //The renderer frames the final points, so filtered out points never cost a fit of the tight sphere
+    pointCloud->tightBounds();
+    auto end = std::chrono::steady_clock::now();
+    auto time = std::chrono::duration_cast<std::chrono::seconds>(end - start);
+    displayErrorMessage("Point cloud loaded took: " + std::to_string(time.count())+"s.");
 
     //Try create Renderer
     try 
     {
-        pcr = std::make_unique<PointCloudRenderer>(windowHandle, defaultClientAreaWidth, defaultClientAreaHeight, TRUE, vertices);
+        pcr = std::make_unique<PointCloudRenderer>(windowHandle, defaultClientAreaWidth, defaultClientAreaHeight, TRUE, *pointCloud,
+            std::move(*hierarchy), occlusionCulling);
+        pcr->pointBudget = pointBudget;
     }
     catch (const std::exception& e)
     {
@@ -258,7 +332,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine,
         return 1;
     }
     
-    vertices.reset();
+    pointCloudOrigin = pointCloud->origin;
+    pointCloud.reset();
 
     ShowWindow(windowHandle, SW_SHOW);
 
@@ -0,0 +1,109 @@
+#include "QuantizedVertex.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+using namespace DirectX;
+
+namespace
+{
+    constexpr std::size_t quantizeVerticesPerTask = 1 << 16;
+
+    std::uint32_t quantizeAxis(float value, float origin, float inverseStep)
+    {
+        float q = std::round((value - origin) * inverseStep);
+        return static_cast<std::uint32_t>(std::clamp(q, 0.0f, static_cast<float>(quantizedPositionMax)));
+    }
+
+    std::uint32_t quantizeChannel(float value)
+    {
+        return static_cast<std::uint32_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    }
+}
+
+QuantizationBlock computeQuantizationBlock(const PointCloudVertex* vertices, std::size_t nVertices)
+{
+    std::size_t nTasks = (nVertices + quantizeVerticesPerTask - 1) / quantizeVerticesPerTask;
+    std::vector<XMFLOAT3> taskMin(nTasks), taskMax(nTasks);
+
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t begin = task * quantizeVerticesPerTask;
+        std::size_t end = std::min(begin + quantizeVerticesPerTask, nVertices);
+        XMVECTOR minimum = XMLoadFloat3(&vertices[begin].modelPos);
+        XMVECTOR maximum = minimum;
+        for (std::size_t i = begin + 1; i < end; ++i)
+        {
+            XMVECTOR pos = XMLoadFloat3(&vertices[i].modelPos);
+            minimum = XMVectorMin(minimum, pos);
+            maximum = XMVectorMax(maximum, pos);
+        }
+        XMStoreFloat3(&taskMin[task], minimum);
+        XMStoreFloat3(&taskMax[task], maximum);
+    });
+
+    if (nTasks == 0)
+        return { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f) };
+
+    XMVECTOR minimum = XMLoadFloat3(&taskMin[0]);
+    XMVECTOR maximum = XMLoadFloat3(&taskMax[0]);
+    for (std::size_t task = 1; task < nTasks; ++task)
+    {
+        minimum = XMVectorMin(minimum, XMLoadFloat3(&taskMin[task]));
+        maximum = XMVectorMax(maximum, XMLoadFloat3(&taskMax[task]));
+    }
+
+    QuantizationBlock block;
+    XMStoreFloat3(&block.origin, minimum);
+    XMStoreFloat3(&block.step, XMVectorScale(XMVectorSubtract(maximum, minimum), 1.0f / quantizedPositionMax));
+    return block;
+}
+
+void quantizeVertices(const PointCloudVertex* vertices, std::size_t nVertices, const QuantizationBlock& block,
+    QuantizedVertex* destination)
+{
+    //A flat axis has a zero step, every vertex then quantizes to 0 on it
+    float inverseStep[3];
+    const float step[3] = { block.step.x, block.step.y, block.step.z };
+    for (int axis = 0; axis < 3; ++axis)
+        inverseStep[axis] = step[axis] > 0.0f ? 1.0f / step[axis] : 0.0f;
+
+    std::size_t nTasks = (nVertices + quantizeVerticesPerTask - 1) / quantizeVerticesPerTask;
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t begin = task * quantizeVerticesPerTask;
+        std::size_t end = std::min(begin + quantizeVerticesPerTask, nVertices);
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const PointCloudVertex& vertex = vertices[i];
+            std::uint64_t x = quantizeAxis(vertex.modelPos.x, block.origin.x, inverseStep[0]);
+            std::uint64_t y = quantizeAxis(vertex.modelPos.y, block.origin.y, inverseStep[1]);
+            std::uint64_t z = quantizeAxis(vertex.modelPos.z, block.origin.z, inverseStep[2]);
+            std::uint64_t packed = x | (y << quantizedPositionBits) | (z << (2 * quantizedPositionBits));
+
+            //Built in a local and stored whole, so write-combined memory sees sequential writes only
+            QuantizedVertex quantized;
+            quantized.packedPosition[0] = static_cast<std::uint32_t>(packed);
+            quantized.packedPosition[1] = static_cast<std::uint32_t>(packed >> 32);
+            quantized.colour = packColour(vertex.colour);
+            destination[i] = quantized;
+        }
+    });
+}
+
+std::uint32_t packColour(const XMFLOAT3& colour)
+{
+    return quantizeChannel(colour.x) | (quantizeChannel(colour.y) << 8) | (quantizeChannel(colour.z) << 16) | (0xFFu << 24);
+}
+
+PointCloudVertex dequantizeVertex(const QuantizedVertex& vertex, const QuantizationBlock& block)
+{
+    std::uint64_t packed = vertex.packedPosition[0] | (static_cast<std::uint64_t>(vertex.packedPosition[1]) << 32);
+    float x = static_cast<float>(packed & quantizedPositionMax);
+    float y = static_cast<float>((packed >> quantizedPositionBits) & quantizedPositionMax);
+    float z = static_cast<float>((packed >> (2 * quantizedPositionBits)) & quantizedPositionMax);
+
+    return PointCloudVertex(
+        XMFLOAT3(block.origin.x + x * block.step.x, block.origin.y + y * block.step.y, block.origin.z + z * block.step.z),
+        XMFLOAT3((vertex.colour & 0xFF) / 255.0f, ((vertex.colour >> 8) & 0xFF) / 255.0f, ((vertex.colour >> 16) & 0xFF) / 255.0f));
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "PointCloudVertex.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+
+//Bits per axis of a quantized position, three axes fit in 63 of the vertex's 64 position bits.
+constexpr unsigned int quantizedPositionBits = 21;
+constexpr std::uint32_t quantizedPositionMax = (1u << quantizedPositionBits) - 1;
+
+//12 byte vertex uploaded to the GPU in place of the 24 byte PointCloudVertex.
+struct QuantizedVertex
+{
+	std::uint32_t packedPosition[2]; //x in bits 0-20, y in bits 21-41, z in bits 42-62
+	std::uint32_t colour; //RGBA8, red in the lowest byte
+};
+
+//Maps a block's quantized coordinates back to model space: modelPos = origin + q * step.
+//step is chosen so the block's bounding box spans the full quantized range, bounding the error per axis by step / 2 plus the float rounding of the input.
+struct QuantizationBlock
+{
+	DirectX::XMFLOAT3 origin;
+	DirectX::XMFLOAT3 step;
+};
+
+//Block spanning the bounding box of the vertices.
+QuantizationBlock computeQuantizationBlock(const PointCloudVertex* vertices, std::size_t nVertices);
+
+//Encodes vertices relative to block into destination, which may be write-combined upload memory.
+void quantizeVertices(const PointCloudVertex* vertices, std::size_t nVertices, const QuantizationBlock& block,
+	QuantizedVertex* destination);
+
+//A colour as stored in QuantizedVertex::colour, with alpha 255.
+std::uint32_t packColour(const DirectX::XMFLOAT3& colour);
+
+PointCloudVertex dequantizeVertex(const QuantizedVertex& vertex, const QuantizationBlock& block);
@@ -0,0 +1,69 @@
+#pragma once
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Stable LSD radix sort of 64-bit keys carrying a value each, over 11-bit digits on the shared thread pool.
+//Every pass histograms fixed size chunks in parallel, prefix sums the histograms in (digit, chunk) order and scatters
+//each chunk into its own slots. Passes over a digit that every key shares are skipped, so keys that only use their
+//low bits or share a common prefix cost fewer passes.
+template<typename Value>
+void radixSortPairs(std::vector<std::uint64_t>& keys, std::vector<Value>& values)
+{
+	constexpr std::size_t elementsPerTask = 1 << 16;
+	constexpr int radixBits = 11; //Six passes over 63-bit curve codes, and a chunk's offsets still fit in L1
+	constexpr std::size_t nBuckets = 1 << radixBits;
+
+	std::size_t nElements = keys.size();
+	std::size_t nTasks = (nElements + elementsPerTask - 1) / elementsPerTask;
+	if (nTasks == 0)
+		return;
+	std::vector<std::uint64_t> keyScratch(nElements);
+	std::vector<Value> valueScratch(nElements);
+	std::vector<std::size_t> taskOffsets(nTasks * nBuckets);
+	ThreadPool& pool = ThreadPool::shared();
+
+	for (int shift = 0; shift < 64; shift += radixBits)
+	{
+		pool.parallelFor(nTasks, [&](std::size_t task) {
+			std::size_t* histogram = &taskOffsets[task * nBuckets];
+			std::fill(histogram, histogram + nBuckets, 0);
+			std::size_t end = std::min((task + 1) * elementsPerTask, nElements);
+			for (std::size_t i = task * elementsPerTask; i < end; ++i)
+				++histogram[(keys[i] >> shift) & (nBuckets - 1)];
+		});
+
+		//Exclusive prefix sum with buckets major and tasks minor, which keeps equal digits in their original order
+		std::size_t offset = 0;
+		bool sharedDigit = false;
+		for (std::size_t bucket = 0; bucket < nBuckets; ++bucket)
+		{
+			std::size_t bucketStart = offset;
+			for (std::size_t task = 0; task < nTasks; ++task)
+			{
+				std::size_t count = taskOffsets[task * nBuckets + bucket];
+				taskOffsets[task * nBuckets + bucket] = offset;
+				offset += count;
+			}
+			sharedDigit = sharedDigit || offset - bucketStart == nElements;
+		}
+		if (sharedDigit)
+			continue;
+
+		pool.parallelFor(nTasks, [&](std::size_t task) {
+			std::size_t* offsets = &taskOffsets[task * nBuckets];
+			std::size_t end = std::min((task + 1) * elementsPerTask, nElements);
+			for (std::size_t i = task * elementsPerTask; i < end; ++i)
+			{
+				std::size_t destination = offsets[(keys[i] >> shift) & (nBuckets - 1)]++;
+				keyScratch[destination] = keys[i];
+				valueScratch[destination] = values[i];
+			}
+		});
+		keys.swap(keyScratch);
+		values.swap(valueScratch);
+	}
+}
@@ -0,0 +1,174 @@
+#include "SpaceFillingCurve.h"
+#include "ThreadPool.h"
+#include "RadixSort.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr std::size_t curveVerticesPerTask = 1 << 16;
+
+    struct GridMapping
+    {
+        float origin[3];
+        float cellsPerUnit;
+
+        explicit GridMapping(const BoundingBox& cube)
+        {
+            origin[0] = cube.min.x;
+            origin[1] = cube.min.y;
+            origin[2] = cube.min.z;
+            float side = cube.max.x - cube.min.x;
+            cellsPerUnit = side > 0.0f ? curveGridSize / side : 0.0f;
+        }
+
+        std::uint32_t cell(float value, int axis) const
+        {
+            float cell = std::floor((value - origin[axis]) * cellsPerUnit);
+            return static_cast<std::uint32_t>(std::clamp(cell, 0.0f, static_cast<float>(curveGridSize - 1)));
+        }
+    };
+
+    template<typename Index>
+    void sortByCode(const PointCloudVertex* vertices, std::size_t nVertices, std::vector<std::uint64_t>& codes,
+        std::vector<PointCloudVertex>& sortedVertices, std::vector<std::uint64_t>* sourceIndices)
+    {
+        std::size_t nTasks = (nVertices + curveVerticesPerTask - 1) / curveVerticesPerTask;
+        std::vector<Index> indices(nVertices);
+        ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * curveVerticesPerTask, nVertices);
+            for (std::size_t i = task * curveVerticesPerTask; i < end; ++i)
+                indices[i] = static_cast<Index>(i);
+        });
+
+        radixSortPairs(codes, indices);
+
+        sortedVertices.resize(nVertices);
+        if (sourceIndices)
+            sourceIndices->resize(nVertices);
+        ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * curveVerticesPerTask, nVertices);
+            for (std::size_t i = task * curveVerticesPerTask; i < end; ++i)
+            {
+                sortedVertices[i] = vertices[indices[i]];
+                if (sourceIndices)
+                    (*sourceIndices)[i] = indices[i];
+            }
+        });
+    }
+}
+
+std::uint64_t hilbertCode(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    //Skilling's transform ("Programming the Hilbert curve", 2004): turns the coordinates into the transposed
+    //Hilbert index, whose bits interleave into the index itself with x most significant
+    std::uint32_t axes[3] = { x, y, z };
+    for (std::uint32_t q = curveGridSize >> 1; q > 1; q >>= 1)
+    {
+        //Where axes[i] has bit q set the low bits of axes[0] are inverted, otherwise they are exchanged with axes[i]'s.
+        //Done with masks, the bits are random enough to defeat branch prediction.
+        std::uint32_t p = q - 1;
+        for (int i = 0; i < 3; ++i)
+        {
+            std::uint32_t invert = 0u - ((axes[i] & q) != 0);
+            std::uint32_t t = (axes[0] ^ axes[i]) & p & ~invert;
+            axes[0] ^= t ^ (p & invert);
+            axes[i] ^= t;
+        }
+    }
+    for (int i = 1; i < 3; ++i)
+        axes[i] ^= axes[i - 1];
+    std::uint32_t t = 0;
+    for (std::uint32_t q = curveGridSize >> 1; q > 1; q >>= 1)
+    {
+        if (axes[2] & q)
+            t ^= q - 1;
+    }
+    for (int i = 0; i < 3; ++i)
+        axes[i] ^= t;
+
+    return spreadBitsBy3(axes[2]) | (spreadBitsBy3(axes[1]) << 1) | (spreadBitsBy3(axes[0]) << 2);
+}
+
+BoundingBox boundingCube(const BoundingBox& box)
+{
+    float side = std::max({ box.max.x - box.min.x, box.max.y - box.min.y, box.max.z - box.min.z, 0.0f });
+    return { box.min, DirectX::XMFLOAT3(box.min.x + side, box.min.y + side, box.min.z + side) };
+}
+
+void computeCurveCodes(const PointCloudVertex* vertices, std::size_t nVertices, const BoundingBox& cube, CurveType curve,
+    std::uint64_t* codes)
+{
+    GridMapping grid(cube);
+    std::size_t nTasks = (nVertices + curveVerticesPerTask - 1) / curveVerticesPerTask;
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * curveVerticesPerTask, nVertices);
+        for (std::size_t i = task * curveVerticesPerTask; i < end; ++i)
+        {
+            const DirectX::XMFLOAT3& pos = vertices[i].modelPos;
+            std::uint32_t x = grid.cell(pos.x, 0), y = grid.cell(pos.y, 1), z = grid.cell(pos.z, 2);
+            codes[i] = curve == CurveType::Morton ? mortonCode(x, y, z) : hilbertCode(x, y, z);
+        }
+    });
+}
+
+void sortAlongCurve(const PointCloudVertex* vertices, std::size_t nVertices, const BoundingBox& cube, CurveType curve,
+    std::vector<PointCloudVertex>& sortedVertices, std::vector<std::uint64_t>* codes, std::vector<std::uint64_t>* sourceIndices)
+{
+    std::vector<std::uint64_t> localCodes;
+    std::vector<std::uint64_t>& sortCodes = codes ? *codes : localCodes;
+    sortCodes.resize(nVertices);
+    computeCurveCodes(vertices, nVertices, cube, curve, sortCodes.data());
+
+    //32-bit indices halve the sort's traffic whenever they are wide enough
+    if (nVertices <= std::numeric_limits<std::uint32_t>::max())
+        sortByCode<std::uint32_t>(vertices, nVertices, sortCodes, sortedVertices, sourceIndices);
+    else
+        sortByCode<std::uint64_t>(vertices, nVertices, sortCodes, sortedVertices, sourceIndices);
+}
+
+std::unique_ptr<PointCloud> reorderAlongCurve(const PointCloud& pointCloud, CurveType curve)
+{
+    PointCloudBounds bounds = pointCloud.bounds ? *pointCloud.bounds : calculateBounds(pointCloud.data(), pointCloud.size());
+    std::vector<PointCloudVertex> sortedVertices;
+    std::vector<std::uint64_t> sourceIndices;
+    sortAlongCurve(pointCloud.data(), pointCloud.size(), boundingCube(bounds.box), curve, sortedVertices, nullptr, &sourceIndices);
+    auto reordered = std::make_unique<PointCloud>(std::move(sortedVertices));
+    if (!pointCloud.normals.empty())
+    {
+        reordered->normals.resize(pointCloud.size());
+        std::size_t nTasks = (pointCloud.size() + curveVerticesPerTask - 1) / curveVerticesPerTask;
+        ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * curveVerticesPerTask, pointCloud.size());
+            for (std::size_t i = task * curveVerticesPerTask; i < end; ++i)
+                reordered->normals[i] = pointCloud.normals[sourceIndices[i]];
+        });
+    }
+
+    if (!pointCloud.sourceOrder.empty())
+    {
+        for (auto& index : sourceIndices)
+            index = pointCloud.sourceOrder[index];
+    }
+    reordered->bounds = bounds;
+    reordered->origin = pointCloud.origin;
+    reordered->sourceOrder = std::move(sourceIndices);
+    return reordered;
+}
+
+std::vector<PointCloudVertex> restoreSourceOrder(const PointCloud& pointCloud)
+{
+    if (pointCloud.sourceOrder.empty())
+        return std::vector<PointCloudVertex>(pointCloud.data(), pointCloud.data() + pointCloud.size());
+
+    std::vector<PointCloudVertex> vertices(pointCloud.size());
+    std::size_t nTasks = (pointCloud.size() + curveVerticesPerTask - 1) / curveVerticesPerTask;
+    ThreadPool::shared().parallelFor(nTasks, [&](std::size_t task) {
+        std::size_t end = std::min((task + 1) * curveVerticesPerTask, pointCloud.size());
+        for (std::size_t i = task * curveVerticesPerTask; i < end; ++i)
+            vertices[pointCloud.sourceOrder[i]] = pointCloud.data()[i];
+    });
+    return vertices;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "PointCloudVertex.h"
+#include "Bounds.h"
+#include "PointCloud.h"
+//C++
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class CurveType { Morton, Hilbert };
+
+//Grid resolution per axis for curve codes, three axes fit in 63 bits.
+constexpr unsigned int curveBitsPerAxis = 21;
+constexpr std::uint32_t curveGridSize = 1u << curveBitsPerAxis;
+
+//Spreads the low 21 bits of v out to every third bit.
+inline std::uint64_t spreadBitsBy3(std::uint32_t v)
+{
+	std::uint64_t x = v & (curveGridSize - 1);
+	x = (x | x << 32) & 0x1F00000000FFFFull;
+	x = (x | x << 16) & 0x1F0000FF0000FFull;
+	x = (x | x << 8) & 0x100F00F00F00F00Full;
+	x = (x | x << 4) & 0x10C30C30C30C30C3ull;
+	x = (x | x << 2) & 0x1249249249249249ull;
+	return x;
+}
+
+//Inverse of spreadBitsBy3, gathers every third bit of x starting at bit 0.
+inline std::uint32_t compactBitsBy3(std::uint64_t x)
+{
+	x &= 0x1249249249249249ull;
+	x = (x | x >> 2) & 0x10C30C30C30C30C3ull;
+	x = (x | x >> 4) & 0x100F00F00F00F00Full;
+	x = (x | x >> 8) & 0x1F0000FF0000FFull;
+	x = (x | x >> 16) & 0x1F00000000FFFFull;
+	x = (x | x >> 32) & (curveGridSize - 1);
+	return static_cast<std::uint32_t>(x);
+}
+
+//Interleaves the grid coordinates as ...z1y1x1z0y0x0, so each 3-bit group from the top is an octant index (x in bit 0).
+inline std::uint64_t mortonCode(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+	return spreadBitsBy3(x) | (spreadBitsBy3(y) << 1) | (spreadBitsBy3(z) << 2);
+}
+
+//Index along the 3D Hilbert curve through the 2^21 grid. Unlike Morton order, consecutive cells are always face neighbours.
+std::uint64_t hilbertCode(std::uint32_t x, std::uint32_t y, std::uint32_t z);
+
+//Cube with the box's minimum corner and its longest side, so curve cells are cubes too.
+BoundingBox boundingCube(const BoundingBox& box);
+
+//Quantizes every position onto the curve grid spanning cube and writes its code, in parallel.
+void computeCurveCodes(const PointCloudVertex* vertices, std::size_t nVertices, const BoundingBox& cube, CurveType curve,
+	std::uint64_t* codes);
+
+//Copies the vertices into sortedVertices in curve order using a parallel radix sort of their codes.
+//codes and sourceIndices are optional outputs: the sorted codes and, for each sorted vertex, its index in vertices.
+void sortAlongCurve(const PointCloudVertex* vertices, std::size_t nVertices, const BoundingBox& cube, CurveType curve,
+	std::vector<PointCloudVertex>& sortedVertices, std::vector<std::uint64_t>* codes, std::vector<std::uint64_t>* sourceIndices);
+
+//Load stage that reorders a cloud along curve, so points close in space are close in memory for CPU queries and
+//GPU vertex fetch. The result records its sourceOrder (composed with any the input already had), bounds, origin and
+//normals are kept. The level of detail hierarchy keeps this order within each of its nodes when built with keepInputOrder.
+std::unique_ptr<PointCloud> reorderAlongCurve(const PointCloud& pointCloud, CurveType curve);
+
+//The vertices back in source file order.
+std::vector<PointCloudVertex> restoreSourceOrder(const PointCloud& pointCloud);
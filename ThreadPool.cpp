@@ -0,0 +1,142 @@
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int nThreads)
+{
+    nRanges = std::max(nThreads, 1U);
+    ranges = std::make_unique<WorkRange[]>(nRanges);
+    for (std::size_t i = 1; i < nRanges; ++i)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(jobLock);
+        stopping = true;
+    }
+    jobStarted.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& task)
+{
+    if (count == 0)
+        return;
+    if (nRanges == 1 || count == 1)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    //Deal out contiguous shares so neighbouring indices stay on the same thread until stealing starts
+    std::size_t share = count / nRanges;
+    std::size_t remainder = count % nRanges;
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < nRanges; ++i)
+    {
+        std::size_t end = begin + share + (i < remainder ? 1 : 0);
+        std::lock_guard<std::mutex> guard(ranges[i].lock);
+        ranges[i].begin = begin;
+        ranges[i].end = end;
+        begin = end;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(jobLock);
+        ThreadPool::task = &task;
+        activeWorkers = workers.size();
+        ++jobGeneration;
+    }
+    jobStarted.notify_all();
+
+    runRanges(0);
+
+    std::unique_lock<std::mutex> guard(jobLock);
+    jobFinished.wait(guard, [this] { return activeWorkers == 0; });
+    ThreadPool::task = nullptr;
+}
+
+void ThreadPool::workerLoop(std::size_t rangeIndex)
+{
+    std::size_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(jobLock);
+            jobStarted.wait(guard, [&] { return stopping || jobGeneration != seenGeneration; });
+            if (stopping)
+                return;
+            seenGeneration = jobGeneration;
+        }
+
+        runRanges(rangeIndex);
+
+        std::lock_guard<std::mutex> guard(jobLock);
+        if (--activeWorkers == 0)
+            jobFinished.notify_one();
+    }
+}
+
+void ThreadPool::runRanges(std::size_t rangeIndex)
+{
+    std::size_t index;
+    do
+    {
+        while (popFront(rangeIndex, index))
+            (*task)(index);
+    } while (steal(rangeIndex));
+}
+
+bool ThreadPool::popFront(std::size_t rangeIndex, std::size_t& index)
+{
+    WorkRange& range = ranges[rangeIndex];
+    std::lock_guard<std::mutex> guard(range.lock);
+    if (range.begin == range.end)
+        return false;
+    index = range.begin++;
+    return true;
+}
+
+bool ThreadPool::steal(std::size_t thiefIndex)
+{
+    //Pick the victim with the most work left so steals stay rare
+    std::size_t victimIndex = thiefIndex;
+    std::size_t mostRemaining = 0;
+    for (std::size_t i = 0; i < nRanges; ++i)
+    {
+        if (i == thiefIndex)
+            continue;
+        std::lock_guard<std::mutex> guard(ranges[i].lock);
+        std::size_t remaining = ranges[i].end - ranges[i].begin;
+        if (remaining > mostRemaining)
+        {
+            mostRemaining = remaining;
+            victimIndex = i;
+        }
+    }
+    if (victimIndex == thiefIndex)
+        return false;
+
+    WorkRange& victim = ranges[victimIndex];
+    WorkRange& thief = ranges[thiefIndex];
+    std::scoped_lock guard(victim.lock, thief.lock);
+    std::size_t remaining = victim.end - victim.begin;
+    if (remaining == 0)
+        return true; //Victim finished in the meantime, look again
+    std::size_t stolen = (remaining + 1) / 2;
+    thief.begin = victim.end - stolen;
+    thief.end = victim.end;
+    victim.end -= stolen;
+    return true;
+}
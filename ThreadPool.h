@@ -0,0 +1,56 @@
+#pragma once
+//C++
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Fixed set of worker threads that execute index ranges with work stealing.
+//Each participant starts with a contiguous share of the indices and, once it runs dry, steals half of
+//the remaining indices from the back of the busiest other participant. Slow items therefore don't stall the join.
+class ThreadPool
+{
+	struct WorkRange
+	{
+		std::mutex lock;
+		std::size_t begin = 0;
+		std::size_t end = 0;
+	};
+
+	std::vector<std::thread> workers;
+	std::unique_ptr<WorkRange[]> ranges; //One per worker plus one for the calling thread
+	std::size_t nRanges;
+	const std::function<void(std::size_t)>* task = nullptr;
+
+	std::mutex jobLock;
+	std::condition_variable jobStarted;
+	std::condition_variable jobFinished;
+	std::size_t jobGeneration = 0;
+	std::size_t activeWorkers = 0;
+	bool stopping = false;
+
+	void workerLoop(std::size_t rangeIndex);
+	void runRanges(std::size_t rangeIndex);
+	bool popFront(std::size_t rangeIndex, std::size_t& index);
+	bool steal(std::size_t thiefIndex);
+
+public:
+	//nThreads counts the calling thread, so ThreadPool(1) runs everything inline.
+	explicit ThreadPool(unsigned int nThreads = std::thread::hardware_concurrency());
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	//Pool sized to the machine, created on first use.
+	static ThreadPool& shared();
+
+	unsigned int size() const { return static_cast<unsigned int>(nRanges); }
+
+	//Calls task(i) for every i in [0, count) and returns once all calls have finished.
+	//The calling thread takes part. Must not be called from inside a task.
+	void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task);
+};
@@ -0,0 +1,33 @@
+#include "VertexArray.h"
+//C++
+#include <utility>
+
+VertexArray::VertexArray(std::vector<PointCloudVertex>&& vertices)
+    : ownedVertices(std::move(vertices))
+{
+    vertexData = ownedVertices.data();
+    nVertices = ownedVertices.size();
+}
+
+VertexArray::VertexArray(std::shared_ptr<const MappedFile> mapping, std::size_t offset, std::size_t nVertices)
+    : mapping(std::move(mapping)), nVertices(nVertices)
+{
+    vertexData = reinterpret_cast<const PointCloudVertex*>(VertexArray::mapping->data() + offset);
+}
+
+VertexArray::VertexArray(VertexArray&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+VertexArray& VertexArray::operator=(VertexArray&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+    //Moving the vector keeps its buffer, so vertexData stays valid
+    ownedVertices = std::move(other.ownedVertices);
+    mapping = std::move(other.mapping);
+    vertexData = std::exchange(other.vertexData, nullptr);
+    nVertices = std::exchange(other.nVertices, 0);
+    return *this;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "PointCloudVertex.h"
+#include "MappedFile.h"
+//C++
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+//Read-only vertices, either owned or viewed directly inside a memory mapped file. Views share the mapping, so a cloud
+//and its cached hierarchy can both view one cache file, which stays mapped until the last of them is gone.
+class VertexArray
+{
+	std::vector<PointCloudVertex> ownedVertices;
+	std::shared_ptr<const MappedFile> mapping;
+	const PointCloudVertex* vertexData = nullptr;
+	std::size_t nVertices = 0;
+
+public:
+	VertexArray() = default;
+	explicit VertexArray(std::vector<PointCloudVertex>&& vertices);
+	//offset must keep the vertices aligned within the mapping.
+	VertexArray(std::shared_ptr<const MappedFile> mapping, std::size_t offset, std::size_t nVertices);
+	VertexArray(const VertexArray&) = delete;
+	VertexArray& operator=(const VertexArray&) = delete;
+	VertexArray(VertexArray&& other) noexcept;
+	VertexArray& operator=(VertexArray&& other) noexcept;
+
+	const PointCloudVertex* data() const { return vertexData; }
+	std::size_t size() const { return nVertices; }
+	bool empty() const { return nVertices == 0; }
+	const PointCloudVertex& operator[](std::size_t i) const { return vertexData[i]; }
+	const PointCloudVertex* begin() const { return vertexData; }
+	const PointCloudVertex* end() const { return vertexData + nVertices; }
+};
@@ -0,0 +1,78 @@
+#pragma once
+//C++
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Vertex buffers are capped in size by D3D12 (and their views by 32-bit byte counts), so large clouds are uploaded
+//and drawn as a sequence of fixed size segments.
+constexpr std::uint64_t defaultSegmentBytes = 256ull << 20;
+
+struct VertexSegment
+{
+	std::uint64_t firstVertex; //Index of the segment's first vertex in the whole cloud
+	std::uint32_t nVertices;
+};
+
+//Splits nVertices into consecutive segments of at most segmentBytes each.
+inline std::vector<VertexSegment> partitionIntoSegments(std::uint64_t nVertices, std::uint64_t vertexStride,
+	std::uint64_t segmentBytes = defaultSegmentBytes)
+{
+	std::uint64_t verticesPerSegment = std::max<std::uint64_t>(segmentBytes / vertexStride, 1);
+	std::vector<VertexSegment> segments;
+	for (std::uint64_t first = 0; first < nVertices; first += verticesPerSegment)
+		segments.push_back({ first, static_cast<std::uint32_t>(std::min(verticesPerSegment, nVertices - first)) });
+	return segments;
+}
+
+//Span of vertices to draw, indexed over the whole cloud.
+struct DrawRange
+{
+	std::uint64_t firstVertex;
+	std::uint64_t nVertices;
+	bool coarse = false; //Drawn with the hierarchy's coarse colours (see LodHierarchy)
+};
+
+//Sorts disjoint ranges by first vertex and merges those that touch and agree on coarse.
+inline void sortAndMergeRanges(std::vector<DrawRange>& ranges)
+{
+	std::sort(ranges.begin(), ranges.end(),
+		[](const DrawRange& a, const DrawRange& b) { return a.firstVertex < b.firstVertex; });
+	std::size_t nMerged = 0;
+	for (const DrawRange& range : ranges)
+	{
+		if (nMerged != 0 && ranges[nMerged - 1].firstVertex + ranges[nMerged - 1].nVertices == range.firstVertex
+			&& ranges[nMerged - 1].coarse == range.coarse)
+			ranges[nMerged - 1].nVertices += range.nVertices;
+		else
+			ranges[nMerged++] = range;
+	}
+	ranges.resize(nMerged);
+}
+
+//Maps sorted, disjoint ranges onto the segments, calling draw(segmentIndex, firstVertexInSegment, nVertices, coarse)
+//for each piece in order. Ranges crossing a segment boundary are split in two.
+template<typename Draw>
+void splitRangesAtSegments(const std::vector<VertexSegment>& segments, const std::vector<DrawRange>& ranges, Draw&& draw)
+{
+	std::size_t segment = 0;
+	for (const DrawRange& range : ranges)
+	{
+		std::uint64_t first = range.firstVertex;
+		std::uint64_t end = range.firstVertex + range.nVertices;
+		while (first < end && segment < segments.size())
+		{
+			std::uint64_t segmentEnd = segments[segment].firstVertex + segments[segment].nVertices;
+			if (first >= segmentEnd)
+			{
+				++segment;
+				continue;
+			}
+			std::uint64_t pieceEnd = std::min(end, segmentEnd);
+			draw(segment, static_cast<std::uint32_t>(first - segments[segment].firstVertex),
+				static_cast<std::uint32_t>(pieceEnd - first), range.coarse);
+			first = pieceEnd;
+		}
+	}
+}
@@ -0,0 +1,133 @@
+#include "VoxelFilter.h"
+#include "OctahedralNormal.h"
+#include "RadixSort.h"
+#include "SpaceFillingCurve.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    constexpr std::size_t voxelPointsPerTask = 1 << 16;
+
+    //Sorts the points by voxel, then each task reduces the voxels starting in its slice of the sorted keys, reading on
+    //past the slice's end to finish the last one. A first pass counts the voxels each task starts, so every task knows
+    //where its output begins. normals may be null, otherwise the voxels' mean normals are written to reducedNormals.
+    template<typename Index>
+    std::vector<PointCloudVertex> reduceVoxels(const PointCloudVertex* vertices, const std::uint32_t* normals, std::size_t nVertices,
+        const BoundingBox& box, float voxelSize, VoxelRepresentative representative, std::vector<std::uint32_t>& reducedNormals)
+    {
+        std::size_t nTasks = (nVertices + voxelPointsPerTask - 1) / voxelPointsPerTask;
+        ThreadPool& pool = ThreadPool::shared();
+        std::vector<std::uint64_t> keys(nVertices);
+        std::vector<Index> indices(nVertices);
+        float inverseSize = 1.0f / voxelSize;
+        pool.parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * voxelPointsPerTask, nVertices);
+            for (std::size_t i = task * voxelPointsPerTask; i < end; ++i)
+            {
+                const DirectX::XMFLOAT3& position = vertices[i].modelPos;
+                auto cell = [&](float coordinate, float minimum) {
+                    return static_cast<std::uint32_t>(std::min((coordinate - minimum) * inverseSize, static_cast<float>(curveGridSize - 1)));
+                };
+                keys[i] = mortonCode(cell(position.x, box.min.x), cell(position.y, box.min.y), cell(position.z, box.min.z));
+                indices[i] = static_cast<Index>(i);
+            }
+        });
+        radixSortPairs(keys, indices);
+
+        std::vector<std::size_t> firstVoxel(nTasks + 1, 0);
+        pool.parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t end = std::min((task + 1) * voxelPointsPerTask, nVertices);
+            for (std::size_t i = task * voxelPointsPerTask; i < end; ++i)
+                firstVoxel[task + 1] += i == 0 || keys[i] != keys[i - 1];
+        });
+        for (std::size_t task = 0; task < nTasks; ++task)
+            firstVoxel[task + 1] += firstVoxel[task];
+
+        std::vector<PointCloudVertex> reduced(firstVoxel[nTasks]);
+        reducedNormals.resize(normals ? reduced.size() : 0);
+        pool.parallelFor(nTasks, [&](std::size_t task) {
+            std::size_t first = task * voxelPointsPerTask;
+            std::size_t sliceEnd = std::min(first + voxelPointsPerTask, nVertices);
+            //Skip the tail of a voxel the previous task finishes
+            while (first < sliceEnd && first != 0 && keys[first] == keys[first - 1])
+                ++first;
+            std::size_t output = firstVoxel[task];
+            for (std::size_t last; first < sliceEnd; first = last)
+            {
+                //Doubles, as a float sum of large coordinates would lose the voxel's own scale
+                double sum[6] = {};
+                for (last = first; last < nVertices && keys[last] == keys[first]; ++last)
+                {
+                    const PointCloudVertex& vertex = vertices[indices[last]];
+                    sum[0] += vertex.modelPos.x;
+                    sum[1] += vertex.modelPos.y;
+                    sum[2] += vertex.modelPos.z;
+                    sum[3] += vertex.colour.x;
+                    sum[4] += vertex.colour.y;
+                    sum[5] += vertex.colour.z;
+                }
+                if (normals)
+                {
+                    //The encoding projects onto the octahedron, so the sum needn't be normalized first
+                    DirectX::XMFLOAT3 normalSum(0.0f, 0.0f, 0.0f);
+                    for (std::size_t i = first; i < last; ++i)
+                    {
+                        DirectX::XMFLOAT3 normal = decodeOctahedral(normals[indices[i]]);
+                        normalSum = DirectX::XMFLOAT3(normalSum.x + normal.x, normalSum.y + normal.y, normalSum.z + normal.z);
+                    }
+                    reducedNormals[output] = encodeOctahedral(normalSum);
+                }
+                double nPoints = static_cast<double>(last - first);
+                DirectX::XMFLOAT3 centroid(static_cast<float>(sum[0] / nPoints), static_cast<float>(sum[1] / nPoints),
+                    static_cast<float>(sum[2] / nPoints));
+                if (representative == VoxelRepresentative::NearestToCentroid)
+                {
+                    float nearest = std::numeric_limits<float>::infinity();
+                    DirectX::XMFLOAT3 nearestPosition = centroid;
+                    for (std::size_t i = first; i < last; ++i)
+                    {
+                        const DirectX::XMFLOAT3& position = vertices[indices[i]].modelPos;
+                        float dx = position.x - centroid.x, dy = position.y - centroid.y, dz = position.z - centroid.z;
+                        float distance = dx * dx + dy * dy + dz * dz;
+                        if (distance < nearest)
+                        {
+                            nearest = distance;
+                            nearestPosition = position;
+                        }
+                    }
+                    centroid = nearestPosition;
+                }
+                reduced[output++] = PointCloudVertex(centroid, DirectX::XMFLOAT3(static_cast<float>(sum[3] / nPoints),
+                    static_cast<float>(sum[4] / nPoints), static_cast<float>(sum[5] / nPoints)));
+            }
+        });
+        return reduced;
+    }
+}
+
+std::unique_ptr<PointCloud> voxelDownsample(const PointCloud& pointCloud, float voxelSize, VoxelRepresentative representative)
+{
+    if (!(voxelSize > 0.0f))
+        return nullptr;
+    PointCloudBounds bounds = pointCloud.bounds ? *pointCloud.bounds : calculateBounds(pointCloud.data(), pointCloud.size());
+    const BoundingBox& box = bounds.box;
+    float extent = std::max(std::max(box.max.x - box.min.x, box.max.y - box.min.y), box.max.z - box.min.z);
+    if (pointCloud.size() != 0 && extent / voxelSize >= static_cast<float>(curveGridSize))
+        return nullptr;
+
+    const std::uint32_t* normals = pointCloud.normals.empty() ? nullptr : pointCloud.normals.data();
+    std::vector<std::uint32_t> reducedNormals;
+    //32-bit indices halve the sort's traffic whenever they are wide enough
+    std::vector<PointCloudVertex> reduced = pointCloud.size() <= std::numeric_limits<std::uint32_t>::max()
+        ? reduceVoxels<std::uint32_t>(pointCloud.data(), normals, pointCloud.size(), box, voxelSize, representative, reducedNormals)
+        : reduceVoxels<std::uint64_t>(pointCloud.data(), normals, pointCloud.size(), box, voxelSize, representative, reducedNormals);
+    auto downsampled = std::make_unique<PointCloud>(std::move(reduced));
+    downsampled->normals = std::move(reducedNormals);
+    downsampled->origin = pointCloud.origin;
+    downsampled->bounds = calculateBounds(downsampled->data(), downsampled->size());
+    return downsampled;
+}
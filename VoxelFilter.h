@@ -0,0 +1,20 @@
+#pragma once
+#include "PointCloud.h"
+//C++
+#include <cstddef>
+#include <memory>
+
+enum class VoxelRepresentative
+{
+	Centroid, //The mean position of the voxel's points
+	NearestToCentroid //The voxel's input point closest to that mean
+};
+
+//Load stage that keeps one point per occupied voxel of a grid with voxelSize sides, anchored at the cloud's minimum
+//corner. The point's colour is the mean of the voxel's colours, and its normal, if the cloud has normals, their
+//normalized mean. Voxels are grouped by radix sorting their Morton codes on the shared thread pool, so the result
+//comes out in Morton order of the voxels and is the same for any thread count. It keeps the origin but has no
+//sourceOrder, its points no longer match the file's one for one.
+//Returns nullptr if voxelSize isn't positive or the grid would need more than 2^21 voxels along an axis.
+std::unique_ptr<PointCloud> voxelDownsample(const PointCloud& pointCloud, float voxelSize,
+	VoxelRepresentative representative = VoxelRepresentative::Centroid);
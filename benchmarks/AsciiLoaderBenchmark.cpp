@@ -0,0 +1,71 @@
+#include "Benchmark.h"
+#include "PointCloudLoader.h"
+#include "ThreadPool.h"
+//C++
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+//Parses "x y z r g b" records with 1 to N threads, the way the loader does: newline aligned 4 MiB blocks, each parsed
+//straight into its slot of one array by a work-stealing pool. The loader always uses the shared pool, so every thread
+//count gets a pool of its own here. Then the whole mapped load is timed with the shared pool.
+//Usage: AsciiLoaderBenchmark [points] [threads], 5 million points and up to every hardware thread by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 5'000'000);
+    std::vector<PointCloudVertex> source = benchmarkVertices(nPoints);
+    std::string text;
+    text.reserve(nPoints * 48);
+    char record[128];
+    for (const PointCloudVertex& vertex : source)
+    {
+        int length = std::snprintf(record, sizeof(record), "%.4f %.4f %.4f %d %d %d\n", vertex.modelPos.x, vertex.modelPos.y,
+            vertex.modelPos.z, static_cast<int>(vertex.colour.x * 255.0f), static_cast<int>(vertex.colour.y * 255.0f),
+            static_cast<int>(vertex.colour.z * 255.0f));
+        text.append(record, static_cast<std::size_t>(length));
+    }
+
+    std::optional<AsciiSchema> schema = detectAsciiSchema(text);
+    if (!schema)
+        return 1;
+    AsciiBlockParser parseBlock = selectAsciiBlockParser(*schema);
+    std::vector<std::string_view> blocks = splitAtLineBoundaries(text, (text.size() + asciiBlockSize - 1) / asciiBlockSize);
+    std::vector<std::size_t> blockOffsets(blocks.size() + 1, 0);
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+        blockOffsets[i + 1] = blockOffsets[i] + static_cast<std::size_t>(std::count(blocks[i].begin(), blocks[i].end(), '\n'));
+    std::vector<PointCloudVertex> vertices(blockOffsets.back());
+    std::vector<BoundsAccumulator> blockBounds(blocks.size());
+
+    std::printf("%zu records, %.1f MiB of text, %zu blocks\n", nPoints, text.size() / 1048576.0, blocks.size());
+    unsigned int maxThreads = argc > 2 ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10))
+        : std::thread::hardware_concurrency();
+    maxThreads = std::max(1u, maxThreads);
+    double singleThreaded = 0.0;
+    for (unsigned int nThreads = 1;; nThreads = std::min(nThreads * 2, maxThreads))
+    {
+        ThreadPool pool(nThreads);
+        double seconds = fastestSeconds([&] {
+            pool.parallelFor(blocks.size(), [&](std::size_t i) {
+                blockBounds[i] = BoundsAccumulator();
+                parseBlock(blocks[i], vertices.data() + blockOffsets[i], nullptr, *schema, blockBounds[i]);
+            });
+        });
+        singleThreaded = nThreads == 1 ? seconds : singleThreaded;
+        std::string name = "parse, " + std::to_string(nThreads) + " threads";
+        reportThroughput(name.c_str(), static_cast<double>(nPoints), "points", seconds);
+        std::printf("%-40s %12.2fx\n", "  speedup over 1 thread", singleThreaded / seconds);
+        if (nThreads == maxThreads)
+            break;
+    }
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pcv_ascii_loader_benchmark.txt";
+    std::ofstream(path, std::ios::binary).write(text.data(), static_cast<std::streamsize>(text.size()));
+    double seconds = fastestSeconds([&] { readPointCloudASC(path); });
+    reportThroughput("readPointCloudASC, shared pool", static_cast<double>(nPoints), "points", seconds);
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "PointCloudVertex.h"
+//C++
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//Minimal timing for the benchmark executables, which aren't registered with CTest: every measurement is the fastest
+//of a few runs and is printed as throughput, so runs on different machines or commits can be compared by eye.
+
+//Fastest of repeats calls to work, in seconds.
+template<typename Work>
+double fastestSeconds(Work&& work, int repeats = 3)
+{
+	double fastest = 0.0;
+	for (int i = 0; i < repeats; ++i)
+	{
+		auto start = std::chrono::steady_clock::now();
+		work();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		fastest = i == 0 ? seconds : std::min(fastest, seconds);
+	}
+	return fastest;
+}
+
+//Keeps a result nothing else reads from being optimised away along with the work that produced it.
+template<typename T>
+void keepResult(const T& value)
+{
+	static volatile T sink;
+	sink = value;
+}
+
+//Prints a line "<name> <items> <unit> in <ms> ms, <rate> <unit>/s".
+inline void reportThroughput(const char* name, double nItems, const char* unit, double seconds)
+{
+	std::printf("%-40s %12.0f %s in %9.2f ms, %14.0f %s/s\n", name, nItems, unit, seconds * 1000.0, nItems / seconds, unit);
+	std::fflush(stdout);
+}
+
+//The first command line argument if there is one, so large runs don't need a rebuild.
+inline std::size_t countArgument(int argc, char** argv, std::size_t defaultCount)
+{
+	return argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : defaultCount;
+}
+
+//Scan like points in a 40 by 10 by 40 room: four fifths on three of its walls and its floor, the rest scattered inside.
+inline std::vector<PointCloudVertex> benchmarkVertices(std::size_t nVertices)
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::normal_distribution<float> noise(0.0f, 0.002f);
+	std::vector<PointCloudVertex> vertices(nVertices);
+	for (std::size_t i = 0; i < nVertices; ++i)
+	{
+		float u = unit(random) * 40.0f;
+		float v = unit(random) * 10.0f;
+		DirectX::XMFLOAT3 position;
+		switch (i % 5)
+		{
+		case 0: position = DirectX::XMFLOAT3(u, v, noise(random)); break;
+		case 1: position = DirectX::XMFLOAT3(u, v, 40.0f + noise(random)); break;
+		case 2: position = DirectX::XMFLOAT3(noise(random), v, u); break;
+		case 3: position = DirectX::XMFLOAT3(u, noise(random), unit(random) * 40.0f); break;
+		default: position = DirectX::XMFLOAT3(u, v, unit(random) * 40.0f); break;
+		}
+		vertices[i] = PointCloudVertex(position, DirectX::XMFLOAT3(unit(random), unit(random), unit(random)));
+	}
+	return vertices;
+}
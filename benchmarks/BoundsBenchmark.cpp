@@ -0,0 +1,35 @@
+#include "Benchmark.h"
+#include "Bounds.h"
+
+//Bounding volumes of a large cloud: the parallel box and centroid pass, a serial pass for comparison, the exact minimum
+//enclosing sphere and the PCA oriented box.
+//Usage: BoundsBenchmark [points], 100 million (2.4 GB of vertices) by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 100'000'000);
+    std::vector<PointCloudVertex> vertices = benchmarkVertices(nPoints);
+    double n = static_cast<double>(nPoints);
+
+    double seconds = fastestSeconds([&] {
+        BoundsAccumulator bounds;
+        for (const PointCloudVertex& vertex : vertices)
+            bounds.add(vertex);
+        keepResult(bounds.result().box.max.x);
+    });
+    reportThroughput("box and centroid, serial", n, "points", seconds);
+
+    PointCloudBounds bounds;
+    seconds = fastestSeconds([&] { bounds = calculateBounds(vertices.data(), vertices.size()); });
+    reportThroughput("calculateBounds", n, "points", seconds);
+
+    BoundingSphere sphere;
+    seconds = fastestSeconds([&] { sphere = calculateMinimumEnclosingSphere(vertices.data(), vertices.size()); });
+    reportThroughput("calculateMinimumEnclosingSphere", n, "points", seconds);
+    std::printf("%-40s %12.4f, box circumsphere %.4f\n", "  radius", sphere.radius, bounds.sphere.radius);
+
+    seconds = fastestSeconds([&] {
+        keepResult(calculateOrientedBoundingBox(vertices.data(), vertices.size(), bounds.centroid).halfExtents.x);
+    });
+    reportThroughput("calculateOrientedBoundingBox", n, "points", seconds);
+    return 0;
+}
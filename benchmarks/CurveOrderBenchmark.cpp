@@ -0,0 +1,56 @@
+#include "Benchmark.h"
+#include "SpaceFillingCurve.h"
+#include "KdTree.h"
+#include "PointCloud.h"
+//C++
+#include <string>
+
+namespace
+{
+    constexpr unsigned int k = 8;
+
+    //The k nearest neighbours of every point, queried in memory order, then a pass that reads each point's neighbours
+    //back from the vertex buffer as a filter would. Both get faster the closer memory order follows space.
+    void timeNeighbourhoods(const char* order, const PointCloud& pointCloud)
+    {
+        std::size_t n = pointCloud.size();
+        std::unique_ptr<KdTree> tree = buildKdTree(pointCloud.data(), n);
+        std::vector<DirectX::XMFLOAT3> queries(n);
+        for (std::size_t i = 0; i < n; ++i)
+            queries[i] = pointCloud.data()[i].modelPos;
+        std::vector<std::uint32_t> indices(n * k);
+        std::vector<float> squaredDistances(n * k);
+
+        double seconds = fastestSeconds([&] { tree->nearest(queries.data(), n, k, indices.data(), squaredDistances.data()); });
+        reportThroughput((std::string(order) + ", kNN").c_str(), static_cast<double>(n), "points", seconds);
+
+        seconds = fastestSeconds([&] {
+            float sum = 0.0f;
+            for (std::size_t i = 0; i < indices.size(); ++i)
+                sum += pointCloud.data()[indices[i]].colour.x;
+            keepResult(sum);
+        });
+        reportThroughput((std::string(order) + ", neighbour gather").c_str(), static_cast<double>(n), "points", seconds);
+    }
+}
+
+//Reorders a cloud along the Morton and Hilbert curves and compares neighbourhood queries over it with the original,
+//spatially incoherent order.
+//Usage: CurveOrderBenchmark [points], 5 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 5'000'000);
+    PointCloud source(benchmarkVertices(nPoints));
+    source.bounds = calculateBounds(source.data(), source.size());
+    timeNeighbourhoods("source order", source);
+
+    for (CurveType curve : { CurveType::Morton, CurveType::Hilbert })
+    {
+        const char* name = curve == CurveType::Morton ? "Morton" : "Hilbert";
+        std::unique_ptr<PointCloud> reordered;
+        double seconds = fastestSeconds([&] { reordered = reorderAlongCurve(source, curve); });
+        reportThroughput((std::string("reorderAlongCurve, ") + name).c_str(), static_cast<double>(nPoints), "points", seconds);
+        timeNeighbourhoods(name, *reordered);
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "Benchmark.h"
+#include "FrustumCulling.h"
+#include "Octree.h"
+//C++
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr int nFrames = 360;
+
+    //A camera in the middle of the room turning a degree per frame, so consecutive frames are coherent
+    Frustum frameFrustum(int frame)
+    {
+        float angle = XMConvertToRadians(static_cast<float>(frame));
+        XMVECTOR eye = XMVectorSet(20.0f, 5.0f, 20.0f, 1.0f);
+        XMVECTOR target = XMVectorSet(20.0f + std::cos(angle), 5.0f, 20.0f + std::sin(angle), 1.0f);
+        XMMATRIX view = XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return extractFrustum(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)));
+    }
+}
+
+//Culls an octree with small leaves over a full turn of the camera, hierarchically with FrustumCuller and, for
+//comparison, by classifying every node's box. Throughput is in octree nodes per second.
+//Usage: FrustumCullingBenchmark [points], 10 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 10'000'000);
+    std::vector<PointCloudVertex> vertices = benchmarkVertices(nPoints);
+    std::unique_ptr<Octree> octree = buildOctree(vertices.data(), vertices.size(), calculateBounds(vertices.data(), vertices.size()).box,
+        256);
+    double nNodes = static_cast<double>(octree->nodes.size()) * nFrames;
+    std::printf("%zu nodes, %d frames\n", octree->nodes.size(), nFrames);
+
+    FrustumCuller culler;
+    double seconds = fastestSeconds([&] {
+        std::size_t nRanges = 0;
+        for (int frame = 0; frame < nFrames; ++frame)
+            nRanges += culler.cull(*octree, frameFrustum(frame)).size();
+        keepResult(nRanges);
+    });
+    reportThroughput("FrustumCuller::cull", nNodes, "nodes", seconds);
+
+    std::vector<BoundingBox> boxes(octree->nodes.size());
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+        boxes[i] = octree->nodes[i].bounds;
+    std::vector<std::uint8_t> masks(boxes.size());
+    seconds = fastestSeconds([&] {
+        for (int frame = 0; frame < nFrames; ++frame)
+            classifyBoxes(frameFrustum(frame), boxes.data(), boxes.size(), allFrustumPlanes, 0, masks.data());
+        keepResult(masks[0]);
+    });
+    reportThroughput("classifyBoxes, every node", nNodes, "nodes", seconds);
+    return 0;
+}
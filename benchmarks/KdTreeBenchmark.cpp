@@ -0,0 +1,46 @@
+#include "Benchmark.h"
+#include "KdTree.h"
+//C++
+#include <string>
+
+//Builds the kd-tree and queries the neighbourhood of every point: its k nearest for a few k, and all points within a
+//radius. Queries are issued in the tree's order, as the filters do.
+//Usage: KdTreeBenchmark [points], 5 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 5'000'000);
+    std::vector<PointCloudVertex> vertices = benchmarkVertices(nPoints);
+    double n = static_cast<double>(nPoints);
+
+    std::unique_ptr<KdTree> tree;
+    double seconds = fastestSeconds([&] { tree = buildKdTree(vertices.data(), vertices.size()); });
+    reportThroughput("buildKdTree", n, "points", seconds);
+
+    std::vector<DirectX::XMFLOAT3> queries(nPoints);
+    for (std::size_t i = 0; i < nPoints; ++i)
+        queries[i] = vertices[tree->treeOrder()[i]].modelPos;
+
+    for (unsigned int k : { 1u, 8u, 32u })
+    {
+        std::vector<std::uint32_t> indices(nPoints * k);
+        std::vector<float> squaredDistances(nPoints * k);
+        seconds = fastestSeconds([&] { tree->nearest(queries.data(), nPoints, k, indices.data(), squaredDistances.data()); });
+        reportThroughput(("nearest, k = " + std::to_string(k)).c_str(), n, "points", seconds);
+    }
+
+    //With 5 million points the walls hold about 2500 per square metre, so about 20 within this radius
+    RadiusNeighbours neighbours;
+    seconds = fastestSeconds([&] { neighbours = tree->withinRadius(queries.data(), nPoints, 0.05f); }, 1);
+    reportThroughput("withinRadius, 5 cm", n, "points", seconds);
+    std::printf("%-40s %12.1f\n", "  mean neighbours", static_cast<double>(neighbours.indices.size()) / n);
+
+    std::uint32_t index;
+    float squaredDistance;
+    seconds = fastestSeconds([&] {
+        for (std::size_t i = 0; i < nPoints; i += 16)
+            tree->nearest(queries[i], 1, &index, &squaredDistance);
+        keepResult(index);
+    });
+    reportThroughput("nearest, single queries", n / 16.0, "queries", seconds);
+    return 0;
+}
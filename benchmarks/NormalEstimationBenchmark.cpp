@@ -0,0 +1,26 @@
+#include "Benchmark.h"
+#include "NormalEstimation.h"
+//C++
+#include <string>
+
+//Estimates normals with a few neighbourhood sizes, both turned away from the centroid and towards a viewpoint.
+//Usage: NormalEstimationBenchmark [points], 5 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 5'000'000);
+    PointCloud pointCloud(benchmarkVertices(nPoints));
+    pointCloud.bounds = calculateBounds(pointCloud.data(), pointCloud.size());
+    std::vector<std::uint32_t> normals;
+
+    for (unsigned int nNeighbours : { 8u, defaultNormalNeighbours, 32u })
+    {
+        double seconds = fastestSeconds([&] { estimateNormals(pointCloud, normals, nNeighbours); }, 1);
+        reportThroughput(("estimateNormals, k = " + std::to_string(nNeighbours)).c_str(), static_cast<double>(nPoints), "points",
+            seconds);
+    }
+    double seconds = fastestSeconds([&] {
+        estimateNormals(pointCloud, normals, defaultNormalNeighbours, DirectX::XMFLOAT3(20.0f, 5.0f, 20.0f));
+    }, 1);
+    reportThroughput("estimateNormals, viewpoint", static_cast<double>(nPoints), "points", seconds);
+    return 0;
+}
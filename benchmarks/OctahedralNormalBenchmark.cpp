@@ -0,0 +1,45 @@
+#include "Benchmark.h"
+#include "OctahedralNormal.h"
+//C++
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+//Encodes and decodes random unit normals one at a time and with the batch versions.
+//Usage: OctahedralNormalBenchmark [normals], 20 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nNormals = countArgument(argc, argv, 20'000'000);
+    std::mt19937 random(4);
+    std::normal_distribution<float> gaussian;
+    std::vector<XMFLOAT3> normals(nNormals);
+    for (XMFLOAT3& normal : normals)
+    {
+        XMFLOAT3 direction(gaussian(random), gaussian(random), gaussian(random));
+        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+        normal = XMFLOAT3(direction.x / length, direction.y / length, direction.z / length);
+    }
+    std::vector<std::uint32_t> packed(nNormals);
+    std::vector<XMFLOAT3> decoded(nNormals);
+    double n = static_cast<double>(nNormals);
+
+    double seconds = fastestSeconds([&] {
+        for (std::size_t i = 0; i < nNormals; ++i)
+            packed[i] = encodeOctahedral(normals[i]);
+        keepResult(packed[nNormals / 2]);
+    });
+    reportThroughput("encodeOctahedral, scalar", n, "normals", seconds);
+    seconds = fastestSeconds([&] { encodeOctahedral(normals.data(), nNormals, packed.data()); });
+    reportThroughput("encodeOctahedral, batch", n, "normals", seconds);
+
+    seconds = fastestSeconds([&] {
+        for (std::size_t i = 0; i < nNormals; ++i)
+            decoded[i] = decodeOctahedral(packed[i]);
+        keepResult(decoded[nNormals / 2].x);
+    });
+    reportThroughput("decodeOctahedral, scalar", n, "normals", seconds);
+    seconds = fastestSeconds([&] { decodeOctahedral(packed.data(), nNormals, decoded.data()); });
+    reportThroughput("decodeOctahedral, batch", n, "normals", seconds);
+    return 0;
+}
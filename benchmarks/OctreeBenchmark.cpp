@@ -0,0 +1,81 @@
+#include "Benchmark.h"
+#include "Octree.h"
+//C++
+#include <random>
+
+namespace
+{
+    bool contains(const BoundingBox& outer, const BoundingBox& inner)
+    {
+        return inner.min.x >= outer.min.x && inner.min.y >= outer.min.y && inner.min.z >= outer.min.z
+            && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+    }
+
+    bool overlaps(const BoundingBox& a, const BoundingBox& b)
+    {
+        return a.min.x <= b.max.x && a.min.y <= b.max.y && a.min.z <= b.max.z
+            && b.min.x <= a.max.x && b.min.y <= a.max.y && b.min.z <= a.max.z;
+    }
+
+    //Points of the octree inside box. Nodes inside it count whole, since their points are one range, and only the
+    //leaves it cuts through are scanned.
+    std::uint64_t countInBox(const Octree& octree, const BoundingBox& box, std::uint32_t node = 0)
+    {
+        const OctreeNode& current = octree.nodes[node];
+        if (!overlaps(box, current.bounds))
+            return 0;
+        if (contains(box, current.bounds))
+            return current.nPoints;
+        std::uint64_t count = 0;
+        if (current.isLeaf())
+        {
+            for (std::uint64_t i = current.firstPoint; i < current.firstPoint + current.nPoints; ++i)
+            {
+                const DirectX::XMFLOAT3& p = octree.vertices[i].modelPos;
+                count += p.x >= box.min.x && p.y >= box.min.y && p.z >= box.min.z && p.x <= box.max.x && p.y <= box.max.y
+                    && p.z <= box.max.z;
+            }
+            return count;
+        }
+        std::uint32_t child = current.firstChild;
+        for (std::uint8_t mask = current.childMask; mask != 0; mask &= mask - 1)
+            count += countInBox(octree, box, child++);
+        return count;
+    }
+}
+
+//Builds the Morton octree, then answers neighbourhood queries with it: the points in a 0.5 unit box around
+//random points of the cloud.
+//Usage: OctreeBenchmark [points], 20 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 20'000'000);
+    std::vector<PointCloudVertex> vertices = benchmarkVertices(nPoints);
+    BoundingBox box = calculateBounds(vertices.data(), vertices.size()).box;
+
+    std::unique_ptr<Octree> octree;
+    double seconds = fastestSeconds([&] { octree = buildOctree(vertices.data(), vertices.size(), box); });
+    reportThroughput("buildOctree", static_cast<double>(nPoints), "points", seconds);
+    std::printf("%-40s %12zu\n", "  nodes", octree->nodes.size());
+
+    constexpr std::size_t nQueries = 100'000;
+    constexpr float halfSide = 0.25f;
+    std::mt19937 random(2);
+    std::uniform_int_distribution<std::size_t> pick(0, nPoints - 1);
+    std::vector<BoundingBox> queries(nQueries);
+    for (BoundingBox& query : queries)
+    {
+        const DirectX::XMFLOAT3& centre = vertices[pick(random)].modelPos;
+        query.min = DirectX::XMFLOAT3(centre.x - halfSide, centre.y - halfSide, centre.z - halfSide);
+        query.max = DirectX::XMFLOAT3(centre.x + halfSide, centre.y + halfSide, centre.z + halfSide);
+    }
+    std::uint64_t nFound = 0;
+    seconds = fastestSeconds([&] {
+        nFound = 0;
+        for (const BoundingBox& query : queries)
+            nFound += countInBox(*octree, query);
+    });
+    reportThroughput("box queries, one thread", static_cast<double>(nQueries), "queries", seconds);
+    reportThroughput("  points found", static_cast<double>(nFound), "points", seconds);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "Benchmark.h"
+#include "OutlierFilter.h"
+//C++
+#include <string>
+
+//Removes statistical outliers with a few neighbourhood sizes. The scattered fifth of the generated points is sparse
+//next to the walls, so a share of it goes.
+//Usage: OutlierFilterBenchmark [points], 5 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 5'000'000);
+    PointCloud pointCloud(benchmarkVertices(nPoints));
+    pointCloud.bounds = calculateBounds(pointCloud.data(), pointCloud.size());
+
+    for (unsigned int nNeighbours : { 4u, defaultOutlierNeighbours, 16u })
+    {
+        std::unique_ptr<PointCloud> filtered;
+        double seconds = fastestSeconds([&] { filtered = removeStatisticalOutliers(pointCloud, nNeighbours); }, 1);
+        reportThroughput(("removeStatisticalOutliers, k = " + std::to_string(nNeighbours)).c_str(), static_cast<double>(nPoints),
+            "points", seconds);
+        std::printf("%-40s %12zu\n", "  removed", filtered ? nPoints - filtered->size() : 0);
+    }
+    return 0;
+}
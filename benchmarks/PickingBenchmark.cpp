@@ -0,0 +1,43 @@
+#include "Benchmark.h"
+#include "Picking.h"
+//C++
+#include <random>
+
+using namespace DirectX;
+
+//Builds the picker's blocks over a level of detail hierarchy, then picks random pixels of a view from inside the room.
+//Usage: PickingBenchmark [points], 10 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 10'000'000);
+    std::vector<PointCloudVertex> vertices = benchmarkVertices(nPoints);
+    std::unique_ptr<LodHierarchy> hierarchy = buildLodHierarchy(vertices.data(), vertices.size(),
+        calculateBounds(vertices.data(), vertices.size()).box);
+
+    PointPicker picker;
+    double seconds = fastestSeconds([&] { picker.build(hierarchy->nodes, hierarchy->vertices.data()); });
+    reportThroughput("PointPicker::build", static_cast<double>(nPoints), "points", seconds);
+
+    constexpr unsigned int rtvWidth = 1920;
+    constexpr unsigned int rtvHeight = 1080;
+    constexpr std::size_t nPicks = 10'000;
+    XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(20.0f, 5.0f, 30.0f, 1.0f), XMVectorSet(20.0f, 4.0f, 0.0f, 1.0f),
+        XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX MVP = XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f));
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> pixelX(0.0f, static_cast<float>(rtvWidth));
+    std::uniform_real_distribution<float> pixelY(0.0f, static_cast<float>(rtvHeight));
+    std::vector<PickRay> rays(nPicks);
+    for (PickRay& ray : rays)
+        ray = pickRay(MVP, pixelX(random), pixelY(random), rtvWidth, rtvHeight);
+
+    std::size_t nHits = 0;
+    seconds = fastestSeconds([&] {
+        nHits = 0;
+        for (const PickRay& ray : rays)
+            nHits += picker.pick(hierarchy->nodes, hierarchy->vertices.data(), ray).has_value();
+    });
+    reportThroughput("PointPicker::pick", static_cast<double>(nPicks), "picks", seconds);
+    std::printf("%-40s %12zu of %zu\n", "  hits", nHits, nPicks);
+    return 0;
+}
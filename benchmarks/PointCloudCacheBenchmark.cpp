@@ -0,0 +1,43 @@
+#include "Benchmark.h"
+#include "PointCloudCache.h"
+//C++
+#include <filesystem>
+#include <string>
+
+//Writes and reopens the binary cache, with and without a level of detail hierarchy. Reopening only maps the file, so
+//it is also timed with a pass that reads every vertex back, which is what a first frame would pay for.
+//Usage: PointCloudCacheBenchmark [points], 10 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 10'000'000);
+    PointCloud pointCloud(benchmarkVertices(nPoints));
+    pointCloud.bounds = calculateBounds(pointCloud.data(), pointCloud.size());
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pcv_cache_benchmark.pcvcache";
+    SourceFingerprint fingerprint = { nPoints, 1, 2 };
+    double nBytes = static_cast<double>(nPoints * sizeof(PointCloudVertex));
+
+    for (bool withLod : { false, true })
+    {
+        if (withLod)
+            pointCloud.lod = buildLodHierarchy(pointCloud.data(), pointCloud.size(), pointCloud.bounds->box);
+        const char* suffix = withLod ? ", with LOD" : "";
+
+        double seconds = fastestSeconds([&] { writePointCloudCache(path, fingerprint, pointCloud); });
+        reportThroughput((std::string("write") + suffix).c_str(), static_cast<double>(nPoints), "points", seconds);
+        reportThroughput((std::string("write") + suffix).c_str(), nBytes / 1048576.0, "MiB", seconds);
+
+        seconds = fastestSeconds([&] { openPointCloudCache(path, fingerprint, withLod); });
+        reportThroughput((std::string("open") + suffix).c_str(), static_cast<double>(nPoints), "points", seconds);
+
+        seconds = fastestSeconds([&] {
+            std::unique_ptr<PointCloud> cached = openPointCloudCache(path, fingerprint, withLod);
+            float sum = 0.0f;
+            for (std::size_t i = 0; cached && i < cached->size(); ++i)
+                sum += cached->data()[i].modelPos.x;
+            keepResult(sum);
+        });
+        reportThroughput((std::string("open and read") + suffix).c_str(), nBytes / 1048576.0, "MiB", seconds);
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include "Benchmark.h"
+#include "VoxelFilter.h"
+//C++
+#include <string>
+
+//Downsamples a cloud at a few voxel sizes, with both kinds of representative.
+//Usage: VoxelFilterBenchmark [points], 20 million by default.
+int main(int argc, char** argv)
+{
+    std::size_t nPoints = countArgument(argc, argv, 20'000'000);
+    PointCloud pointCloud(benchmarkVertices(nPoints));
+    pointCloud.bounds = calculateBounds(pointCloud.data(), pointCloud.size());
+
+    for (float voxelSize : { 0.01f, 0.05f, 0.25f })
+    {
+        for (VoxelRepresentative representative : { VoxelRepresentative::Centroid, VoxelRepresentative::NearestToCentroid })
+        {
+            std::unique_ptr<PointCloud> downsampled;
+            double seconds = fastestSeconds([&] { downsampled = voxelDownsample(pointCloud, voxelSize, representative); });
+            std::string name = "voxelDownsample, " + std::to_string(static_cast<int>(voxelSize * 100.0f + 0.5f)) + " cm, "
+                + (representative == VoxelRepresentative::Centroid ? "centroid" : "nearest");
+            reportThroughput(name.c_str(), static_cast<double>(nPoints), "points", seconds);
+            std::printf("%-40s %12zu\n", "  kept", downsampled ? downsampled->size() : 0);
+        }
+    }
+    return 0;
+}
@@ -1,6 +1,8 @@
 struct InputAttributes {
-    float3 modelPos : POSITION;
-    float3 colour : COLOR;
+    uint2 packedPos : POSITION; //21 bits per axis, relative to the segment's quantization block
+    float4 colour : COLOR;
+    float2 octahedralNormal : NORMAL; //Two snorm16 coordinates, see OctahedralNormal.h
+    float4 coarseColour : COLOR1; //Mean colour of the cells an inner node's point stands for
 };
 struct OutputAttributes{
     float4 clipPos: SV_Position;
@@ -9,16 +11,41 @@ struct OutputAttributes{
 
 struct Transform
 {
-    matrix mat;
-
+    matrix mat; //Includes the segment's dequantization
+    float3 headlight; //Unit direction towards the camera, in model space
+    float lighting; //1 to shade by the normals, 0 if the cloud has none
+    float coarse; //1 while drawing inner nodes none of whose children are drawn
 };
 ConstantBuffer<Transform> TransformCB : register(b0);
 
+static const float ambient = 0.3f;
+
+float3 unpackPosition(uint2 packedPos)
+{
+    uint x = packedPos.x & 0x1FFFFF;
+    uint y = (packedPos.x >> 21) | ((packedPos.y & 0x3FF) << 11);
+    uint z = (packedPos.y >> 10) & 0x1FFFFF;
+    return float3(x, y, z);
+}
+
+//The point on the octahedron, with the lower half folded back out of the square's corners
+float3 decodeOctahedral(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    //step(0, x) * 2 - 1 is the sign with 0 counted as positive, written so it compiles with and without HLSL 2021
+    float fold = saturate(-normal.z);
+    normal.xy -= (step(0.0f, normal.xy) * 2.0f - 1.0f) * fold;
+    return normalize(normal);
+}
+
 OutputAttributes main(InputAttributes IN)
 {
     OutputAttributes OUT;
-    OUT.clipPos = mul(TransformCB.mat,float4(IN.modelPos, 1.0f));
-    OUT.colour = IN.colour;
-   
+    OUT.clipPos = mul(TransformCB.mat,float4(unpackPosition(IN.packedPos), 1.0f));
+    //Two sided, scanned and estimated normals aren't reliably oriented
+    float diffuse = abs(dot(decodeOctahedral(IN.octahedralNormal), TransformCB.headlight));
+    float3 colour = lerp(IN.colour.rgb, IN.coarseColour.rgb, TransformCB.coarse);
+    OUT.colour = colour * lerp(1.0f, ambient + (1.0f - ambient) * diffuse, TransformCB.lighting);
+
     return OUT;
-}
\ No newline at end of file
+}
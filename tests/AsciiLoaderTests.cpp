@@ -0,0 +1,79 @@
+#include "Check.h"
+#include "PointCloudLoader.h"
+//C++
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    std::filesystem::path writeTextFile(const std::string& name, const std::string& text)
+    {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+        std::ofstream(path, std::ios::binary) << text;
+        return path;
+    }
+
+    void testSplitAtLineBoundaries()
+    {
+        std::string text;
+        for (int i = 0; i < 1000; ++i)
+            text += std::to_string(i) + " " + std::to_string(i * 2) + " " + std::to_string(i * 3) + "\n";
+        for (std::size_t nChunks : { 1, 2, 7, 64, 5000 })
+        {
+            std::vector<std::string_view> chunks = splitAtLineBoundaries(text, nChunks);
+            CHECK(!chunks.empty() && chunks.size() <= nChunks);
+            //The chunks alias the text back to back and each one ends a line
+            const char* next = text.data();
+            for (std::string_view chunk : chunks)
+            {
+                CHECK(chunk.data() == next);
+                CHECK(!chunk.empty() && chunk.back() == '\n');
+                next = chunk.data() + chunk.size();
+            }
+            CHECK(next == text.data() + text.size());
+        }
+    }
+
+    //Quarters and 0-255 colours are exact in float, so the parsed cloud must match them exactly
+    void testReadPointCloudASC()
+    {
+        constexpr int nPoints = 20000;
+        std::string text;
+        for (int i = 0; i < nPoints; ++i)
+        {
+            text += std::to_string(i * 0.25) + " " + std::to_string(-i * 0.5) + " " + std::to_string(i % 7) + " ";
+            text += std::to_string(i % 256) + " " + std::to_string((i * 3) % 256) + " " + std::to_string((i * 7) % 256);
+            //The last line has no newline and must still be read
+            if (i + 1 != nPoints)
+                text += "\n";
+        }
+        std::filesystem::path path = writeTextFile("pcv_ascii_loader_test.asc", text);
+
+        std::unique_ptr<PointCloud> pointCloud = readPointCloudASC(path);
+        CHECK(pointCloud && pointCloud->size() == nPoints);
+        if (pointCloud && pointCloud->size() == nPoints)
+        {
+            bool inFileOrder = true;
+            for (int i = 0; i < nPoints; ++i)
+            {
+                const PointCloudVertex& vertex = pointCloud->data()[i];
+                inFileOrder = inFileOrder && vertex.modelPos.x == i * 0.25f && vertex.modelPos.y == -i * 0.5f
+                    && vertex.modelPos.z == static_cast<float>(i % 7) && vertex.colour.x == (i % 256) / 255.0f
+                    && vertex.colour.y == ((i * 3) % 256) / 255.0f && vertex.colour.z == ((i * 7) % 256) / 255.0f;
+            }
+            CHECK(inFileOrder);
+            CHECK(pointCloud->bounds && pointCloud->bounds->box.min.x == 0.0f && pointCloud->bounds->box.max.x == (nPoints - 1) * 0.25f);
+        }
+        std::filesystem::remove(path);
+
+        CHECK(!readPointCloudASC(std::filesystem::temp_directory_path() / "pcv_missing_file.asc"));
+    }
+}
+
+int main()
+{
+    testSplitAtLineBoundaries();
+    testReadPointCloudASC();
+    return testResult();
+}
@@ -0,0 +1,198 @@
+#include "Check.h"
+#include "AsciiParser.h"
+#include "PointCloudLoader.h"
+//C++
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    //parseFloatASC must round exactly like strtof and stop where it stops
+    bool matchesStrtof(const std::string& token, char delimiter)
+    {
+        std::string text = token + delimiter + "7";
+        const char* cursor = text.data();
+        float value = 0.0f;
+        if (!parseFloatASC(cursor, text.data() + text.size(), value))
+            return false;
+        char* end = nullptr;
+        float expected = std::strtof(text.c_str(), &end);
+        return std::memcmp(&value, &expected, sizeof(float)) == 0 && cursor == end;
+    }
+
+    void testFixedDecimals()
+    {
+        std::mt19937_64 random(1);
+        const char delimiters[] = { ' ', '\t', ',', ';', '\n', '\r' };
+        int nMismatches = 0;
+        for (int i = 0; i < 200000; ++i)
+        {
+            //Up to 10 digits before and 10 after the point, covering the fast path and both sides of its limits
+            std::uniform_int_distribution<int> nDigits(0, 10);
+            int nIntegerDigits = nDigits(random), nFractionDigits = nDigits(random);
+            std::string token = random() % 2 ? "-" : "";
+            for (int digit = 0; digit < nIntegerDigits || (nIntegerDigits == 0 && digit == 0); ++digit)
+                token += static_cast<char>('0' + random() % 10);
+            if (nFractionDigits != 0)
+            {
+                token += '.';
+                for (int digit = 0; digit < nFractionDigits; ++digit)
+                    token += static_cast<char>('0' + random() % 10);
+            }
+            if (!matchesStrtof(token, delimiters[i % sizeof(delimiters)]))
+            {
+                if (nMismatches++ < 10)
+                    std::fprintf(stderr, "mismatch for \"%s\"\n", token.c_str());
+            }
+        }
+        CHECK(nMismatches == 0);
+    }
+
+    void testFallbacks()
+    {
+        for (const char* token : { "1e3", "-2.5E-3", "123456789012345678901234", "0.000000000001234", "16777217", "16777216.5",
+            "3.4028235e38", "1e-45", "+12.75", ".5", "-.25", "5.", "0", "-0" })
+        {
+            CHECK(matchesStrtof(token, ' '));
+        }
+
+        const char* text = "x1.0";
+        const char* cursor = text;
+        float value;
+        CHECK(!parseFloatASC(cursor, text + std::strlen(text), value) && cursor == text);
+    }
+
+    //The record parser the viewer shipped with, as it was: whitespace separated "x y z r g b nx ny nz" read with
+    //operator>> until the first record that doesn't parse, normals dropped
+    std::vector<PointCloudVertex> parseWithBaseline(const std::string& text)
+    {
+        std::vector<PointCloudVertex> verts;
+        float x, y, z;
+        int r, g, b;
+        float nx, ny, nz;
+        std::istringstream in(text);
+        while (in >> x >> y >> z >> r >> g >> b >> nx >> ny >> nz) {
+            verts.emplace_back(
+                DirectX::XMFLOAT3(x, y, z),
+                DirectX::XMFLOAT3(r / 255.0f, g / 255.0f, b / 255.0f)
+            );
+        }
+        return verts;
+    }
+
+    bool identicalVertices(const std::vector<PointCloudVertex>& a, const PointCloudVertex* b, std::size_t nB)
+    {
+        return a.size() == nB && (nB == 0 || std::memcmp(a.data(), b, nB * sizeof(PointCloudVertex)) == 0);
+    }
+
+    //A coordinate in one of the ways exporters write them
+    std::string randomCoordinate(std::mt19937_64& random)
+    {
+        char token[64];
+        double value = std::uniform_real_distribution<double>(-100000.0, 100000.0)(random) / std::pow(10.0, random() % 6);
+        switch (random() % 6)
+        {
+        case 0: std::snprintf(token, sizeof(token), "%.*f", static_cast<int>(random() % 9), value); break;
+        case 1: std::snprintf(token, sizeof(token), "%.*e", static_cast<int>(random() % 9), value); break;
+        case 2: std::snprintf(token, sizeof(token), "%.9g", value); break;
+        case 3: std::snprintf(token, sizeof(token), "%d", static_cast<int>(value)); break;
+        case 4: std::snprintf(token, sizeof(token), "%+.3f", value); break;
+        default: std::snprintf(token, sizeof(token), "%.17g", value); break;
+        }
+        return token;
+    }
+
+    //Whole records of the baseline's layout must parse to bit identical vertices: positions, integer colours scaled
+    //by 1/255, every blank run and line ending it accepted, and a last record without a newline. The text spans
+    //several loader blocks, so the split into blocks is covered too.
+    void testBaselineParity()
+    {
+        std::mt19937_64 random(2);
+        const char* separators[] = { " ", "\t", "  ", " \t ", "\t\t" };
+        const char* lineEnds[] = { "\n", "\r\n", " \n", "\t\r\n" };
+        std::string text;
+        while (text.size() < 3 * asciiBlockSize)
+        {
+            std::string fields[9];
+            for (int i = 0; i < 3; ++i)
+                fields[i] = randomCoordinate(random);
+            for (int i = 3; i < 6; ++i)
+                fields[i] = std::to_string(random() % 256);
+            for (int i = 6; i < 9; ++i)
+                fields[i] = std::to_string(std::uniform_real_distribution<double>(-1.0, 1.0)(random));
+            if (random() % 8 == 0)
+                text += random() % 2 ? "  " : "\t";
+            for (int i = 0; i < 9; ++i)
+                text += fields[i] + (i < 8 ? separators[random() % 5] : "");
+            text += lineEnds[random() % 4];
+            if (random() % 64 == 0)
+                text += random() % 2 ? "\n" : " \r\n";
+        }
+        text += "1.5 -2.25 3 255 0 128 0 0 1";
+
+        std::vector<PointCloudVertex> expected = parseWithBaseline(text);
+        CHECK(expected.size() > 100000);
+        std::optional<AsciiSchema> schema = detectAsciiSchema(text.substr(0, schemaSampleSize));
+        CHECK(schema && schema->columns.size() == 9 && schema->colourType == ColourType::UInt8);
+        if (!schema)
+            return;
+        std::vector<PointCloudVertex> parsed(text.size() / 16);
+        std::vector<std::uint32_t> normals(parsed.size());
+        BoundsAccumulator bounds;
+        parsed.resize(selectAsciiBlockParser(*schema)(text, parsed.data(), normals.data(), *schema, bounds));
+        CHECK(identicalVertices(expected, parsed.data(), parsed.size()));
+
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "pcv_ascii_parity_test.txt";
+        std::ofstream(path, std::ios::binary).write(text.data(), static_cast<std::streamsize>(text.size()));
+        std::unique_ptr<PointCloud> loaded = readPointCloudASC(path);
+        CHECK(loaded && identicalVertices(expected, loaded->data(), loaded->size()));
+        std::filesystem::remove(path);
+    }
+
+    //Where the baseline went wrong the parser follows lines instead. Extra trailing fields used to be read as the
+    //next record's x, shifting every later record, and are now ignored, so the result is the baseline's on the text
+    //without them. A malformed line used to end the parse, and is now skipped.
+    void testBaselineDifferences()
+    {
+        std::string clean = "1 2 3 10 20 30 0 0 1\n4 5 6 40 50 60 0 1 0\n7 8 9 70 80 90 1 0 0\n";
+        std::string trailing = "1 2 3 10 20 30 0 0 1 0.5 extra\n4 5 6 40 50 60 0 1 0 7\n7 8 9 70 80 90 1 0 0\n";
+        std::optional<AsciiSchema> schema = detectAsciiSchema(clean);
+        CHECK(schema && schema->columns.size() == 9);
+        if (!schema)
+            return;
+        auto parse = [&](const std::string& text) {
+            std::vector<PointCloudVertex> vertices(8);
+            std::vector<std::uint32_t> normals(vertices.size());
+            BoundsAccumulator bounds;
+            vertices.resize(selectAsciiBlockParser(*schema)(text, vertices.data(), normals.data(), *schema, bounds));
+            return vertices;
+        };
+        std::vector<PointCloudVertex> expected = parseWithBaseline(clean);
+        std::vector<PointCloudVertex> parsed = parse(trailing);
+        CHECK(expected.size() == 3 && identicalVertices(expected, parsed.data(), parsed.size()));
+        CHECK(!identicalVertices(parseWithBaseline(trailing), expected.data(), expected.size()));
+
+        std::string malformed = "1 2 3 10 20 30 0 0 1\n4 5 six 40 50 60 0 1 0\n7 8 9 70 80 90 1 0 0\n";
+        parsed = parse(malformed);
+        CHECK(parseWithBaseline(malformed).size() == 1);
+        CHECK(parsed.size() == 2 && std::memcmp(&parsed[0], &expected[0], sizeof(PointCloudVertex)) == 0
+            && std::memcmp(&parsed[1], &expected[2], sizeof(PointCloudVertex)) == 0);
+    }
+}
+
+int main()
+{
+    testFixedDecimals();
+    testFallbacks();
+    testBaselineParity();
+    testBaselineDifferences();
+    return testResult();
+}
@@ -0,0 +1,172 @@
+#include "Check.h"
+#include "AsciiSchema.h"
+//C++
+#include <string>
+#include <vector>
+
+namespace
+{
+    using R = ColumnRole;
+
+    //Parses every record of text after the schema's header
+    std::vector<PointCloudVertex> parseRecords(std::string_view text, const AsciiSchema& schema)
+    {
+        std::string_view records = text.substr(schema.headerLength);
+        std::vector<PointCloudVertex> vertices(records.size() + 1);
+        std::vector<std::uint32_t> normals(hasNormals(schema) ? vertices.size() : 0);
+        BoundsAccumulator bounds;
+        vertices.resize(selectAsciiBlockParser(schema)(records, vertices.data(), normals.empty() ? nullptr : normals.data(), schema, bounds));
+        return vertices;
+    }
+
+    bool isPoint(const PointCloudVertex& vertex, float x, float y, float z)
+    {
+        return vertex.modelPos.x == x && vertex.modelPos.y == y && vertex.modelPos.z == z;
+    }
+
+    void testColumnCounts()
+    {
+        struct Case
+        {
+            const char* text;
+            std::vector<ColumnRole> columns;
+            char delimiter;
+        };
+        const Case cases[] = {
+            { "1 2 3\n4 5 6\n", { R::X, R::Y, R::Z }, ' ' },
+            { "1\t2\t3\t0.5\n", { R::X, R::Y, R::Z, R::Intensity }, ' ' },
+            { "1,2,3,255,0,0\n", { R::X, R::Y, R::Z, R::Red, R::Green, R::Blue }, ',' },
+            { "1;2;3;7;255;0;0\n", { R::X, R::Y, R::Z, R::Intensity, R::Red, R::Green, R::Blue }, ';' },
+            { "1 2 3 255 0 0 0 0 1\n", { R::X, R::Y, R::Z, R::Red, R::Green, R::Blue, R::NormalX, R::NormalY, R::NormalZ }, ' ' },
+            { "1 2 3 4 5\n", { R::X, R::Y, R::Z, R::Skip, R::Skip }, ' ' },
+        };
+        for (const Case& testCase : cases)
+        {
+            std::optional<AsciiSchema> schema = detectAsciiSchema(testCase.text);
+            CHECK(schema && schema->columns == testCase.columns && schema->delimiter == testCase.delimiter && schema->headerLength == 0);
+        }
+        CHECK(!detectAsciiSchema("1 2\n3 4\n"));
+        CHECK(!detectAsciiSchema("\n \n"));
+    }
+
+    void testNameRows()
+    {
+        std::string text = "X,Y,Z,Red,Green,Blue\n1,2,3,255,128,0\n";
+        std::optional<AsciiSchema> schema = detectAsciiSchema(text);
+        CHECK(schema && schema->columns == std::vector<ColumnRole>({ R::X, R::Y, R::Z, R::Red, R::Green, R::Blue }));
+        CHECK(schema && schema->headerLength == text.find('\n') + 1);
+
+        //Names it doesn't know are skipped when the row names the coordinates
+        schema = detectAsciiSchema("label x y z nx ny nz\nA 1 2 3 0 0 1\n");
+        CHECK(schema && schema->columns == std::vector<ColumnRole>({ R::Skip, R::X, R::Y, R::Z, R::NormalX, R::NormalY, R::NormalZ }));
+
+        //Rows that don't name all three coordinates used to load every record at the origin. They are now only
+        //trusted for their length.
+        text = "Easting,Northing,Elevation\n500000.5,4100000.25,12.5\n";
+        schema = detectAsciiSchema(text);
+        CHECK(schema && schema->columns == std::vector<ColumnRole>({ R::X, R::Y, R::Z }) && schema->headerLength == text.find('\n') + 1);
+        std::vector<PointCloudVertex> vertices = schema ? parseRecords(text, *schema) : std::vector<PointCloudVertex>();
+        CHECK(vertices.size() == 1 && isPoint(vertices[0], 500000.5f, 4100000.25f, 12.5f));
+
+        schema = detectAsciiSchema("lon lat height r g b\n1 2 3 255 255 255\n");
+        CHECK(schema && schema->columns == std::vector<ColumnRole>({ R::X, R::Y, R::Z, R::Red, R::Green, R::Blue }));
+        schema = detectAsciiSchema("x,elevation,a,b,c\n1,2,3,4,5\n");
+        CHECK(schema && schema->columns == std::vector<ColumnRole>({ R::X, R::Y, R::Z, R::Skip, R::Skip }));
+        CHECK(!detectAsciiSchema("lon,lat\n1,2\n"));
+    }
+
+    //Given roles win over detection, even where detection finds nothing
+    void testExplicitColumns()
+    {
+        std::string text = "pt name\n1 2 3\n";
+        CHECK(!detectAsciiSchema(text));
+        std::optional<AsciiSchema> schema = detectAsciiSchema(text, { R::X, R::Y, R::Z });
+        CHECK(schema && schema->headerLength == text.find('\n') + 1);
+        std::vector<PointCloudVertex> vertices = schema ? parseRecords(text, *schema) : std::vector<PointCloudVertex>();
+        CHECK(vertices.size() == 1 && isPoint(vertices[0], 1.0f, 2.0f, 3.0f));
+
+        //A skipped text column in the first record doesn't make it a header
+        text = "first 1 2 3\nsecond 4 5 6\n";
+        schema = detectAsciiSchema(text, { R::Skip, R::X, R::Y, R::Z });
+        CHECK(schema && schema->headerLength == 0 && schema->columns == std::vector<ColumnRole>({ R::Skip, R::X, R::Y, R::Z }));
+        vertices = schema ? parseRecords(text, *schema) : std::vector<PointCloudVertex>();
+        CHECK(vertices.size() == 2 && isPoint(vertices[0], 1.0f, 2.0f, 3.0f) && isPoint(vertices[1], 4.0f, 5.0f, 6.0f));
+
+        //Overriding the roles of a detected layout
+        schema = detectAsciiSchema("1 2 3 4 5 6\n", { R::Z, R::Y, R::X, R::Skip, R::Skip, R::Skip });
+        CHECK(schema && schema->columns.front() == R::Z);
+
+        std::vector<ColumnRole> columns;
+        CHECK(parseColumnRoles("x,y,z,_,r,g,b", columns) && columns.size() == 7 && columns[3] == R::Skip);
+        CHECK(!parseColumnRoles("x,y,r,g,b", columns));
+        CHECK(!parseColumnRoles("x,y,z,colour", columns));
+    }
+
+    void testColourTypes()
+    {
+        std::optional<AsciiSchema> schema = detectAsciiSchema("1 2 3 0.5 0.25 1.0\n4 5 6 0.0 0.1 0.2\n");
+        CHECK(schema && schema->colourType == ColourType::UnitFloat);
+        schema = detectAsciiSchema("1 2 3 0.5 0.25 1.0\n4 5 6 200 0 0\n");
+        CHECK(schema && schema->colourType == ColourType::UInt8);
+        schema = detectAsciiSchema("1 2 3 1 1 1\n");
+        CHECK(schema && schema->colourType == ColourType::UInt8);
+    }
+
+    //Regression for the PTS count: only a non-negative count that fits is kept, but any lone integer is the header
+    void testPtsCount()
+    {
+        std::string text = "1000\n1 2 3 7 255 0 0\n";
+        std::optional<AsciiSchema> schema = detectAsciiSchema(text);
+        CHECK(schema && schema->declaredCount == 1000u && schema->headerLength == 5);
+        CHECK(schema && schema->columns == std::vector<ColumnRole>({ R::X, R::Y, R::Z, R::Intensity, R::Red, R::Green, R::Blue }));
+
+        for (const char* count : { "-5", "99999999999999999999999" })
+        {
+            text = std::string(count) + "\n1 2 3\n";
+            schema = detectAsciiSchema(text);
+            CHECK(schema && !schema->declaredCount && schema->headerLength == text.find('\n') + 1);
+            std::vector<PointCloudVertex> vertices = schema ? parseRecords(text, *schema) : std::vector<PointCloudVertex>();
+            CHECK(vertices.size() == 1 && isPoint(vertices[0], 1.0f, 2.0f, 3.0f));
+        }
+        //A count with nothing after it isn't a cloud
+        CHECK(!detectAsciiSchema("12\n"));
+    }
+
+    //Regression for free-text columns: they may hold blanks and quoted delimiters, and only end at the delimiter
+    void testFreeTextColumns()
+    {
+        AsciiSchema schema;
+        schema.columns = { R::Skip, R::X, R::Y, R::Z };
+        schema.delimiter = ',';
+        std::string text = "Smith John,1,2,3\n\"Doe, Jane\",4,5,6\n,7,8,9\n";
+        std::vector<PointCloudVertex> vertices = parseRecords(text, schema);
+        CHECK(vertices.size() == 3 && isPoint(vertices[0], 1.0f, 2.0f, 3.0f) && isPoint(vertices[1], 4.0f, 5.0f, 6.0f)
+            && isPoint(vertices[2], 7.0f, 8.0f, 9.0f));
+
+        schema.columns = { R::X, R::Skip, R::Y, R::Z };
+        schema.delimiter = ';';
+        vertices = parseRecords("1;free text here;2;3\n", schema);
+        CHECK(vertices.size() == 1 && isPoint(vertices[0], 1.0f, 2.0f, 3.0f));
+
+        //Blank delimited text columns end at the first blank
+        schema.columns = { R::Skip, R::X, R::Y, R::Z };
+        schema.delimiter = ' ';
+        vertices = parseRecords("name 1 2 3\n", schema);
+        CHECK(vertices.size() == 1 && isPoint(vertices[0], 1.0f, 2.0f, 3.0f));
+
+        //A line missing a column is dropped
+        vertices = parseRecords("name 1 2\nname 4 5 6\n", schema);
+        CHECK(vertices.size() == 1 && isPoint(vertices[0], 4.0f, 5.0f, 6.0f));
+    }
+}
+
+int main()
+{
+    testColumnCounts();
+    testNameRows();
+    testExplicitColumns();
+    testColourTypes();
+    testPtsCount();
+    testFreeTextColumns();
+    return testResult();
+}
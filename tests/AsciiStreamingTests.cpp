@@ -0,0 +1,81 @@
+#include "Check.h"
+#include "PointCloudLoader.h"
+//C++
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace
+{
+    std::filesystem::path writeTextFile(const std::string& name, const std::string& text)
+    {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+        std::ofstream(path, std::ios::binary) << text;
+        return path;
+    }
+
+    //Records of very different lengths, so no fixed record length describes the file
+    std::string generateRecords(int nPoints, bool withNormals, unsigned int seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<double> coordinate(-1000.0, 1000.0);
+        std::string text;
+        for (int i = 0; i < nPoints; ++i)
+        {
+            char line[256];
+            int precision = i % 3 == 0 ? 2 : 9;
+            int length = std::snprintf(line, sizeof(line), "%.*f %.*f %.*f %d %d %d", precision, coordinate(random), precision,
+                coordinate(random), precision, coordinate(random), static_cast<int>(random() % 256), static_cast<int>(random() % 256),
+                static_cast<int>(random() % 256));
+            if (withNormals)
+                length += std::snprintf(line + length, sizeof(line) - length, " %.6f %.6f %.6f", 0.0, 0.6, -0.8);
+            text.append(line, length);
+            text += '\n';
+        }
+        return text;
+    }
+
+    bool sameClouds(const PointCloud& a, const PointCloud& b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(PointCloudVertex)) == 0 && a.normals == b.normals
+            && a.bounds && b.bounds && std::memcmp(&a.bounds->box, &b.bounds->box, sizeof(BoundingBox)) == 0;
+    }
+
+    //Every budget must give exactly what the mapped loader gives, however the text falls into buffers
+    void testStreamedMatchesMapped()
+    {
+        struct Case
+        {
+            const char* name;
+            std::string text;
+        };
+        Case cases[] = {
+            { "pcv_streaming_plain.xyz", generateRecords(60000, false, 4) },
+            { "pcv_streaming_normals.xyz", generateRecords(40000, true, 40) },
+            //A PTS count that undercounts the records may only narrow the reserve, never drop points
+            { "pcv_streaming_count.pts", "1000\n" + generateRecords(30000, false, 400) },
+        };
+        for (const Case& testCase : cases)
+        {
+            std::filesystem::path path = writeTextFile(testCase.name, testCase.text);
+            std::unique_ptr<PointCloud> mapped = readPointCloudASC(path);
+            CHECK(mapped && mapped->size() > 0);
+            for (std::size_t budget : { std::size_t(128) << 10, std::size_t(1) << 20, defaultStreamingBudget })
+            {
+                std::unique_ptr<PointCloud> streamed = readPointCloudASCStreamed(path, {}, budget);
+                CHECK(mapped && streamed && sameClouds(*mapped, *streamed));
+            }
+            std::filesystem::remove(path);
+        }
+        CHECK(!readPointCloudASCStreamed(std::filesystem::temp_directory_path() / "pcv_missing_file.xyz"));
+    }
+}
+
+int main()
+{
+    testStreamedMatchesMapped();
+    return testResult();
+}
@@ -0,0 +1,255 @@
+#include "Check.h"
+#include "Bounds.h"
+#include "PointCloud.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    double distance(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+    {
+        double dx = static_cast<double>(a.x) - b.x, dy = static_cast<double>(a.y) - b.y, dz = static_cast<double>(a.z) - b.z;
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    double dot(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+    {
+        return static_cast<double>(a.x) * b.x + static_cast<double>(a.y) * b.y + static_cast<double>(a.z) * b.z;
+    }
+
+    std::vector<PointCloudVertex> fromPositions(const std::vector<DirectX::XMFLOAT3>& positions)
+    {
+        std::vector<PointCloudVertex> vertices(positions.size());
+        for (std::size_t i = 0; i < positions.size(); ++i)
+            vertices[i].modelPos = positions[i];
+        return vertices;
+    }
+
+    bool encloses(const BoundingSphere& sphere, const std::vector<PointCloudVertex>& vertices)
+    {
+        for (const PointCloudVertex& vertex : vertices)
+        {
+            if (distance(vertex.modelPos, sphere.centre) > sphere.radius)
+                return false;
+        }
+        return true;
+    }
+
+    bool sameBox(const BoundingBox& a, const BoundingBox& b)
+    {
+        return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z && a.max.x == b.max.x && a.max.y == b.max.y
+            && a.max.z == b.max.z;
+    }
+
+    //Blocks summed in another order only round differently
+    bool sameResult(const BoundsAccumulator& merged, const BoundsAccumulator& serial)
+    {
+        bool sums = true;
+        for (int axis = 0; axis < 3; ++axis)
+            sums = sums && std::fabs(merged.sum[axis] - serial.sum[axis]) <= 1e-12 * std::max(1.0, std::fabs(serial.sum[axis]));
+        PointCloudBounds a = merged.result(), b = serial.result();
+        return sums && merged.count == serial.count && sameBox(a.box, b.box)
+            && std::fabs(a.centroid.x - b.centroid.x) <= 1e-5f * std::max(1.0f, std::fabs(b.centroid.x))
+            && std::fabs(a.centroid.y - b.centroid.y) <= 1e-5f * std::max(1.0f, std::fabs(b.centroid.y))
+            && std::fabs(a.centroid.z - b.centroid.z) <= 1e-5f * std::max(1.0f, std::fabs(b.centroid.z))
+            && a.sphere.radius == b.sphere.radius && !a.minimalSphere;
+    }
+
+    //Loaders reduce one accumulator per block and merge them, which must match adding every vertex to a single one
+    void testAccumulator()
+    {
+        std::mt19937 random(12);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<DirectX::XMFLOAT3> positions(200000);
+        for (auto& position : positions)
+            position = DirectX::XMFLOAT3(1000.0f + unit(random) * 30.0f, unit(random) * 5.0f, -200.0f + unit(random));
+        std::vector<PointCloudVertex> vertices = fromPositions(positions);
+
+        BoundsAccumulator serial;
+        for (const PointCloudVertex& vertex : vertices)
+            serial.add(vertex);
+
+        //Even blocks, and blocks of random length with empty ones among them
+        for (std::size_t blockSize : { std::size_t(1), std::size_t(7), std::size_t(4096), std::size_t(65536), vertices.size() })
+        {
+            BoundsAccumulator merged;
+            for (std::size_t begin = 0; begin < vertices.size(); begin += blockSize)
+            {
+                BoundsAccumulator block;
+                for (std::size_t i = begin; i < std::min(begin + blockSize, vertices.size()); ++i)
+                    block.add(vertices[i]);
+                merged.merge(block);
+            }
+            CHECK(sameResult(merged, serial));
+        }
+        std::uniform_int_distribution<std::size_t> blockLength(0, 3000);
+        BoundsAccumulator merged;
+        for (std::size_t begin = 0; begin < vertices.size();)
+        {
+            std::size_t end = std::min(begin + blockLength(random), vertices.size());
+            BoundsAccumulator block;
+            for (std::size_t i = begin; i < end; ++i)
+                block.add(vertices[i]);
+            merged.merge(block);
+            merged.merge(BoundsAccumulator());
+            begin = end;
+        }
+        CHECK(sameResult(merged, serial));
+
+        //The parallel reduction, and a block merged into an empty accumulator, are the same too
+        PointCloudBounds parallel = calculateBounds(vertices.data(), vertices.size());
+        CHECK(sameBox(parallel.box, serial.result().box) && parallel.sphere.radius == serial.result().sphere.radius);
+        BoundsAccumulator fromEmpty;
+        fromEmpty.merge(serial);
+        CHECK(sameResult(fromEmpty, serial));
+
+        //Nothing added: zero sized at the origin, whether empty blocks were merged or not
+        BoundsAccumulator empty;
+        empty.merge(BoundsAccumulator());
+        for (const BoundsAccumulator& nothing : { BoundsAccumulator(), empty })
+        {
+            PointCloudBounds bounds = nothing.result();
+            CHECK(nothing.count == 0 && sameBox(bounds.box, {}) && bounds.centroid.x == 0.0f && bounds.centroid.y == 0.0f
+                && bounds.centroid.z == 0.0f && bounds.sphere.radius == 0.0f);
+        }
+        PointCloudBounds none = calculateBounds(nullptr, 0);
+        CHECK(sameBox(none.box, {}) && none.sphere.radius == 0.0f);
+    }
+
+    //Only the box's circumsphere is reduced up front, the minimum enclosing sphere is fitted on first use and kept
+    void testTightBounds()
+    {
+        std::mt19937 random(15);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<DirectX::XMFLOAT3> positions(20000);
+        for (auto& position : positions)
+            position = DirectX::XMFLOAT3(unit(random) * 10.0f, unit(random) * 10.0f, unit(random) * 10.0f);
+        std::vector<PointCloudVertex> vertices = fromPositions(positions);
+
+        PointCloud pointCloud{ std::vector<PointCloudVertex>(vertices) };
+        pointCloud.bounds = calculateBounds(pointCloud.data(), pointCloud.size());
+        BoundingSphere circumsphere = pointCloud.bounds->sphere;
+        const PointCloudBounds& bounds = pointCloud.tightBounds();
+        BoundingSphere expected = calculateMinimumEnclosingSphere(vertices.data(), vertices.size());
+        CHECK(bounds.minimalSphere && bounds.sphere.radius == expected.radius && bounds.sphere.radius < circumsphere.radius);
+        CHECK(sameBox(bounds.box, calculateBounds(vertices.data(), vertices.size()).box));
+        CHECK(encloses(bounds.sphere, vertices));
+
+        //A stored sphere isn't fitted again
+        pointCloud.bounds->sphere.radius = 123.0f;
+        CHECK(pointCloud.tightBounds().sphere.radius == 123.0f);
+
+        //Without any bounds yet they are reduced first
+        PointCloud unbounded{ std::vector<PointCloudVertex>(vertices) };
+        CHECK(unbounded.tightBounds().minimalSphere && unbounded.bounds->sphere.radius == expected.radius
+            && sameBox(unbounded.bounds->box, bounds.box));
+        PointCloud empty{ std::vector<PointCloudVertex>() };
+        CHECK(empty.tightBounds().minimalSphere && empty.bounds->sphere.radius == 0.0f);
+    }
+
+    void testMinimumEnclosingSphere()
+    {
+        std::mt19937 random(13);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        //Random clouds of several shapes and sizes, far from the origin too
+        for (std::size_t nPoints : { 1, 2, 3, 10, 1000, 300000 })
+        {
+            std::vector<DirectX::XMFLOAT3> positions(nPoints);
+            for (auto& position : positions)
+                position = DirectX::XMFLOAT3(1000.0f + unit(random) * 30.0f, unit(random) * 5.0f, -200.0f + unit(random));
+            std::vector<PointCloudVertex> vertices = fromPositions(positions);
+            CHECK(encloses(calculateMinimumEnclosingSphere(vertices.data(), vertices.size()), vertices));
+        }
+
+        //Points on a sphere, and a cube's inside: the answer is known
+        std::vector<DirectX::XMFLOAT3> onSphere;
+        for (int i = 0; i < 50000; ++i)
+        {
+            DirectX::XMFLOAT3 direction(unit(random), unit(random), unit(random));
+            double length = distance(direction, DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+            if (length < 1e-3)
+                continue;
+            onSphere.emplace_back(static_cast<float>(3.0 + 2.0 * direction.x / length), static_cast<float>(-1.0 + 2.0 * direction.y / length),
+                static_cast<float>(7.0 + 2.0 * direction.z / length));
+        }
+        std::vector<PointCloudVertex> sphereVertices = fromPositions(onSphere);
+        BoundingSphere sphere = calculateMinimumEnclosingSphere(sphereVertices.data(), sphereVertices.size());
+        CHECK(encloses(sphere, sphereVertices));
+        CHECK(std::fabs(sphere.radius - 2.0f) < 1e-3f && distance(sphere.centre, DirectX::XMFLOAT3(3.0f, -1.0f, 7.0f)) < 1e-3);
+
+        std::vector<PointCloudVertex> pair = fromPositions({ { 0.0f, 0.0f, 0.0f }, { 4.0f, 0.0f, 3.0f } });
+        BoundingSphere pairSphere = calculateMinimumEnclosingSphere(pair.data(), pair.size());
+        CHECK(encloses(pairSphere, pair) && std::fabs(pairSphere.radius - 2.5f) < 1e-5f);
+
+        //Degenerate input: one repeated point, and collinear points
+        std::vector<PointCloudVertex> repeated = fromPositions(std::vector<DirectX::XMFLOAT3>(1000, { 5.0f, 5.0f, 5.0f }));
+        BoundingSphere repeatedSphere = calculateMinimumEnclosingSphere(repeated.data(), repeated.size());
+        CHECK(encloses(repeatedSphere, repeated) && repeatedSphere.radius < 1e-5f);
+        std::vector<DirectX::XMFLOAT3> line;
+        for (int i = 0; i <= 1000; ++i)
+            line.emplace_back(i * 0.01f, i * 0.02f, 0.0f);
+        std::vector<PointCloudVertex> lineVertices = fromPositions(line);
+        BoundingSphere lineSphere = calculateMinimumEnclosingSphere(lineVertices.data(), lineVertices.size());
+        CHECK(encloses(lineSphere, lineVertices) && std::fabs(lineSphere.radius - std::sqrt(500.0f) / 2.0f) < 1e-4f);
+    }
+
+    void testBoxes()
+    {
+        std::mt19937 random(14);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        //An elongated box rotated 30 degrees about z
+        const float angle = 0.5235988f;
+        DirectX::XMFLOAT3 longAxis(std::cos(angle), std::sin(angle), 0.0f);
+        std::vector<DirectX::XMFLOAT3> positions(100000);
+        for (auto& position : positions)
+        {
+            float along = unit(random) * 10.0f, across = unit(random), up = unit(random) * 0.2f;
+            position = DirectX::XMFLOAT3(5.0f + along * longAxis.x - across * longAxis.y, along * longAxis.y + across * longAxis.x, up);
+        }
+        std::vector<PointCloudVertex> vertices = fromPositions(positions);
+
+        PointCloudBounds bounds = calculateBounds(vertices.data(), vertices.size());
+        DirectX::XMFLOAT3 expectedMin = positions[0], expectedMax = positions[0];
+        for (const auto& position : positions)
+        {
+            expectedMin = DirectX::XMFLOAT3(std::min(expectedMin.x, position.x), std::min(expectedMin.y, position.y), std::min(expectedMin.z, position.z));
+            expectedMax = DirectX::XMFLOAT3(std::max(expectedMax.x, position.x), std::max(expectedMax.y, position.y), std::max(expectedMax.z, position.z));
+        }
+        CHECK(bounds.box.min.x == expectedMin.x && bounds.box.min.y == expectedMin.y && bounds.box.min.z == expectedMin.z);
+        CHECK(bounds.box.max.x == expectedMax.x && bounds.box.max.y == expectedMax.y && bounds.box.max.z == expectedMax.z);
+        CHECK(encloses(bounds.sphere, vertices));
+
+        OrientedBoundingBox box = calculateOrientedBoundingBox(vertices.data(), vertices.size(), bounds.centroid);
+        bool orthonormal = true;
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+                orthonormal = orthonormal && std::fabs(dot(box.axes[i], box.axes[j]) - (i == j ? 1.0 : 0.0)) < 1e-4;
+        }
+        CHECK(orthonormal);
+        CHECK(std::fabs(dot(box.axes[0], longAxis)) > 0.999);
+        bool inside = true;
+        const float halfExtents[3] = { box.halfExtents.x, box.halfExtents.y, box.halfExtents.z };
+        for (const auto& position : positions)
+        {
+            DirectX::XMFLOAT3 offset(position.x - box.centre.x, position.y - box.centre.y, position.z - box.centre.z);
+            for (int axis = 0; axis < 3; ++axis)
+                inside = inside && std::fabs(dot(offset, box.axes[axis])) <= halfExtents[axis] + 1e-4;
+        }
+        CHECK(inside);
+        CHECK(box.halfExtents.x < 10.01f && box.halfExtents.y < 1.01f && box.halfExtents.z < 0.21f);
+    }
+}
+
+int main()
+{
+    testAccumulator();
+    testTightBounds();
+    testMinimumEnclosingSphere();
+    testBoxes();
+    return testResult();
+}
@@ -0,0 +1,28 @@
+#pragma once
+//C++
+#include <cstdio>
+
+//Minimal checking for the test executables: a failed check prints where it is and is counted, and main returns
+//testResult() so CTest sees the failure.
+inline int& failedChecks()
+{
+	static int nFailed = 0;
+	return nFailed;
+}
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			++failedChecks(); \
+		} \
+	} while (false)
+
+inline int testResult()
+{
+	if (failedChecks() != 0)
+		std::fprintf(stderr, "%d checks failed\n", failedChecks());
+	return failedChecks() == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#include "Check.h"
+#include "FrustumCulling.h"
+#include "Octree.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    XMMATRIX testMVP()
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(-20.0f, 30.0f, -40.0f, 1.0f), XMVectorSet(50.0f, 20.0f, 10.0f, 1.0f),
+            XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XMConvertToRadians(50.0f), 16.0f / 9.0f, 1.0f, 120.0f));
+    }
+
+    //Distance of a model space point to a plane, in double so it can tell which points are too close to call
+    double planeDistance(const XMFLOAT4& plane, double x, double y, double z)
+    {
+        return plane.x * x + plane.y * y + plane.z * z + plane.w;
+    }
+
+    //-1 outside, 1 inside and 0 within margin of the clip volume's boundary
+    int clipSide(FXMMATRIX MVP, const XMFLOAT3& point, float margin)
+    {
+        XMVECTOR clip = XMVector4Transform(XMVectorSet(point.x, point.y, point.z, 1.0f), MVP);
+        float x = XMVectorGetX(clip), y = XMVectorGetY(clip), z = XMVectorGetZ(clip), w = XMVectorGetW(clip);
+        float distances[] = { w + x, w - x, w + y, w - y, z, w - z };
+        float nearest = *std::min_element(std::begin(distances), std::end(distances));
+        return nearest > margin ? 1 : nearest < -margin ? -1 : 0;
+    }
+
+    //Points well inside the clip volume are inside every plane and points well outside are outside one
+    void testExtractFrustum()
+    {
+        XMMATRIX MVP = testMVP();
+        Frustum frustum = extractFrustum(MVP);
+        std::mt19937 random(18);
+        std::uniform_real_distribution<float> coordinate(-150.0f, 150.0f);
+        bool matches = true;
+        int nInside = 0;
+        for (int i = 0; i < 100000; ++i)
+        {
+            XMFLOAT3 point(coordinate(random), coordinate(random), coordinate(random));
+            int side = clipSide(MVP, point, 1e-3f);
+            if (side == 0)
+                continue;
+            bool insideAll = true;
+            for (const XMFLOAT4& plane : frustum.planes)
+                insideAll = insideAll && planeDistance(plane, point.x, point.y, point.z) >= 0.0;
+            matches = matches && insideAll == (side > 0);
+            nInside += side > 0;
+        }
+        CHECK(matches);
+        CHECK(nInside > 0);
+    }
+
+    //Tests every corner against every plane in parentMask, or returns false if one is too close to a plane to call
+    bool bruteForceMask(const Frustum& frustum, const BoundingBox& box, std::uint8_t parentMask, std::uint8_t& mask)
+    {
+        mask = 0;
+        bool outside = false;
+        for (int plane = 0; plane < nFrustumPlanes; ++plane)
+        {
+            if ((parentMask & (1 << plane)) == 0)
+                continue;
+            int nBehind = 0;
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                double distance = planeDistance(frustum.planes[plane], corner & 1 ? box.max.x : box.min.x,
+                    corner & 2 ? box.max.y : box.min.y, corner & 4 ? box.max.z : box.min.z);
+                if (std::fabs(distance) < 1e-3)
+                    return false;
+                nBehind += distance < 0.0;
+            }
+            outside = outside || nBehind == 8;
+            if (nBehind != 0)
+                mask |= 1 << plane;
+        }
+        if (outside)
+            mask = outsideFrustum;
+        return true;
+    }
+
+    //Odd box counts cover the partial quads and groups, and every starting plane the early exits
+    void testClassifyBoxes()
+    {
+        Frustum frustum = extractFrustum(testMVP());
+        std::mt19937 random(180);
+        std::uniform_real_distribution<float> coordinate(-100.0f, 150.0f), size(0.1f, 40.0f);
+        bool matches = true;
+        for (int round = 0; round < 2000; ++round)
+        {
+            std::size_t nBoxes = 1 + round % 19;
+            std::vector<BoundingBox> boxes(nBoxes);
+            for (BoundingBox& box : boxes)
+            {
+                box.min = XMFLOAT3(coordinate(random), coordinate(random), coordinate(random));
+                box.max = XMFLOAT3(box.min.x + size(random), box.min.y + size(random), box.min.z + size(random));
+            }
+            std::uint8_t parentMask = round % 3 ? allFrustumPlanes : static_cast<std::uint8_t>(random() & allFrustumPlanes);
+            int firstPlane = round % nFrustumPlanes;
+            std::vector<std::uint8_t> masks(nBoxes);
+            int rejectingPlane = classifyBoxes(frustum, boxes.data(), nBoxes, parentMask, firstPlane, masks.data());
+            matches = matches && rejectingPlane >= 0 && rejectingPlane < nFrustumPlanes;
+            for (std::size_t i = 0; i < nBoxes; ++i)
+            {
+                std::uint8_t expected;
+                if (bruteForceMask(frustum, boxes[i], parentMask, expected))
+                    matches = matches && masks[i] == expected;
+            }
+        }
+        CHECK(matches);
+    }
+
+    //Every point well inside the frustum is in a drawn range, and the ranges are sorted, merged and cull something
+    void testCull()
+    {
+        std::mt19937 random(1800);
+        std::uniform_real_distribution<float> coordinate(-100.0f, 150.0f);
+        std::vector<PointCloudVertex> vertices(300000);
+        for (PointCloudVertex& vertex : vertices)
+        {
+            vertex.modelPos = XMFLOAT3(coordinate(random), coordinate(random), coordinate(random));
+            vertex.colour = XMFLOAT3(1.0f, 1.0f, 1.0f);
+        }
+        BoundingBox box = calculateBounds(vertices.data(), vertices.size()).box;
+        std::unique_ptr<Octree> octree = buildOctree(vertices.data(), vertices.size(), box, 500);
+
+        XMMATRIX MVP = testMVP();
+        Frustum frustum = extractFrustum(MVP);
+        FrustumCuller culler;
+        std::vector<DrawRange> ranges = culler.cull(*octree, frustum);
+        std::vector<bool> drawn(octree->vertices.size());
+        bool ordered = true;
+        std::uint64_t nDrawn = 0;
+        for (std::size_t i = 0; i < ranges.size(); ++i)
+        {
+            ordered = ordered && ranges[i].nVertices != 0 && ranges[i].firstVertex + ranges[i].nVertices <= drawn.size()
+                && (i == 0 || ranges[i - 1].firstVertex + ranges[i - 1].nVertices < ranges[i].firstVertex);
+            for (std::uint64_t vertex = ranges[i].firstVertex; ordered && vertex < ranges[i].firstVertex + ranges[i].nVertices; ++vertex)
+                drawn[vertex] = true;
+            nDrawn += ranges[i].nVertices;
+        }
+        CHECK(ordered);
+
+        bool conservative = true;
+        std::uint64_t nInside = 0;
+        for (std::size_t i = 0; i < octree->vertices.size(); ++i)
+        {
+            bool inside = clipSide(MVP, octree->vertices[i].modelPos, 1e-3f) > 0;
+            conservative = conservative && (!inside || drawn[i]);
+            nInside += inside;
+        }
+        CHECK(conservative);
+        CHECK(nInside > 0 && nDrawn >= nInside && nDrawn < octree->vertices.size());
+
+        //The remembered rejecting planes only change the order planes are tested in, not the result
+        const std::vector<DrawRange>& again = culler.cull(*octree, frustum);
+        bool same = again.size() == ranges.size();
+        for (std::size_t i = 0; same && i < ranges.size(); ++i)
+            same = again[i].firstVertex == ranges[i].firstVertex && again[i].nVertices == ranges[i].nVertices;
+        CHECK(same);
+    }
+}
+
+int main()
+{
+    testExtractFrustum();
+    testClassifyBoxes();
+    testCull();
+    return testResult();
+}
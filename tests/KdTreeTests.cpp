@@ -0,0 +1,166 @@
+#include "Check.h"
+#include "KdTree.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    float squaredDistance(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        float x = a.x - b.x, y = a.y - b.y, z = a.z - b.z;
+        return x * x + y * y + z * z;
+    }
+
+    //A uniform cloud with a dense cluster and exact duplicates, so leaves are uneven and distances tie
+    std::vector<PointCloudVertex> testCloud(std::size_t nVertices, unsigned int seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<PointCloudVertex> vertices(nVertices);
+        for (std::size_t i = 0; i < nVertices; ++i)
+        {
+            float scale = i % 3 ? 10.0f : 0.5f;
+            vertices[i].modelPos = i % 17 == 16 ? vertices[i - 1].modelPos
+                : XMFLOAT3(unit(random) * scale, unit(random) * scale, unit(random) * scale * 0.2f);
+            vertices[i].colour = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        }
+        return vertices;
+    }
+
+    //Squared distances must match a sorted brute force scan, and the indices must be of points at those distances
+    bool matchesBruteForceNearest(const std::vector<PointCloudVertex>& vertices, const XMFLOAT3& query,
+        unsigned int k, const std::uint32_t* indices, const float* squaredDistances)
+    {
+        std::vector<float> expected(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+            expected[i] = squaredDistance(query, vertices[i].modelPos);
+        std::sort(expected.begin(), expected.end());
+        std::vector<std::uint32_t> seen;
+        for (unsigned int j = 0; j < k; ++j)
+        {
+            if (j >= vertices.size())
+            {
+                if (indices[j] != kdNoNeighbour)
+                    return false;
+                continue;
+            }
+            if (indices[j] >= vertices.size() || squaredDistances[j] != expected[j]
+                || squaredDistance(query, vertices[indices[j]].modelPos) != squaredDistances[j])
+                return false;
+            seen.push_back(indices[j]);
+        }
+        std::sort(seen.begin(), seen.end());
+        return std::adjacent_find(seen.begin(), seen.end()) == seen.end();
+    }
+
+    void testNearest()
+    {
+        for (std::size_t nVertices : { 1, 5, 100, 20000 })
+        {
+            std::vector<PointCloudVertex> vertices = testCloud(nVertices, 20);
+            std::unique_ptr<KdTree> tree = buildKdTree(vertices.data(), vertices.size(), 8);
+            CHECK(tree && tree->size() == nVertices);
+            if (!tree)
+                continue;
+
+            std::mt19937 random(200);
+            std::uniform_real_distribution<float> coordinate(-2.0f, 12.0f);
+            constexpr unsigned int k = 12;
+            std::vector<XMFLOAT3> queries;
+            for (int i = 0; i < 300; ++i)
+            {
+                //Half the queries are the tree's own points, which must come first
+                queries.push_back(i % 2 ? vertices[random() % nVertices].modelPos
+                    : XMFLOAT3(coordinate(random), coordinate(random), coordinate(random)));
+            }
+            bool matches = true, selfFirst = true;
+            std::vector<std::uint32_t> indices(queries.size() * k);
+            std::vector<float> squaredDistances(queries.size() * k);
+            for (std::size_t i = 0; i < queries.size(); ++i)
+            {
+                tree->nearest(queries[i], k, &indices[i * k], &squaredDistances[i * k]);
+                matches = matches && matchesBruteForceNearest(vertices, queries[i], k, &indices[i * k], &squaredDistances[i * k]);
+                selfFirst = selfFirst && (i % 2 == 0 || squaredDistances[i * k] == 0.0f);
+            }
+            CHECK(matches);
+            CHECK(selfFirst);
+
+            //The batched form gives the same rows
+            std::vector<std::uint32_t> batchIndices(queries.size() * k);
+            std::vector<float> batchDistances(queries.size() * k);
+            tree->nearest(queries.data(), queries.size(), k, batchIndices.data(), batchDistances.data());
+            CHECK(batchIndices == indices && batchDistances == squaredDistances);
+        }
+    }
+
+    void testWithinRadius()
+    {
+        std::vector<PointCloudVertex> vertices = testCloud(30000, 21);
+        std::unique_ptr<KdTree> tree = buildKdTree(vertices.data(), vertices.size());
+        std::mt19937 random(210);
+        std::uniform_real_distribution<float> coordinate(-1.0f, 11.0f);
+        std::vector<XMFLOAT3> queries(200);
+        for (XMFLOAT3& query : queries)
+            query = XMFLOAT3(coordinate(random), coordinate(random), coordinate(random) * 0.2f);
+        constexpr float radius = 0.6f;
+
+        bool matches = true;
+        std::vector<std::vector<std::uint32_t>> found(queries.size());
+        for (std::size_t i = 0; i < queries.size(); ++i)
+        {
+            tree->withinRadius(queries[i], radius, found[i]);
+            std::sort(found[i].begin(), found[i].end());
+            //Points too close to the sphere to call either way may or may not be found
+            std::vector<std::uint32_t> certain, possible;
+            for (std::uint32_t j = 0; j < vertices.size(); ++j)
+            {
+                float distance = std::sqrt(squaredDistance(queries[i], vertices[j].modelPos));
+                if (distance < radius * (1.0f - 1e-5f))
+                    certain.push_back(j);
+                if (distance <= radius * (1.0f + 1e-5f))
+                    possible.push_back(j);
+            }
+            matches = matches && std::adjacent_find(found[i].begin(), found[i].end()) == found[i].end()
+                && std::includes(found[i].begin(), found[i].end(), certain.begin(), certain.end())
+                && std::includes(possible.begin(), possible.end(), found[i].begin(), found[i].end());
+        }
+        CHECK(matches);
+
+        RadiusNeighbours batch = tree->withinRadius(queries.data(), queries.size(), radius);
+        bool sameAsSingle = batch.offsets.size() == queries.size() + 1 && batch.offsets.back() == batch.indices.size();
+        for (std::size_t i = 0; sameAsSingle && i < queries.size(); ++i)
+        {
+            std::vector<std::uint32_t> row(batch.indices.begin() + batch.offsets[i], batch.indices.begin() + batch.offsets[i + 1]);
+            std::sort(row.begin(), row.end());
+            sameAsSingle = row == found[i];
+        }
+        CHECK(sameAsSingle);
+    }
+
+    //Every vertex appears once in tree order
+    void testTreeOrder()
+    {
+        std::vector<PointCloudVertex> vertices = testCloud(10007, 22);
+        std::unique_ptr<KdTree> tree = buildKdTree(vertices.data(), vertices.size());
+        std::vector<std::uint32_t> order = tree->treeOrder();
+        order.resize(std::min(order.size(), vertices.size()));
+        std::sort(order.begin(), order.end());
+        bool permutation = order.size() == vertices.size();
+        for (std::size_t i = 0; permutation && i < order.size(); ++i)
+            permutation = order[i] == i;
+        CHECK(permutation);
+    }
+}
+
+int main()
+{
+    testNearest();
+    testWithinRadius();
+    testTreeOrder();
+    return testResult();
+}
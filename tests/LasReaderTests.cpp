@@ -0,0 +1,290 @@
+#include "Check.h"
+#include "LasReader.h"
+//C++
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    //A point as a LAS writer holds it before quantizing: georeferenced coordinates in metres and 16-bit colour
+    struct SourcePoint
+    {
+        double position[3];
+        std::uint16_t rgb[3];
+    };
+
+    struct LasFile
+    {
+        std::uint8_t versionMinor = 2;
+        std::uint8_t format = 0;
+        std::uint16_t extraBytes = 0; //Appended to every record beyond the format's own fields
+        double scale[3] = { 0.001, 0.001, 0.001 };
+        double offset[3] = { 500000.0, 4100000.0, 0.0 };
+        bool finiteMinimum = true;
+        bool legacyCount = true; //LAS 1.4 writers may leave the 32-bit count 0
+    };
+
+    std::size_t recordLength(std::uint8_t format)
+    {
+        const std::size_t lengths[] = { 20, 28, 26, 34, 0, 0, 30, 36, 38 };
+        return lengths[format];
+    }
+
+    std::size_t rgbOffset(std::uint8_t format)
+    {
+        const std::size_t offsets[] = { 0, 0, 20, 28, 0, 0, 0, 30, 30 };
+        return offsets[format];
+    }
+
+    template<typename T>
+    void put(std::string& data, std::size_t offset, T value)
+    {
+        std::memcpy(&data[offset], &value, sizeof(T));
+    }
+
+    std::int32_t quantize(const LasFile& las, const SourcePoint& point, int axis)
+    {
+        return static_cast<std::int32_t>(std::lround((point.position[axis] - las.offset[axis]) / las.scale[axis]));
+    }
+
+    //Header, a variable length record's worth of padding, then the point records
+    std::string makeLas(const LasFile& las, const std::vector<SourcePoint>& points)
+    {
+        std::size_t headerSize = las.versionMinor >= 4 ? 375 : 227;
+        std::size_t pointDataOffset = headerSize + 54;
+        std::size_t length = recordLength(las.format) + las.extraBytes;
+        std::string data(pointDataOffset + points.size() * length, '\0');
+        std::memcpy(&data[0], "LASF", 4);
+        put<std::uint8_t>(data, 24, 1);
+        put<std::uint8_t>(data, 25, las.versionMinor);
+        put<std::uint16_t>(data, 94, static_cast<std::uint16_t>(headerSize));
+        put<std::uint32_t>(data, 96, static_cast<std::uint32_t>(pointDataOffset));
+        put<std::uint8_t>(data, 104, las.format);
+        put<std::uint16_t>(data, 105, static_cast<std::uint16_t>(length));
+        put<std::uint32_t>(data, 107, las.legacyCount ? static_cast<std::uint32_t>(points.size()) : 0);
+        if (las.versionMinor >= 4)
+            put<std::uint64_t>(data, 247, points.size());
+
+        double min[3] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+        double max[3] = { -min[0], -min[1], -min[2] };
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            char* record = &data[pointDataOffset + i * length];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                std::int32_t stored = quantize(las, points[i], axis);
+                std::memcpy(record + axis * 4, &stored, 4);
+                double coordinate = stored * las.scale[axis] + las.offset[axis];
+                min[axis] = std::min(min[axis], coordinate);
+                max[axis] = std::max(max[axis], coordinate);
+            }
+            if (rgbOffset(las.format) != 0)
+                std::memcpy(record + rgbOffset(las.format), points[i].rgb, sizeof(points[i].rgb));
+            std::memset(record + recordLength(las.format), 0x5A, las.extraBytes);
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            put<double>(data, 131 + axis * 8, las.scale[axis]);
+            put<double>(data, 155 + axis * 8, las.offset[axis]);
+            put<double>(data, 179 + axis * 16, max[axis]);
+            put<double>(data, 187 + axis * 16, las.finiteMinimum ? min[axis] : std::numeric_limits<double>::quiet_NaN());
+        }
+        return data;
+    }
+
+    std::filesystem::path writeFile(const std::string& data)
+    {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "pcv_las_test.las";
+        std::ofstream(path, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+        return path;
+    }
+
+    std::unique_ptr<PointCloud> readLas(const std::string& data)
+    {
+        std::filesystem::path path = writeFile(data);
+        std::unique_ptr<PointCloud> pointCloud = readPointCloudLAS(path);
+        std::filesystem::remove(path);
+        return pointCloud;
+    }
+
+    //Survey points a few hundred metres across, far from the projection's origin. 8-bit colour only uses the low
+    //byte of the fields.
+    std::vector<SourcePoint> surveyPoints(std::size_t nPoints, bool eightBitColour)
+    {
+        std::mt19937 random(8);
+        std::uniform_real_distribution<double> across(0.0, 300.0);
+        std::uniform_int_distribution<int> channel(0, eightBitColour ? 255 : 65535);
+        std::vector<SourcePoint> points(nPoints);
+        for (SourcePoint& point : points)
+        {
+            point.position[0] = 512345.0 + across(random);
+            point.position[1] = 4123456.0 + across(random);
+            point.position[2] = 80.0 + across(random) * 0.1;
+            for (std::uint16_t& component : point.rgb)
+                component = static_cast<std::uint16_t>(channel(random));
+        }
+        points[0].rgb[0] = eightBitColour ? 255 : 65535;
+        return points;
+    }
+
+    //Every position is the stored integer scaled and offset in double and then made relative to origin, so adding
+    //the origin back recovers the quantized coordinate to well under a millimetre. Colours are white without RGB,
+    //16-bit channels over 65535 and 8-bit ones over 255.
+    bool matchesPoints(const PointCloud& pointCloud, const LasFile& las, const std::vector<SourcePoint>& points, bool eightBitColour)
+    {
+        if (pointCloud.size() != points.size())
+            return false;
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            const PointCloudVertex& vertex = pointCloud.data()[i];
+            const float position[3] = { vertex.modelPos.x, vertex.modelPos.y, vertex.modelPos.z };
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                std::int32_t stored = quantize(las, points[i], axis);
+                float expected = static_cast<float>(stored * las.scale[axis] + (las.offset[axis] - pointCloud.origin[axis]));
+                double absolute = static_cast<double>(position[axis]) + pointCloud.origin[axis];
+                if (position[axis] != expected || std::fabs(absolute - (stored * las.scale[axis] + las.offset[axis])) > 1e-4)
+                    return false;
+            }
+            const float colour[3] = { vertex.colour.x, vertex.colour.y, vertex.colour.z };
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                float expected = rgbOffset(las.format) == 0 ? 1.0f
+                    : eightBitColour ? points[i].rgb[channel] / 65535.0f * 257.0f : points[i].rgb[channel] / 65535.0f;
+                if (colour[channel] != expected)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool matchesBounds(const PointCloud& pointCloud)
+    {
+        BoundingBox expected = calculateBounds(pointCloud.data(), pointCloud.size()).box;
+        return pointCloud.bounds && std::memcmp(&pointCloud.bounds->box, &expected, sizeof(BoundingBox)) == 0;
+    }
+
+    //Every supported point format, over enough points that decoding is split between tasks
+    void testPointFormats()
+    {
+        for (bool eightBitColour : { false, true })
+        {
+            std::vector<SourcePoint> points = surveyPoints(150000, eightBitColour);
+            for (std::uint8_t format : { 0, 1, 2, 3, 6, 7, 8 })
+            {
+                LasFile las;
+                las.format = format;
+                las.versionMinor = format >= 6 ? 4 : 2;
+                std::unique_ptr<PointCloud> pointCloud = readLas(makeLas(las, points));
+                CHECK(pointCloud && matchesPoints(*pointCloud, las, points, eightBitColour) && matchesBounds(*pointCloud));
+            }
+        }
+    }
+
+    void testScaleAndOrigin()
+    {
+        std::vector<SourcePoint> points = surveyPoints(1000, false);
+        LasFile las;
+        las.format = 3;
+        las.extraBytes = 7;
+        las.scale[0] = 0.01;
+        las.scale[1] = 0.0001;
+        las.scale[2] = 0.25;
+        las.offset[0] = -1000.5;
+        las.offset[1] = 4000000.0;
+        las.offset[2] = 50.0;
+        std::string data = makeLas(las, points);
+        std::unique_ptr<PointCloud> pointCloud = readLas(data);
+        CHECK(pointCloud && matchesPoints(*pointCloud, las, points, false));
+
+        //The origin is the header's minimum corner, so the cloud starts at zero
+        LasHeader header;
+        CHECK(parseLasHeader(data, header) && header.nPoints == points.size());
+        CHECK(pointCloud && pointCloud->origin[0] == header.min[0] && pointCloud->origin[1] == header.min[1]
+            && pointCloud->origin[2] == header.min[2]);
+        CHECK(pointCloud && pointCloud->bounds && std::fabs(pointCloud->bounds->box.min.x) < 1e-6f
+            && std::fabs(pointCloud->bounds->box.min.y) < 1e-6f && std::fabs(pointCloud->bounds->box.min.z) < 1e-6f);
+
+        //Regression: positions used to be narrowed to float as absolute coordinates, so at 4 million metres
+        //they were only kept to a quarter of a metre
+        bool centimetreSteps = true;
+        for (std::size_t i = 0; pointCloud && i + 1 < pointCloud->size(); ++i)
+        {
+            double step = std::fabs(static_cast<double>(pointCloud->data()[i].modelPos.y) - pointCloud->data()[i + 1].modelPos.y);
+            double sourceStep = std::fabs(points[i].position[1] - points[i + 1].position[1]);
+            centimetreSteps = centimetreSteps && std::fabs(step - sourceStep) < 0.01;
+        }
+        CHECK(centimetreSteps);
+
+        //Without a finite minimum the offset, which writers put near the data, is the origin
+        las.finiteMinimum = false;
+        las.offset[0] = 512000.0;
+        las.offset[1] = 4123000.0;
+        pointCloud = readLas(makeLas(las, points));
+        CHECK(pointCloud && matchesPoints(*pointCloud, las, points, false) && pointCloud->origin[0] == las.offset[0]
+            && pointCloud->origin[1] == las.offset[1] && pointCloud->origin[2] == las.offset[2]);
+    }
+
+    void testLas14Count()
+    {
+        std::vector<SourcePoint> points = surveyPoints(100, false);
+        LasFile las;
+        las.format = 7;
+        las.versionMinor = 4;
+        las.legacyCount = false;
+        std::string data = makeLas(las, points);
+        LasHeader header;
+        CHECK(parseLasHeader(data, header) && header.versionMinor == 4 && header.nPoints == points.size());
+        std::unique_ptr<PointCloud> pointCloud = readLas(data);
+        CHECK(pointCloud && matchesPoints(*pointCloud, las, points, false));
+    }
+
+    void testRejected()
+    {
+        std::vector<SourcePoint> points = surveyPoints(100, false);
+        LasFile las;
+        las.format = 2;
+        std::string valid = makeLas(las, points);
+
+        std::string data = valid;
+        data[0] = 'X';
+        CHECK(!readLas(data));
+
+        //LASzip compressed
+        data = valid;
+        put<std::uint8_t>(data, 104, 0x82);
+        CHECK(!readLas(data));
+
+        //Formats with waveform packets aren't supported
+        data = valid;
+        put<std::uint8_t>(data, 104, 4);
+        CHECK(!readLas(data));
+
+        //Records shorter than the format's fields
+        data = valid;
+        put<std::uint16_t>(data, 105, 20);
+        CHECK(!readLas(data));
+
+        //Fewer records than the header declares
+        data = valid.substr(0, valid.size() - 13);
+        CHECK(!readLas(data));
+
+        CHECK(!readLas(valid.substr(0, 100)));
+        CHECK(!readPointCloudLAS(std::filesystem::temp_directory_path() / "pcv_missing_file.las"));
+    }
+}
+
+int main()
+{
+    testPointFormats();
+    testScaleAndOrigin();
+    testLas14Count();
+    testRejected();
+    return testResult();
+}
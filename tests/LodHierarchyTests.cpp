@@ -0,0 +1,208 @@
+#include "Check.h"
+#include "LodHierarchy.h"
+#include "SpaceFillingCurve.h"
+//C++
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    //Dense clusters in a sparse background, with some points repeated, so cells fill very unevenly. Each point's index
+    //is kept in its red channel to identify it after grouping.
+    std::vector<PointCloudVertex> testVertices(std::size_t nVertices)
+    {
+        std::mt19937 random(16);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::normal_distribution<float> gaussian;
+        std::vector<PointCloudVertex> vertices(nVertices);
+        for (std::size_t i = 0; i < nVertices; ++i)
+        {
+            XMFLOAT3 position;
+            if (i % 10 == 0 && i > 0)
+                position = vertices[i - 7].modelPos;
+            else if (i % 3 == 0)
+                position = XMFLOAT3(unit(random) * 100.0f, unit(random) * 60.0f, unit(random) * 20.0f);
+            else
+                position = XMFLOAT3(30.0f + gaussian(random), 20.0f + gaussian(random) * 0.1f, 5.0f + gaussian(random) * 2.0f);
+            vertices[i] = PointCloudVertex(position, XMFLOAT3(static_cast<float>(i), unit(random), unit(random)));
+        }
+        return vertices;
+    }
+
+    std::size_t sourceIndex(const PointCloudVertex& vertex)
+    {
+        return static_cast<std::size_t>(vertex.colour.x);
+    }
+
+    //Every input point appears once, unchanged and with its normal, and the nodes' ranges tile the vertices in node order
+    bool isPermutation(const LodHierarchy& hierarchy, const std::vector<PointCloudVertex>& vertices, const std::vector<std::uint32_t>& normals)
+    {
+        if (hierarchy.vertices.size() != vertices.size() || hierarchy.normals.size() != normals.size())
+            return false;
+        std::vector<bool> seen(vertices.size(), false);
+        for (std::size_t i = 0; i < hierarchy.vertices.size(); ++i)
+        {
+            std::size_t source = sourceIndex(hierarchy.vertices[i]);
+            if (source >= vertices.size() || seen[source]
+                || std::memcmp(&hierarchy.vertices[i], &vertices[source], sizeof(PointCloudVertex)) != 0
+                || (!normals.empty() && hierarchy.normals[i] != normals[source]))
+                return false;
+            seen[source] = true;
+        }
+        std::uint64_t next = 0;
+        for (const LodNode& node : hierarchy.nodes)
+        {
+            if (node.firstPoint != next)
+                return false;
+            next += node.nPoints;
+        }
+        return next == vertices.size();
+    }
+
+    std::uint32_t nChildren(const LodNode& node)
+    {
+        std::uint32_t count = 0;
+        for (std::uint8_t mask = node.childMask; mask != 0; mask &= mask - 1)
+            ++count;
+        return count;
+    }
+
+    //Inside the cell of every inner node, each occupied cell of its sampling grid holds exactly one point owned by the
+    //node or one of its ancestors. Cells are found from the points' Morton codes on the hierarchy's cube.
+    bool oneRepresentativePerCell(const LodHierarchy& hierarchy)
+    {
+        const std::vector<LodNode>& nodes = hierarchy.nodes;
+        std::vector<std::uint64_t> codes(hierarchy.vertices.size());
+        computeCurveCodes(hierarchy.vertices.data(), hierarchy.vertices.size(), hierarchy.cube, CurveType::Morton, codes.data());
+        std::vector<std::uint32_t> parents(nodes.size(), 0);
+        std::vector<std::uint32_t> owners(hierarchy.vertices.size());
+        unsigned int maxLevel = 0;
+        for (std::uint32_t i = 0; i < nodes.size(); ++i)
+        {
+            for (std::uint32_t child = 0; child < nChildren(nodes[i]); ++child)
+                parents[nodes[i].firstChild + child] = i;
+            for (std::uint64_t point = nodes[i].firstPoint; point < nodes[i].firstPoint + nodes[i].nPoints; ++point)
+                owners[point] = i;
+            maxLevel = std::max<unsigned int>(maxLevel, nodes[i].level);
+        }
+
+        for (unsigned int level = 0; level <= maxLevel; ++level)
+        {
+            unsigned int nodeShift = 3 * (curveBitsPerAxis - level);
+            unsigned int cellShift = 3 * (curveBitsPerAxis - std::min(level + lodSamplingLevels, curveBitsPerAxis));
+            //The level's inner nodes by the code prefix of their cell, taken from the points their subtrees own
+            std::unordered_map<std::uint64_t, std::uint32_t> innerNodes;
+            for (std::size_t point = 0; point < codes.size(); ++point)
+            {
+                std::uint32_t node = owners[point];
+                if (nodes[node].level < level)
+                    continue;
+                while (nodes[node].level > level)
+                    node = parents[node];
+                auto inserted = innerNodes.emplace(codes[point] >> nodeShift, node);
+                if (inserted.first->second != node)
+                    return false; //Two nodes of one level sharing a cell
+            }
+            //Points owned at this level or above, per sampling cell of the level's inner nodes
+            std::unordered_map<std::uint64_t, std::uint32_t> representatives;
+            for (std::size_t point = 0; point < codes.size(); ++point)
+            {
+                auto node = innerNodes.find(codes[point] >> nodeShift);
+                if (node == innerNodes.end() || nodes[node->second].isLeaf())
+                    continue;
+                std::uint32_t& count = representatives[codes[point] >> cellShift];
+                count += nodes[owners[point]].level <= level;
+            }
+            for (const auto& cell : representatives)
+            {
+                if (cell.second != 1)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool sameHierarchies(const LodHierarchy& a, const LodHierarchy& b)
+    {
+        bool same = a.nodes.size() == b.nodes.size() && a.vertices.size() == b.vertices.size() && a.normals == b.normals
+            && a.coarseColours == b.coarseColours
+            && std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(PointCloudVertex)) == 0;
+        for (std::size_t i = 0; same && i < a.nodes.size(); ++i)
+        {
+            const LodNode& x = a.nodes[i];
+            const LodNode& y = b.nodes[i];
+            same = std::memcmp(&x.bounds, &y.bounds, sizeof(BoundingBox)) == 0 && x.firstPoint == y.firstPoint && x.nPoints == y.nPoints
+                && x.firstChild == y.firstChild && x.childMask == y.childMask && x.level == y.level && x.spacing == y.spacing;
+        }
+        return same;
+    }
+
+    void testInvariants()
+    {
+        std::vector<PointCloudVertex> vertices = testVertices(300000);
+        std::vector<std::uint32_t> normals(vertices.size());
+        for (std::size_t i = 0; i < normals.size(); ++i)
+            normals[i] = static_cast<std::uint32_t>(i * 2654435761u);
+        BoundingBox box = calculateBounds(vertices.data(), vertices.size()).box;
+        for (bool keepInputOrder : { false, true })
+        {
+            std::unique_ptr<LodHierarchy> hierarchy = buildLodHierarchy(vertices.data(), vertices.size(), box, normals.data(), 2000,
+                keepInputOrder);
+            CHECK(hierarchy && hierarchy->nodes.size() > 100);
+            if (!hierarchy)
+                continue;
+            CHECK(isPermutation(*hierarchy, vertices, normals));
+            CHECK(oneRepresentativePerCell(*hierarchy));
+
+            //Every node's points lie in its bounds, and its spacing is the side of its sampling cells
+            float cubeSide = hierarchy->cube.max.x - hierarchy->cube.min.x;
+            bool consistent = true;
+            for (const LodNode& node : hierarchy->nodes)
+            {
+                unsigned int depth = std::min(node.level + lodSamplingLevels, curveBitsPerAxis);
+                consistent = consistent && node.spacing == cubeSide / static_cast<float>(1u << depth);
+                for (std::uint64_t point = node.firstPoint; consistent && point < node.firstPoint + node.nPoints; ++point)
+                {
+                    const XMFLOAT3& position = hierarchy->vertices[point].modelPos;
+                    consistent = position.x >= node.bounds.min.x && position.x <= node.bounds.max.x && position.y >= node.bounds.min.y
+                        && position.y <= node.bounds.max.y && position.z >= node.bounds.min.z && position.z <= node.bounds.max.z;
+                    //Within a node, input order is kept if asked for
+                    consistent = consistent && (!keepInputOrder || point == node.firstPoint
+                        || sourceIndex(hierarchy->vertices[point - 1]) < sourceIndex(hierarchy->vertices[point]));
+                }
+            }
+            CHECK(consistent);
+
+            //The work split doesn't depend on scheduling, so a rebuild is identical
+            std::unique_ptr<LodHierarchy> rebuilt = buildLodHierarchy(vertices.data(), vertices.size(), box, normals.data(), 2000,
+                keepInputOrder);
+            CHECK(rebuilt && sameHierarchies(*hierarchy, *rebuilt));
+        }
+    }
+
+    void testSmallClouds()
+    {
+        std::unique_ptr<LodHierarchy> empty = buildLodHierarchy(nullptr, 0, BoundingBox());
+        CHECK(empty && empty->nodes.empty() && empty->vertices.empty());
+
+        //All points in one place can't be split, one leaf holds them
+        std::vector<PointCloudVertex> same(5000, PointCloudVertex(XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(0.0f, 0.0f, 0.0f)));
+        for (std::size_t i = 0; i < same.size(); ++i)
+            same[i].colour.x = static_cast<float>(i);
+        std::unique_ptr<LodHierarchy> stacked = buildLodHierarchy(same.data(), same.size(), calculateBounds(same.data(), same.size()).box,
+            nullptr, 100);
+        CHECK(stacked && isPermutation(*stacked, same, {}) && oneRepresentativePerCell(*stacked));
+    }
+}
+
+int main()
+{
+    testInvariants();
+    testSmallClouds();
+    return testResult();
+}
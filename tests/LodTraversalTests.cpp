@@ -0,0 +1,193 @@
+#include "Check.h"
+#include "LodTraversal.h"
+//C++
+#include <algorithm>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float fov = 60.0f;
+    constexpr unsigned int rtvHeight = 1000;
+
+    LodView cameraView(const XMFLOAT3& eye, const XMFLOAT3& target)
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(eye.x, eye.y, eye.z, 1.0f), XMVectorSet(target.x, target.y, target.z, 1.0f),
+            XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return { XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XMConvertToRadians(fov), 1.0f, 0.5f, 5000.0f)), fov, rtvHeight };
+    }
+
+    LodNode makeNode(const XMFLOAT3& min, const XMFLOAT3& max, std::uint64_t firstPoint, std::uint64_t nPoints,
+        std::uint32_t firstChild, std::uint8_t childMask, std::uint8_t level, float spacing)
+    {
+        LodNode node;
+        node.bounds.min = min;
+        node.bounds.max = max;
+        node.firstPoint = firstPoint;
+        node.nPoints = nPoints;
+        node.firstChild = firstChild;
+        node.childMask = childMask;
+        node.level = level;
+        node.spacing = spacing;
+        return node;
+    }
+
+    //A root over two children of equal size, a small leaf and a large inner node with one leaf below it:
+    //root [0, 100), small leaf [100, 150), large node [150, 550), its leaf [550, 560)
+    std::vector<LodNode> testNodes()
+    {
+        return {
+            makeNode(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(8.0f, 4.0f, 4.0f), 0, 100, 1, 0x3, 0, 1.0f),
+            makeNode(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(4.0f, 4.0f, 4.0f), 100, 50, 3, 0, 1, 0.5f),
+            makeNode(XMFLOAT3(4.0f, 0.0f, 0.0f), XMFLOAT3(8.0f, 4.0f, 4.0f), 150, 400, 3, 0x1, 1, 0.5f),
+            makeNode(XMFLOAT3(4.0f, 0.0f, 0.0f), XMFLOAT3(6.0f, 2.0f, 2.0f), 550, 10, 4, 0, 2, 0.25f),
+        };
+    }
+
+    bool isSelected(const LodTraversal& traversal, std::uint32_t node)
+    {
+        const std::vector<std::uint32_t>& selected = traversal.selectedNodes();
+        return std::find(selected.begin(), selected.end(), node) != selected.end();
+    }
+
+    bool isCoarse(const LodTraversal& traversal, std::uint32_t node)
+    {
+        const std::vector<std::uint32_t>& selected = traversal.selectedNodes();
+        std::size_t selection = std::find(selected.begin(), selected.end(), node) - selected.begin();
+        return selection < selected.size() && traversal.selectedRanges()[selection].coarse;
+    }
+
+    bool isSingleRange(const std::vector<DrawRange>& ranges, std::uint64_t firstVertex, std::uint64_t nVertices)
+    {
+        return ranges.size() == 1 && ranges[0].firstVertex == firstVertex && ranges[0].nVertices == nVertices;
+    }
+
+    //Every node's sampling cells project to tens of pixels from here, so only the budget limits the cut
+    LodView nearView()
+    {
+        return cameraView(XMFLOAT3(4.0f, 2.0f, -20.0f), XMFLOAT3(4.0f, 2.0f, 2.0f));
+    }
+
+    void testBudget()
+    {
+        std::vector<LodNode> nodes = testNodes();
+        LodTraversal traversal;
+
+        //Regression: a budget below the root's points used to select nothing
+        const std::vector<DrawRange>* ranges = &traversal.select(nodes, nearView(), 10);
+        CHECK(traversal.selectedNodes() == std::vector<std::uint32_t>({ 0 }) && traversal.selectedPoints() == 100);
+        CHECK(isSingleRange(*ranges, 0, 100));
+
+        //The large child doesn't fit and is skipped with its subtree, the small one still does. The children are
+        //the same size on screen, so stopping at the first that didn't fit depended on the queue's order.
+        ranges = &traversal.select(nodes, nearView(), 200);
+        CHECK(traversal.selectedPoints() == 150 && traversal.selectedNodes().size() == 2 && isSelected(traversal, 1));
+        CHECK(isSingleRange(*ranges, 0, 150));
+
+        //A budget filled exactly stops before the last leaf
+        ranges = &traversal.select(nodes, nearView(), 550);
+        CHECK(traversal.selectedPoints() == 550 && traversal.selectedNodes().size() == 3 && !isSelected(traversal, 3));
+        CHECK(ranges->size() == 2 && ranges->back().firstVertex + ranges->back().nVertices == 550);
+
+        ranges = &traversal.select(nodes, nearView(), 560);
+        CHECK(traversal.selectedPoints() == 560 && traversal.selectedNodes().size() == 4);
+        CHECK(isSingleRange(*ranges, 0, 560));
+
+        //Within the budget the selection never exceeds it, and every selected node's parent is selected before it
+        for (std::uint64_t budget = 100; budget <= 600; budget += 5)
+        {
+            traversal.select(nodes, nearView(), budget);
+            const std::vector<std::uint32_t>& selected = traversal.selectedNodes();
+            bool valid = traversal.selectedPoints() <= budget && !selected.empty() && selected[0] == 0;
+            for (std::size_t i = 1; i < selected.size(); ++i)
+            {
+                std::uint32_t parent = selected[i] == 3 ? 2 : 0;
+                valid = valid && std::find(selected.begin(), selected.begin() + i, parent) != selected.begin() + i;
+            }
+            CHECK(valid);
+        }
+
+        CHECK(traversal.select({}, nearView(), 10).empty() && traversal.selectedNodes().empty());
+    }
+
+    void testCoarseFlags()
+    {
+        std::vector<LodNode> nodes = testNodes();
+        LodTraversal traversal;
+
+        //An inner node without selected children stands in for them
+        traversal.select(nodes, nearView(), 10);
+        CHECK(isCoarse(traversal, 0));
+        std::vector<DrawRange> ranges = traversal.select(nodes, nearView(), 550);
+        CHECK(!isCoarse(traversal, 0) && !isCoarse(traversal, 1) && isCoarse(traversal, 2));
+        //Only ranges that agree on coarse are merged
+        CHECK(ranges.size() == 2 && !ranges[0].coarse && ranges[1].coarse && ranges[1].firstVertex == 150);
+
+        traversal.select(nodes, nearView(), 560);
+        bool anyCoarse = false;
+        for (const DrawRange& range : traversal.selectedRanges())
+            anyCoarse = anyCoarse || range.coarse;
+        CHECK(!anyCoarse);
+
+        //Leaves are never coarse, even on their own
+        std::vector<LodNode> leaf = { makeNode(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), 0, 20, 1, 0, 0, 0.1f) };
+        traversal.select(leaf, nearView(), 10);
+        CHECK(traversal.selectedPoints() == 20 && !isCoarse(traversal, 0));
+    }
+
+    //Nodes are only refined while their sampling cells project to at least minimumProjectedSpacing pixels
+    void testRefinement()
+    {
+        std::vector<LodNode> nodes = testNodes();
+        LodTraversal traversal;
+
+        //The root's 1 unit cells project to about 54 pixels from nearView, its children's to about 27
+        traversal.select(nodes, nearView(), defaultPointBudget, 100.0f);
+        CHECK(traversal.selectedNodes() == std::vector<std::uint32_t>({ 0 }) && isCoarse(traversal, 0));
+        traversal.select(nodes, nearView(), defaultPointBudget, 40.0f);
+        CHECK(traversal.selectedNodes().size() == 3 && !isSelected(traversal, 3) && isCoarse(traversal, 2));
+        traversal.select(nodes, nearView(), defaultPointBudget, 1.0f);
+        CHECK(traversal.selectedNodes().size() == 4);
+
+        //From far away even the root's cells are below a pixel
+        traversal.select(nodes, cameraView(XMFLOAT3(4.0f, 2.0f, -2000.0f), XMFLOAT3(4.0f, 2.0f, 2.0f)));
+        CHECK(traversal.selectedNodes() == std::vector<std::uint32_t>({ 0 }));
+
+        //A real hierarchy refines further the nearer the camera gets, and spends more of the budget doing so. The plane
+        //stays in view throughout, so the frustum takes nothing away.
+        std::vector<PointCloudVertex> vertices;
+        for (int y = 0; y < 400; ++y)
+        {
+            for (int x = 0; x < 400; ++x)
+                vertices.push_back(PointCloudVertex(XMFLOAT3(x * 0.05f, y * 0.05f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)));
+        }
+        std::unique_ptr<LodHierarchy> hierarchy = buildLodHierarchy(vertices.data(), vertices.size(),
+            calculateBounds(vertices.data(), vertices.size()).box, nullptr, 1000);
+        CHECK(hierarchy && hierarchy->nodes.size() > 10);
+        if (!hierarchy)
+            return;
+        std::uint64_t previousPoints = 0;
+        unsigned int previousLevel = 0;
+        bool refines = true;
+        for (float distance : { 4000.0f, 400.0f, 100.0f, 40.0f })
+        {
+            traversal.select(hierarchy->nodes, cameraView(XMFLOAT3(10.0f, 10.0f, -distance), XMFLOAT3(10.0f, 10.0f, 0.0f)));
+            unsigned int deepestLevel = 0;
+            for (std::uint32_t node : traversal.selectedNodes())
+                deepestLevel = std::max<unsigned int>(deepestLevel, hierarchy->nodes[node].level);
+            refines = refines && traversal.selectedPoints() >= previousPoints && deepestLevel >= previousLevel;
+            previousPoints = traversal.selectedPoints();
+            previousLevel = deepestLevel;
+        }
+        CHECK(refines && previousLevel > 0 && previousPoints > hierarchy->nodes[0].nPoints);
+    }
+}
+
+int main()
+{
+    testBudget();
+    testCoarseFlags();
+    testRefinement();
+    return testResult();
+}
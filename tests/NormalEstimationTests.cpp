@@ -0,0 +1,75 @@
+#include "Check.h"
+#include "NormalEstimation.h"
+#include "OctahedralNormal.h"
+//C++
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    double dot(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return static_cast<double>(a.x) * b.x + static_cast<double>(a.y) * b.y + static_cast<double>(a.z) * b.z;
+    }
+
+    //A tilted plane, with an odd point count so the SIMD solver's last group is partial
+    void testPlane()
+    {
+        std::mt19937 random(24);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        XMFLOAT3 planeNormal;
+        XMStoreFloat3(&planeNormal, XMVector3Normalize(XMVectorSet(1.0f, -2.0f, 3.0f, 0.0f)));
+        std::vector<PointCloudVertex> vertices(50003);
+        for (PointCloudVertex& vertex : vertices)
+        {
+            //z chosen so that dot(position, planeNormal) is 1
+            float x = unit(random) * 20.0f, y = unit(random) * 20.0f;
+            float z = (1.0f - planeNormal.x * x - planeNormal.y * y) / planeNormal.z;
+            vertex = PointCloudVertex(XMFLOAT3(x, y, z), XMFLOAT3(0.0f, 0.0f, 0.0f));
+        }
+        PointCloud pointCloud(std::move(vertices));
+
+        //Turned towards a viewpoint on the side planeNormal points to
+        XMFLOAT3 viewpoint(planeNormal.x * 50.0f, planeNormal.y * 50.0f, planeNormal.z * 50.0f);
+        std::vector<std::uint32_t> normals;
+        CHECK(estimateNormals(pointCloud, normals, defaultNormalNeighbours, viewpoint));
+        CHECK(normals.size() == pointCloud.size());
+        bool alongPlaneNormal = true;
+        for (std::uint32_t normal : normals)
+            alongPlaneNormal = alongPlaneNormal && dot(decodeOctahedral(normal), planeNormal) > std::cos(XMConvertToRadians(0.5f));
+        CHECK(alongPlaneNormal);
+    }
+
+    //Without a viewpoint, normals of a closed surface point away from its centroid
+    void testSphere()
+    {
+        std::mt19937 random(240);
+        std::normal_distribution<float> gaussian;
+        std::vector<PointCloudVertex> vertices(40000);
+        XMFLOAT3 centre(5.0f, -2.0f, 8.0f);
+        std::vector<XMFLOAT3> radial(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            XMStoreFloat3(&radial[i], XMVector3Normalize(XMVectorSet(gaussian(random), gaussian(random), gaussian(random), 0.0f)));
+            vertices[i] = PointCloudVertex(XMFLOAT3(centre.x + radial[i].x * 10.0f, centre.y + radial[i].y * 10.0f,
+                centre.z + radial[i].z * 10.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+        }
+        PointCloud pointCloud(std::move(vertices));
+        std::vector<std::uint32_t> normals;
+        CHECK(estimateNormals(pointCloud, normals));
+        bool outward = normals.size() == radial.size();
+        for (std::size_t i = 0; outward && i < normals.size(); ++i)
+            outward = dot(decodeOctahedral(normals[i]), radial[i]) > std::cos(XMConvertToRadians(5.0f));
+        CHECK(outward);
+    }
+}
+
+int main()
+{
+    testPlane();
+    testSphere();
+    return testResult();
+}
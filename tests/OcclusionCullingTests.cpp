@@ -0,0 +1,214 @@
+#include "Check.h"
+#include "OcclusionCulling.h"
+#include "LodTraversal.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr unsigned int rtvSide = 160;
+    constexpr float fov = 60.0f;
+
+    XMMATRIX cameraMVP(const XMFLOAT3& eye, const XMFLOAT3& target)
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(eye.x, eye.y, eye.z, 1.0f), XMVectorSet(target.x, target.y, target.z, 1.0f),
+            XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XMConvertToRadians(fov), 1.0f, 0.5f, 200.0f));
+    }
+
+    //Points on a grid of the given spacing over an axis aligned box, flat along any axis where min and max agree
+    void addGrid(std::vector<PointCloudVertex>& vertices, const XMFLOAT3& min, const XMFLOAT3& max, float spacing)
+    {
+        int nX = static_cast<int>((max.x - min.x) / spacing) + 1;
+        int nY = static_cast<int>((max.y - min.y) / spacing) + 1;
+        int nZ = static_cast<int>((max.z - min.z) / spacing) + 1;
+        for (int z = 0; z < nZ; ++z)
+        {
+            for (int y = 0; y < nY; ++y)
+            {
+                for (int x = 0; x < nX; ++x)
+                    vertices.push_back(PointCloudVertex(XMFLOAT3(min.x + x * spacing, min.y + y * spacing, min.z + z * spacing),
+                        XMFLOAT3(0.5f, 0.5f, 0.5f)));
+            }
+        }
+    }
+
+    bool drawn(const std::vector<DrawRange>& ranges, std::uint64_t vertex)
+    {
+        for (const DrawRange& range : ranges)
+        {
+            if (vertex >= range.firstVertex && vertex < range.firstVertex + range.nVertices)
+                return true;
+        }
+        return false;
+    }
+
+    //What a depth tested 1 pixel point rasterizer would show: for every pixel the nearest of the given points, and
+    //whether each point is the nearest in some pixel
+    std::vector<bool> bruteForceVisible(const std::vector<DrawRange>& ranges, const PointCloudVertex* vertices, std::uint64_t nVertices,
+        FXMMATRIX MVP)
+    {
+        std::vector<float> depths(static_cast<std::size_t>(rtvSide) * rtvSide, 1.0f);
+        std::vector<std::uint64_t> nearest(depths.size(), std::numeric_limits<std::uint64_t>::max());
+        for (const DrawRange& range : ranges)
+        {
+            for (std::uint64_t i = range.firstVertex; i < range.firstVertex + range.nVertices; ++i)
+            {
+                const XMFLOAT3& position = vertices[i].modelPos;
+                XMVECTOR clip = XMVector4Transform(XMVectorSet(position.x, position.y, position.z, 1.0f), MVP);
+                float w = XMVectorGetW(clip), depth = XMVectorGetZ(clip) / w;
+                float x = (XMVectorGetX(clip) / w + 1.0f) * 0.5f * rtvSide, y = (1.0f - XMVectorGetY(clip) / w) * 0.5f * rtvSide;
+                if (w <= 0.0f || depth < 0.0f || depth > 1.0f || !(x >= 0.0f && x < rtvSide && y >= 0.0f && y < rtvSide))
+                    continue;
+                std::size_t pixel = static_cast<std::size_t>(y) * rtvSide + static_cast<std::size_t>(x);
+                if (depth < depths[pixel])
+                {
+                    depths[pixel] = depth;
+                    nearest[pixel] = i;
+                }
+            }
+        }
+        std::vector<bool> visible(nVertices, false);
+        for (std::uint64_t vertex : nearest)
+        {
+            if (vertex != std::numeric_limits<std::uint64_t>::max())
+                visible[vertex] = true;
+        }
+        return visible;
+    }
+
+    //A closed room with furniture inside and more of it outside, where the walls hide it from the recorded poses
+    void testRecordedPoses()
+    {
+        std::vector<PointCloudVertex> vertices;
+        addGrid(vertices, XMFLOAT3(-10.0f, 0.0f, -10.0f), XMFLOAT3(10.0f, 0.0f, 10.0f), 0.05f);
+        addGrid(vertices, XMFLOAT3(-10.0f, 0.0f, -10.0f), XMFLOAT3(10.0f, 12.0f, -10.0f), 0.05f);
+        addGrid(vertices, XMFLOAT3(-10.0f, 0.0f, 10.0f), XMFLOAT3(10.0f, 12.0f, 10.0f), 0.05f);
+        addGrid(vertices, XMFLOAT3(-10.0f, 0.0f, -10.0f), XMFLOAT3(-10.0f, 12.0f, 10.0f), 0.05f);
+        addGrid(vertices, XMFLOAT3(10.0f, 0.0f, -10.0f), XMFLOAT3(10.0f, 12.0f, 10.0f), 0.05f);
+        addGrid(vertices, XMFLOAT3(-2.0f, 0.0f, -2.0f), XMFLOAT3(2.0f, 1.0f, 2.0f), 0.1f);
+        addGrid(vertices, XMFLOAT3(4.0f, 0.0f, 5.0f), XMFLOAT3(6.0f, 2.5f, 6.0f), 0.1f);
+        addGrid(vertices, XMFLOAT3(20.0f, 0.0f, -5.0f), XMFLOAT3(24.0f, 3.0f, 5.0f), 0.1f);
+        addGrid(vertices, XMFLOAT3(-5.0f, 0.0f, 20.0f), XMFLOAT3(5.0f, 3.0f, 24.0f), 0.1f);
+        BoundingBox box = calculateBounds(vertices.data(), vertices.size()).box;
+        std::unique_ptr<LodHierarchy> hierarchy = buildLodHierarchy(vertices.data(), vertices.size(), box, nullptr, 4096);
+        CHECK(hierarchy != nullptr);
+        if (!hierarchy)
+            return;
+
+        struct Pose
+        {
+            XMFLOAT3 eye;
+            XMFLOAT3 target;
+        };
+        const Pose poses[] = {
+            { XMFLOAT3(-8.0f, 1.7f, 0.0f), XMFLOAT3(10.0f, 1.5f, 0.0f) },
+            { XMFLOAT3(0.0f, 1.7f, -8.0f), XMFLOAT3(0.0f, 1.0f, 10.0f) },
+            { XMFLOAT3(-6.0f, 3.0f, -6.0f), XMFLOAT3(6.0f, 0.5f, 6.0f) },
+            { XMFLOAT3(0.0f, 1.7f, 0.0f), XMFLOAT3(-10.0f, 2.0f, 3.0f) },
+            { XMFLOAT3(7.0f, 1.2f, -7.0f), XMFLOAT3(5.0f, 1.5f, 5.5f) },
+            //From outside, where the near wall hides the room
+            { XMFLOAT3(0.0f, 4.0f, -20.0f), XMFLOAT3(0.0f, 4.0f, 0.0f) },
+        };
+        LodTraversal traversal;
+        OcclusionCuller culler;
+        std::size_t nOccluded = 0;
+        for (const Pose& pose : poses)
+        {
+            XMMATRIX MVP = cameraMVP(pose.eye, pose.target);
+            //Refined past a point per pixel, so the walls' points leave no holes
+            traversal.select(hierarchy->nodes, { MVP, fov, rtvSide }, defaultPointBudget, 0.25f);
+            const std::vector<DrawRange>& culled = culler.cull(hierarchy->nodes, traversal.selectedNodes(), traversal.selectedRanges(),
+                hierarchy->vertices.data(), MVP, rtvSide, rtvSide, OccluderSplat::Point, 1 << 18);
+
+            //Every point the full selection would show in some pixel is still drawn
+            std::vector<bool> visible = bruteForceVisible(traversal.selectedRanges(), hierarchy->vertices.data(),
+                hierarchy->vertices.size(), MVP);
+            bool keptVisible = true;
+            for (std::uint64_t i = 0; keptVisible && i < visible.size(); ++i)
+                keptVisible = !visible[i] || drawn(culled, i);
+            CHECK(keptVisible);
+            nOccluded += culler.occludedNodes();
+        }
+        CHECK(nOccluded > 0);
+    }
+
+    //A wall covering the left half of the view, a box hidden behind it, a box in front of it and a box behind the
+    //open half. Returns the points of each in order as one node apiece.
+    std::vector<LodNode> wallScene(std::vector<PointCloudVertex>& vertices, float wallSpacing)
+    {
+        std::vector<LodNode> nodes;
+        auto addNode = [&](const XMFLOAT3& min, const XMFLOAT3& max, float spacing) {
+            std::uint64_t first = vertices.size();
+            addGrid(vertices, min, max, spacing);
+            LodNode node = {};
+            node.bounds = calculateBounds(vertices.data() + first, vertices.size() - first).box;
+            node.firstPoint = first;
+            node.nPoints = vertices.size() - first;
+            node.spacing = spacing;
+            nodes.push_back(node);
+        };
+        addNode(XMFLOAT3(-15.0f, -15.0f, 0.0f), XMFLOAT3(0.5f, 15.0f, 0.0f), wallSpacing);
+        addNode(XMFLOAT3(-8.0f, -2.0f, 5.0f), XMFLOAT3(-4.0f, 2.0f, 6.0f), 0.1f);
+        addNode(XMFLOAT3(3.0f, -1.0f, -5.0f), XMFLOAT3(5.0f, 1.0f, -4.0f), 0.1f);
+        addNode(XMFLOAT3(3.0f, -2.0f, 5.0f), XMFLOAT3(6.0f, 2.0f, 6.0f), 0.1f);
+        return nodes;
+    }
+
+    void testKnownOccluded()
+    {
+        std::vector<PointCloudVertex> vertices;
+        std::vector<LodNode> nodes = wallScene(vertices, 0.05f);
+        std::vector<std::uint32_t> selected = { 0, 1, 2, 3 };
+        std::vector<DrawRange> selectedRanges;
+        for (const LodNode& node : nodes)
+            selectedRanges.push_back({ node.firstPoint, node.nPoints });
+        XMMATRIX MVP = cameraMVP(XMFLOAT3(0.0f, 0.0f, -20.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+        //The box in front and the wall are the occluders, so only the box behind the wall goes
+        OcclusionCuller culler;
+        const std::vector<DrawRange>& culled = culler.cull(nodes, selected, selectedRanges, vertices.data(), MVP, rtvSide, rtvSide,
+            OccluderSplat::Point, nodes[0].nPoints + nodes[2].nPoints);
+        CHECK(culler.occludedNodes() == 1);
+        CHECK(drawn(culled, nodes[0].firstPoint) && !drawn(culled, nodes[1].firstPoint) && drawn(culled, nodes[2].firstPoint)
+            && drawn(culled, nodes[3].firstPoint));
+        CHECK(culler.bufferWidth() == rtvSide && culler.bufferHeight() == rtvSide);
+
+        //Without occluders nothing is culled
+        culler.cull(nodes, selected, selectedRanges, vertices.data(), MVP, rtvSide, rtvSide, OccluderSplat::Point, 0);
+        CHECK(culler.occludedNodes() == 0);
+    }
+
+    //Through a wall sampled a few pixels apart the box behind shows, which only the lossy cell splats hide
+    void testSparseOccluders()
+    {
+        std::vector<PointCloudVertex> vertices;
+        std::vector<LodNode> nodes = wallScene(vertices, 1.0f);
+        std::vector<std::uint32_t> selected = { 0, 1 };
+        std::vector<DrawRange> selectedRanges = { { nodes[0].firstPoint, nodes[0].nPoints }, { nodes[1].firstPoint, nodes[1].nPoints } };
+        XMMATRIX MVP = cameraMVP(XMFLOAT3(0.0f, 0.0f, -20.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+        std::vector<bool> visible = bruteForceVisible(selectedRanges, vertices.data(), vertices.size(), MVP);
+        CHECK(std::find(visible.begin() + nodes[1].firstPoint, visible.end(), true) != visible.end());
+
+        OcclusionCuller culler;
+        const std::vector<DrawRange>& culled = culler.cull(nodes, selected, selectedRanges, vertices.data(), MVP, rtvSide, rtvSide,
+            OccluderSplat::Point, nodes[0].nPoints);
+        CHECK(culler.occludedNodes() == 0 && drawn(culled, nodes[1].firstPoint));
+        culler.cull(nodes, selected, selectedRanges, vertices.data(), MVP, rtvSide, rtvSide, OccluderSplat::Cell, nodes[0].nPoints);
+        CHECK(culler.occludedNodes() == 1);
+        CHECK(culler.bufferWidth() == rtvSide / occlusionBufferDownscale);
+    }
+}
+
+int main()
+{
+    testRecordedPoses();
+    testKnownOccluded();
+    testSparseOccluders();
+    return testResult();
+}
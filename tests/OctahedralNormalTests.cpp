@@ -0,0 +1,122 @@
+#include "Check.h"
+#include "OctahedralNormal.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    //Angle between two directions in degrees. atan2 of the cross and dot products stays accurate for tiny angles,
+    //where acos of the dot product rounds to 0.
+    double angleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        double ax = a.x, ay = a.y, az = a.z, bx = b.x, by = b.y, bz = b.z;
+        double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+        double angle = std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz);
+        return angle * 180.0 / 3.14159265358979323846;
+    }
+
+    //Random directions, plus the axes, the octahedron's edges and folds and signed zeros where rounding is hardest
+    std::vector<XMFLOAT3> testNormals()
+    {
+        std::vector<XMFLOAT3> normals;
+        for (float x : { -1.0f, -0.0f, 0.0f, 1.0f })
+        {
+            for (float y : { -1.0f, -0.0f, 0.0f, 1.0f })
+            {
+                for (float z : { -1.0f, -0.0f, 0.0f, 1.0f })
+                {
+                    if (x != 0.0f || y != 0.0f || z != 0.0f)
+                        normals.push_back(XMFLOAT3(x, y, z));
+                }
+            }
+        }
+        std::mt19937 random(25);
+        std::normal_distribution<float> gaussian;
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        for (int i = 0; i < 200000; ++i)
+        {
+            XMFLOAT3 normal(gaussian(random), gaussian(random), gaussian(random));
+            //Every fourth one close to the equator, where the halves fold
+            if (i % 4 == 0)
+                normal.z = unit(random) * 1e-4f;
+            XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+            normals.push_back(normal);
+        }
+        return normals;
+    }
+
+    void testAngularError()
+    {
+        std::vector<XMFLOAT3> normals = testNormals();
+        double worst = 0.0;
+        for (const XMFLOAT3& normal : normals)
+        {
+            XMFLOAT3 unit;
+            XMStoreFloat3(&unit, XMVector3Normalize(XMLoadFloat3(&normal)));
+            worst = std::max(worst, angleDegrees(unit, decodeOctahedral(encodeOctahedral(normal))));
+        }
+        CHECK(worst < 0.01);
+    }
+
+    //Counts that aren't multiples of four leave a scalar tail
+    void testBatchesMatchScalar()
+    {
+        std::vector<XMFLOAT3> normals = testNormals();
+        normals.resize(normals.size() - 3);
+        std::vector<std::uint32_t> packed(normals.size());
+        encodeOctahedral(normals.data(), normals.size(), packed.data());
+        bool encodedSame = true;
+        for (std::size_t i = 0; i < normals.size(); ++i)
+            encodedSame = encodedSame && packed[i] == encodeOctahedral(normals[i]);
+        CHECK(encodedSame);
+
+        std::vector<XMFLOAT3> decoded(packed.size());
+        decodeOctahedral(packed.data(), packed.size(), decoded.data());
+        bool decodedSame = true;
+        for (std::size_t i = 0; i < packed.size(); ++i)
+        {
+            XMFLOAT3 scalar = decodeOctahedral(packed[i]);
+            decodedSame = decodedSame && std::memcmp(&scalar, &decoded[i], sizeof(XMFLOAT3)) == 0;
+        }
+        CHECK(decodedSame);
+
+        //The writer encodes in batches of its own and must flush the remainder
+        std::vector<std::uint32_t> written(normals.size() + 1, 0xFFFFFFFF);
+        OctahedralNormalWriter writer(written.data());
+        for (const XMFLOAT3& normal : normals)
+            writer.push(normal);
+        writer.flush();
+        CHECK(std::equal(packed.begin(), packed.end(), written.begin()) && written.back() == 0xFFFFFFFF);
+    }
+
+    //Zero and NaN normals encode to (0, 0, 1) in both paths
+    void testDegenerateNormals()
+    {
+        float nan = std::numeric_limits<float>::quiet_NaN();
+        XMFLOAT3 degenerate[] = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(-0.0f, 0.0f, -0.0f), XMFLOAT3(nan, 0.0f, 1.0f),
+            XMFLOAT3(nan, nan, nan), XMFLOAT3(0.0f, 0.0f, 0.0f) };
+        std::uint32_t packed[5];
+        encodeOctahedral(degenerate, 5, packed);
+        bool zero = true;
+        for (int i = 0; i < 5; ++i)
+            zero = zero && encodeOctahedral(degenerate[i]) == 0 && packed[i] == 0;
+        CHECK(zero);
+        XMFLOAT3 up = decodeOctahedral(0);
+        CHECK(up.x == 0.0f && up.y == 0.0f && up.z == 1.0f);
+    }
+}
+
+int main()
+{
+    testAngularError();
+    testBatchesMatchScalar();
+    testDegenerateNormals();
+    return testResult();
+}
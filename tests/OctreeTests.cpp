@@ -0,0 +1,134 @@
+#include "Check.h"
+#include "Octree.h"
+#include "RadixSort.h"
+//C++
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    //Must match a stable comparison sort, so equal keys keep their values in input order
+    template<typename Value>
+    bool matchesStableSort(std::vector<std::uint64_t> keys)
+    {
+        std::vector<Value> values(keys.size());
+        std::iota(values.begin(), values.end(), Value(0));
+        std::vector<std::pair<std::uint64_t, Value>> expected(keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i)
+            expected[i] = { keys[i], values[i] };
+        std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        radixSortPairs(keys, values);
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            if (keys[i] != expected[i].first || values[i] != expected[i].second)
+                return false;
+        }
+        return true;
+    }
+
+    void testRadixSort()
+    {
+        std::mt19937_64 random(14);
+        for (std::size_t nKeys : { 0, 1, 2, 1000, 500000 })
+        {
+            std::vector<std::uint64_t> full(nKeys), lowBits(nKeys), commonPrefix(nKeys), duplicates(nKeys);
+            for (std::size_t i = 0; i < nKeys; ++i)
+            {
+                full[i] = random();
+                lowBits[i] = random() & 0xFFFFF;
+                commonPrefix[i] = 0xABCD000000000000ull | (random() & 0xFFFFFFFFFull);
+                duplicates[i] = random() % 7;
+            }
+            CHECK(matchesStableSort<std::uint32_t>(full));
+            CHECK(matchesStableSort<std::uint64_t>(full));
+            CHECK(matchesStableSort<std::uint32_t>(lowBits));
+            CHECK(matchesStableSort<std::uint32_t>(commonPrefix));
+            CHECK(matchesStableSort<std::uint32_t>(duplicates));
+            //Already sorted and reversed input
+            std::sort(full.begin(), full.end());
+            CHECK(matchesStableSort<std::uint32_t>(full));
+            std::reverse(full.begin(), full.end());
+            CHECK(matchesStableSort<std::uint32_t>(full));
+        }
+    }
+
+    bool contains(const BoundingBox& outer, const BoundingBox& inner)
+    {
+        return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z
+            && outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+    }
+
+    void testOctreeStructure()
+    {
+        //A dense cluster inside a sparse cloud, so the tree is uneven
+        std::mt19937 random(15);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<PointCloudVertex> vertices(200000);
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            float scale = i % 2 ? 100.0f : 2.0f;
+            vertices[i].modelPos = DirectX::XMFLOAT3(unit(random) * scale, unit(random) * scale * 0.5f, unit(random) * scale * 0.1f);
+            vertices[i].colour = DirectX::XMFLOAT3(static_cast<float>(i), 0.0f, 0.0f);
+        }
+        constexpr std::size_t maxLeafPoints = 1000;
+        BoundingBox box = calculateBounds(vertices.data(), vertices.size()).box;
+        std::vector<std::uint64_t> codes, sourceIndices;
+        std::unique_ptr<Octree> octree = buildOctree(vertices.data(), vertices.size(), box, maxLeafPoints, &codes, &sourceIndices);
+
+        //The vertices are a permutation of the input in Morton order
+        CHECK(octree->vertices.size() == vertices.size() && codes.size() == vertices.size() && sourceIndices.size() == vertices.size());
+        CHECK(std::is_sorted(codes.begin(), codes.end()));
+        std::vector<bool> seen(vertices.size());
+        bool permutation = true;
+        for (std::size_t i = 0; i < sourceIndices.size() && permutation; ++i)
+        {
+            permutation = sourceIndices[i] < vertices.size() && !seen[sourceIndices[i]]
+                && std::memcmp(&octree->vertices[i], &vertices[sourceIndices[i]], sizeof(PointCloudVertex)) == 0;
+            seen[sourceIndices[i]] = true;
+        }
+        CHECK(permutation);
+
+        //Breadth first, every node the concatenation of its children, with tight bounds inside the parent's
+        const std::vector<OctreeNode>& nodes = octree->nodes;
+        CHECK(!nodes.empty() && nodes[0].firstPoint == 0 && nodes[0].nPoints == vertices.size() && nodes[0].level == 0);
+        bool breadthFirst = true, concatenated = true, nested = true, tight = true, leavesSmall = true;
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+        {
+            const OctreeNode& node = nodes[i];
+            breadthFirst = breadthFirst && (i == 0 || nodes[i - 1].level <= node.level);
+            BoundsAccumulator points;
+            for (std::uint64_t point = node.firstPoint; point < node.firstPoint + node.nPoints; ++point)
+                points.add(octree->vertices[point]);
+            tight = tight && node.nPoints != 0 && contains(node.bounds, { points.min, points.max }) && contains({ points.min, points.max }, node.bounds);
+            if (node.isLeaf())
+            {
+                leavesSmall = leavesSmall && node.nPoints <= maxLeafPoints;
+                continue;
+            }
+            std::uint64_t next = node.firstPoint;
+            int nChildren = 0;
+            for (std::uint8_t mask = node.childMask; mask != 0; mask &= mask - 1)
+            {
+                const OctreeNode& child = nodes[node.firstChild + nChildren++];
+                concatenated = concatenated && child.firstPoint == next && child.level == node.level + 1;
+                nested = nested && contains(node.bounds, child.bounds);
+                next = child.firstPoint + child.nPoints;
+            }
+            concatenated = concatenated && next == node.firstPoint + node.nPoints;
+        }
+        CHECK(breadthFirst && concatenated && nested && tight && leavesSmall);
+        CHECK(contains(octree->cube, nodes[0].bounds));
+    }
+}
+
+int main()
+{
+    testRadixSort();
+    testOctreeStructure();
+    return testResult();
+}
@@ -0,0 +1,128 @@
+#include "Check.h"
+#include "OutlierFilter.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    double distance(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        double dx = static_cast<double>(a.x) - b.x, dy = static_cast<double>(a.y) - b.y, dz = static_cast<double>(a.z) - b.z;
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    //Every point's mean distance to its nNeighbours nearest others, by sorting its distances to all of them
+    std::vector<double> bruteForceMeanDistances(const PointCloud& pointCloud, unsigned int nNeighbours)
+    {
+        std::vector<double> meanDistances(pointCloud.size());
+        std::vector<double> distances;
+        for (std::size_t i = 0; i < pointCloud.size(); ++i)
+        {
+            distances.clear();
+            for (std::size_t j = 0; j < pointCloud.size(); ++j)
+            {
+                if (j != i)
+                    distances.push_back(distance(pointCloud.data()[i].modelPos, pointCloud.data()[j].modelPos));
+            }
+            std::partial_sort(distances.begin(), distances.begin() + nNeighbours, distances.end());
+            double sum = 0.0;
+            for (unsigned int neighbour = 0; neighbour < nNeighbours; ++neighbour)
+                sum += distances[neighbour];
+            meanDistances[i] = sum / nNeighbours;
+        }
+        return meanDistances;
+    }
+
+    //A noisy plane with scattered points above it, some of them far off
+    PointCloud testCloud()
+    {
+        std::mt19937 random(23);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<PointCloudVertex> vertices(4000);
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            float height = i % 50 == 0 ? unit(random) * 40.0f : unit(random) * 0.05f;
+            vertices[i].modelPos = XMFLOAT3(unit(random) * 10.0f, unit(random) * 10.0f, height);
+            vertices[i].colour = XMFLOAT3(static_cast<float>(i), 0.0f, 0.0f);
+        }
+        PointCloud pointCloud(std::move(vertices));
+        for (std::size_t i = 0; i < pointCloud.size(); ++i)
+            pointCloud.normals.push_back(static_cast<std::uint32_t>(i));
+        pointCloud.origin = { -5.0, 7.0, 11.0 };
+        return pointCloud;
+    }
+
+    void testRemoveStatisticalOutliers()
+    {
+        PointCloud pointCloud = testCloud();
+        std::vector<double> meanDistances = bruteForceMeanDistances(pointCloud, defaultOutlierNeighbours);
+        for (float deviations : { defaultOutlierDeviations, 0.5f })
+        {
+            std::unique_ptr<PointCloud> filtered = removeStatisticalOutliers(pointCloud, defaultOutlierNeighbours, deviations);
+            CHECK(filtered != nullptr);
+            if (!filtered)
+                continue;
+
+            //Points whose mean distance is too close to the threshold to call with float sums may go either way
+            double sum = 0.0, squaredSum = 0.0;
+            for (double meanDistance : meanDistances)
+            {
+                sum += meanDistance;
+                squaredSum += meanDistance * meanDistance;
+            }
+            double mean = sum / meanDistances.size();
+            double threshold = mean + deviations * std::sqrt(squaredSum / meanDistances.size() - mean * mean);
+            std::vector<bool> mustKeep(pointCloud.size()), mayKeep(pointCloud.size());
+            for (std::size_t i = 0; i < pointCloud.size(); ++i)
+            {
+                mustKeep[i] = meanDistances[i] < threshold * (1.0 - 1e-4);
+                mayKeep[i] = meanDistances[i] <= threshold * (1.0 + 1e-4);
+            }
+
+            //The survivors are a subsequence of the input, identified by the index stored in their colour, with their
+            //normals carried along
+            bool matches = filtered->normals.size() == filtered->size() && filtered->origin == pointCloud.origin;
+            std::size_t next = 0;
+            for (std::size_t i = 0; matches && i < filtered->size(); ++i)
+            {
+                std::size_t source = static_cast<std::size_t>(filtered->data()[i].colour.x);
+                for (; next < source; ++next)
+                    matches = matches && !mustKeep[next];
+                matches = matches && source < pointCloud.size() && mayKeep[source] && filtered->normals[i] == pointCloud.normals[source];
+                next = source + 1;
+            }
+            for (; next < pointCloud.size(); ++next)
+                matches = matches && !mustKeep[next];
+            CHECK(matches);
+            CHECK(filtered->size() < pointCloud.size() && filtered->size() > pointCloud.size() / 2);
+            bool enclosed = filtered->bounds.has_value();
+            for (std::size_t i = 0; enclosed && i < filtered->size(); ++i)
+                enclosed = distance(filtered->data()[i].modelPos, filtered->bounds->sphere.centre) <= filtered->bounds->sphere.radius;
+            CHECK(enclosed);
+        }
+    }
+
+    //Too few points for every query to fill its neighbours, which must not count as distances
+    void testTinyClouds()
+    {
+        std::vector<PointCloudVertex> three(3, PointCloudVertex(XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(0.0f, 0.0f, 0.0f)));
+        three[2].modelPos.x = 2.0f;
+        std::unique_ptr<PointCloud> filtered = removeStatisticalOutliers(PointCloud(std::move(three)));
+        CHECK(filtered && filtered->size() == 3);
+
+        std::unique_ptr<PointCloud> empty = removeStatisticalOutliers(PointCloud(std::vector<PointCloudVertex>()));
+        CHECK(empty && empty->size() == 0);
+    }
+}
+
+int main()
+{
+    testRemoveStatisticalOutliers();
+    testTinyClouds();
+    return testResult();
+}
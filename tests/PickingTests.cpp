@@ -0,0 +1,135 @@
+#include "Check.h"
+#include "Picking.h"
+#include "QuantizedVertex.h"
+//C++
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr unsigned int rtvWidth = 640, rtvHeight = 480;
+
+    XMMATRIX testMVP()
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(-30.0f, 25.0f, -35.0f, 1.0f), XMVectorSet(10.0f, 5.0f, 10.0f, 1.0f),
+            XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f),
+            static_cast<float>(rtvWidth) / rtvHeight, 0.5f, 200.0f));
+    }
+
+    //Noisy terrain with clusters of different density, so nodes overlap along the rays
+    std::unique_ptr<LodHierarchy> testHierarchy()
+    {
+        std::mt19937 random(21);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<PointCloudVertex> vertices(200000);
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            float x = unit(random) * 20.0f, z = unit(random) * 20.0f;
+            float y = i % 4 ? 2.0f * std::sin(x * 0.5f) * std::cos(z * 0.3f) + unit(random) * 0.2f : unit(random) * 10.0f;
+            vertices[i].modelPos = XMFLOAT3(x, y, z);
+            vertices[i].colour = XMFLOAT3(unit(random), unit(random), unit(random));
+        }
+        BoundingBox box = calculateBounds(vertices.data(), vertices.size()).box;
+        return buildLodHierarchy(vertices.data(), vertices.size(), box, nullptr, 2000);
+    }
+
+    //The clip space position of a model space point
+    XMVECTOR project(FXMMATRIX MVP, const XMFLOAT3& point)
+    {
+        XMVECTOR clip = XMVector4Transform(XMVectorSet(point.x, point.y, point.z, 1.0f), MVP);
+        return XMVectorScale(clip, 1.0f / XMVectorGetW(clip));
+    }
+
+    //The ray runs from the pixel's centre on the near plane to the far plane
+    void testPickRay()
+    {
+        XMMATRIX MVP = testMVP();
+        PickRay ray = pickRay(MVP, 100.0f, 300.0f, rtvWidth, rtvHeight);
+        XMVECTOR start = project(MVP, ray.origin);
+        XMFLOAT3 end(ray.origin.x + ray.direction.x * ray.length, ray.origin.y + ray.direction.y * ray.length,
+            ray.origin.z + ray.direction.z * ray.length);
+        XMVECTOR finish = project(MVP, end);
+        float centreX = 2.0f * 100.5f / rtvWidth - 1.0f, centreY = 1.0f - 2.0f * 300.5f / rtvHeight;
+        CHECK(std::fabs(XMVectorGetX(start) - centreX) < 1e-4f && std::fabs(XMVectorGetY(start) - centreY) < 1e-4f);
+        CHECK(std::fabs(XMVectorGetZ(start)) < 1e-4f);
+        CHECK(std::fabs(XMVectorGetX(finish) - centreX) < 1e-3f && std::fabs(XMVectorGetY(finish) - centreY) < 1e-3f);
+        CHECK(std::fabs(XMVectorGetZ(finish) - 1.0f) < 1e-4f);
+        CHECK(ray.nearRadius > 0.0f && ray.farRadius > ray.nearRadius);
+    }
+
+    //Nearest point inside the cone by scanning every vertex, with the same arithmetic as the picker
+    float bruteForcePick(const LodHierarchy& hierarchy, const PickRay& ray)
+    {
+        float nearest = std::numeric_limits<float>::infinity();
+        for (const PointCloudVertex& vertex : hierarchy.vertices)
+        {
+            float offset[3] = { vertex.modelPos.x - ray.origin.x, vertex.modelPos.y - ray.origin.y, vertex.modelPos.z - ray.origin.z };
+            float along = offset[0] * ray.direction.x + offset[1] * ray.direction.y + offset[2] * ray.direction.z;
+            if (along < 0.0f || along > ray.length || along >= nearest)
+                continue;
+            float radius = ray.nearRadius + (ray.farRadius - ray.nearRadius) * (along / ray.length);
+            float squaredDistance = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+            if (squaredDistance - along * along <= radius * radius)
+                nearest = along;
+        }
+        return nearest;
+    }
+
+    void testPick()
+    {
+        std::unique_ptr<LodHierarchy> hierarchy = testHierarchy();
+        PointPicker picker;
+        picker.build(hierarchy->nodes, hierarchy->vertices.data());
+        XMMATRIX MVP = testMVP();
+        std::mt19937 random(210);
+        bool matches = true, sameVertex = true;
+        int nHits = 0, nMisses = 0;
+        for (int i = 0; i < 400; ++i)
+        {
+            float pixelX = static_cast<float>(random() % rtvWidth), pixelY = static_cast<float>(random() % rtvHeight);
+            //Wide cones as well, which overlap many nodes
+            PickRay ray = pickRay(MVP, pixelX, pixelY, rtvWidth, rtvHeight, i % 4 ? defaultPickPixelRadius : 40.0f);
+            std::optional<PickedPoint> picked = picker.pick(hierarchy->nodes, hierarchy->vertices.data(), ray);
+            float expected = bruteForcePick(*hierarchy, ray);
+            matches = matches && picked.has_value() == std::isfinite(expected) && (!picked || picked->distance == expected);
+            if (picked)
+            {
+                sameVertex = sameVertex && picked->index < hierarchy->vertices.size()
+                    && picked->vertex.modelPos.x == hierarchy->vertices[picked->index].modelPos.x
+                    && picked->vertex.colour.x == hierarchy->vertices[picked->index].colour.x;
+            }
+            nHits += picked.has_value();
+            nMisses += !picked;
+        }
+        CHECK(matches);
+        CHECK(sameVertex);
+        CHECK(nHits > 0 && nMisses > 0);
+    }
+
+    //A leaf stands in for nothing, so its coarse colours are its points' own
+    void testCoarseColours()
+    {
+        std::unique_ptr<LodHierarchy> hierarchy = testHierarchy();
+        CHECK(hierarchy->coarseColours.size() == hierarchy->vertices.size());
+        bool leavesOwnColour = true;
+        for (const LodNode& node : hierarchy->nodes)
+        {
+            for (std::uint64_t point = node.firstPoint; node.isLeaf() && point < node.firstPoint + node.nPoints; ++point)
+                leavesOwnColour = leavesOwnColour && hierarchy->coarseColours[point] == packColour(hierarchy->vertices[point].colour);
+        }
+        CHECK(leavesOwnColour);
+    }
+}
+
+int main()
+{
+    testPickRay();
+    testPick();
+    testCoarseColours();
+    return testResult();
+}
@@ -0,0 +1,263 @@
+#include "Check.h"
+#include "PlyReader.h"
+#include "OctahedralNormal.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Column
+    {
+        std::string type;
+        std::string name;
+    };
+
+    //Values of one test point by property name. Positions are multiples of 1/1024 and normals floats, so both are
+    //exact in every type they are written as. Properties the reader ignores all take intensity, which fits any type.
+    struct TestPoint
+    {
+        double x, y, z;
+        int red, green, blue;
+        float nx, ny, nz;
+        double intensity;
+    };
+
+    std::vector<TestPoint> testPoints(std::size_t nPoints)
+    {
+        std::mt19937 random(7);
+        std::uniform_int_distribution<int> coordinate(-2000000, 2000000);
+        std::uniform_int_distribution<int> channel(0, 255);
+        std::normal_distribution<float> gaussian;
+        std::vector<TestPoint> points(nPoints);
+        for (TestPoint& point : points)
+        {
+            point.x = coordinate(random) / 1024.0;
+            point.y = coordinate(random) / 1024.0;
+            point.z = coordinate(random) / 1024.0;
+            point.red = channel(random);
+            point.green = channel(random);
+            point.blue = channel(random);
+            float nx = gaussian(random), ny = gaussian(random), nz = gaussian(random);
+            float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+            point.nx = nx / length;
+            point.ny = ny / length;
+            point.nz = nz / length;
+            point.intensity = channel(random) * 0.5;
+        }
+        return points;
+    }
+
+    //ushort colours hold the 8-bit channel times 257, so they scale back to the same fraction of full
+    double columnValue(const TestPoint& point, const Column& column)
+    {
+        int channelScale = column.type == "ushort" ? 257 : 1;
+        if (column.name == "x") return point.x;
+        if (column.name == "y") return point.y;
+        if (column.name == "z") return point.z;
+        if (column.name == "red" || column.name == "diffuse_red") return column.type == "float" ? point.red / 255.0 : point.red * channelScale;
+        if (column.name == "green" || column.name == "diffuse_green") return column.type == "float" ? point.green / 255.0 : point.green * channelScale;
+        if (column.name == "blue" || column.name == "diffuse_blue") return column.type == "float" ? point.blue / 255.0 : point.blue * channelScale;
+        if (column.name == "nx") return point.nx;
+        if (column.name == "ny") return point.ny;
+        if (column.name == "nz") return point.nz;
+        return point.intensity;
+    }
+
+    template<typename T>
+    void appendBinary(std::string& body, T value, bool bigEndian)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        if (bigEndian)
+            std::reverse(bytes, bytes + sizeof(T));
+        body.append(bytes, sizeof(T));
+    }
+
+    void appendValue(std::string& body, double value, const std::string& type, PlyFormat format)
+    {
+        if (format == PlyFormat::Ascii)
+        {
+            char token[32];
+            if (type == "float")
+                std::snprintf(token, sizeof(token), "%.9g ", static_cast<float>(value));
+            else if (type == "double")
+                std::snprintf(token, sizeof(token), "%.17g ", value);
+            else
+                std::snprintf(token, sizeof(token), "%d ", static_cast<int>(value));
+            body += token;
+            return;
+        }
+        bool bigEndian = format == PlyFormat::BinaryBigEndian;
+        if (type == "uchar") appendBinary(body, static_cast<std::uint8_t>(value), bigEndian);
+        else if (type == "short") appendBinary(body, static_cast<std::int16_t>(value), bigEndian);
+        else if (type == "ushort") appendBinary(body, static_cast<std::uint16_t>(value), bigEndian);
+        else if (type == "int") appendBinary(body, static_cast<std::int32_t>(value), bigEndian);
+        else if (type == "float") appendBinary(body, static_cast<float>(value), bigEndian);
+        else appendBinary(body, value, bigEndian);
+    }
+
+    //Writes the points as the vertex element, after a one item "camera" element and before a "face" element with a
+    //list property, which the reader has to step over and ignore.
+    std::filesystem::path writePly(const std::string& name, PlyFormat format, const std::vector<Column>& columns,
+        const std::vector<TestPoint>& points)
+    {
+        const char* formatNames[] = { "ascii", "binary_little_endian", "binary_big_endian" };
+        std::string text = std::string("ply\nformat ") + formatNames[static_cast<int>(format)] + " 1.0\ncomment test file\n";
+        text += "element camera 1\nproperty float view_x\nproperty float view_y\n";
+        text += "element vertex " + std::to_string(points.size()) + "\n";
+        for (const Column& column : columns)
+            text += "property " + column.type + " " + column.name + "\n";
+        text += "element face 1\nproperty list uchar int vertex_indices\nend_header\n";
+
+        appendValue(text, 1.5, "float", format);
+        appendValue(text, -2.5, "float", format);
+        if (format == PlyFormat::Ascii)
+            text += "\n";
+        for (const TestPoint& point : points)
+        {
+            for (const Column& column : columns)
+                appendValue(text, columnValue(point, column), column.type, format);
+            if (format == PlyFormat::Ascii)
+                text += "\n";
+        }
+        if (format == PlyFormat::Ascii)
+            text += "3 0 1 2\n";
+        else
+        {
+            text += '\3';
+            for (std::int32_t index : { 0, 1, 2 })
+                appendBinary(text, index, format == PlyFormat::BinaryBigEndian);
+        }
+
+        std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+        std::ofstream(path, std::ios::binary).write(text.data(), static_cast<std::streamsize>(text.size()));
+        return path;
+    }
+
+    float colourScale(const std::string& type)
+    {
+        return type == "uchar" ? 1.0f / 255.0f : type == "ushort" ? 1.0f / 65535.0f : 1.0f;
+    }
+
+    //The cloud holds every point in order with the reader's exact conversions, and the normals if they were written
+    bool matchesPoints(const PointCloud& pointCloud, const std::vector<TestPoint>& points, const std::vector<Column>& columns,
+        bool withNormals)
+    {
+        if (pointCloud.size() != points.size() || pointCloud.normals.size() != (withNormals ? points.size() : 0))
+            return false;
+        auto colourColumn = std::find_if(columns.begin(), columns.end(),
+            [](const Column& column) { return column.name == "red" || column.name == "diffuse_red"; });
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            const PointCloudVertex& vertex = pointCloud.data()[i];
+            DirectX::XMFLOAT3 colour(1.0f, 1.0f, 1.0f);
+            if (colourColumn != columns.end())
+            {
+                float scale = colourScale(colourColumn->type);
+                Column red = *colourColumn, green = { red.type, "green" }, blue = { red.type, "blue" };
+                colour = DirectX::XMFLOAT3(static_cast<float>(columnValue(points[i], red)) * scale,
+                    static_cast<float>(columnValue(points[i], green)) * scale, static_cast<float>(columnValue(points[i], blue)) * scale);
+            }
+            if (vertex.modelPos.x != static_cast<float>(points[i].x) || vertex.modelPos.y != static_cast<float>(points[i].y)
+                || vertex.modelPos.z != static_cast<float>(points[i].z) || vertex.colour.x != colour.x || vertex.colour.y != colour.y
+                || vertex.colour.z != colour.z)
+                return false;
+            if (withNormals
+                && pointCloud.normals[i] != encodeOctahedral(DirectX::XMFLOAT3(points[i].nx, points[i].ny, points[i].nz)))
+                return false;
+        }
+        return true;
+    }
+
+    bool matchesBounds(const PointCloud& pointCloud)
+    {
+        BoundingBox expected = calculateBounds(pointCloud.data(), pointCloud.size()).box;
+        return pointCloud.bounds && std::memcmp(&pointCloud.bounds->box, &expected, sizeof(BoundingBox)) == 0;
+    }
+
+    //Every format with several property layouts, over enough points that binary bodies are split between tasks
+    void testLayouts()
+    {
+        std::vector<TestPoint> points = testPoints(150000);
+        const std::vector<Column> layouts[] = {
+            { { "float", "x" }, { "float", "y" }, { "float", "z" }, { "uchar", "red" }, { "uchar", "green" }, { "uchar", "blue" } },
+            { { "float", "x" }, { "float", "y" }, { "float", "z" }, { "float", "nx" }, { "float", "ny" }, { "float", "nz" },
+                { "uchar", "red" }, { "uchar", "green" }, { "uchar", "blue" } },
+            //Extra properties around and between the ones read, positions not packed
+            { { "double", "intensity" }, { "double", "x" }, { "uchar", "alpha" }, { "double", "y" }, { "double", "z" },
+                { "ushort", "red" }, { "ushort", "green" }, { "ushort", "blue" }, { "short", "label" } },
+            { { "int", "index" }, { "float", "z" }, { "float", "y" }, { "float", "x" }, { "float", "nz" }, { "float", "ny" },
+                { "float", "nx" }, { "float", "diffuse_red" }, { "float", "diffuse_green" }, { "float", "diffuse_blue" } },
+            { { "float", "x" }, { "float", "y" }, { "float", "z" } },
+        };
+        for (const std::vector<Column>& columns : layouts)
+        {
+            bool withNormals = std::any_of(columns.begin(), columns.end(), [](const Column& column) { return column.name == "nx"; });
+            for (PlyFormat format : { PlyFormat::Ascii, PlyFormat::BinaryLittleEndian, PlyFormat::BinaryBigEndian })
+            {
+                std::filesystem::path path = writePly("pcv_ply_test.ply", format, columns, points);
+                std::unique_ptr<PointCloud> pointCloud = readPointCloudPLY(path);
+                CHECK(pointCloud && matchesPoints(*pointCloud, points, columns, withNormals) && matchesBounds(*pointCloud));
+                std::filesystem::remove(path);
+            }
+        }
+    }
+
+    void testHeader()
+    {
+        std::string text = "ply\r\nformat binary_big_endian 1.0\r\nobj_info scanner\r\nelement vertex 3\r\nproperty double x\r\n"
+            "property float y\r\nproperty float z\r\nproperty uchar red\r\nelement face 2\r\nproperty list uchar int vertex_indices\r\n"
+            "end_header\r\n";
+        PlyHeader header;
+        CHECK(parsePlyHeader(text, header) && header.format == PlyFormat::BinaryBigEndian && header.bodyOffset == text.size());
+        CHECK(header.elements.size() == 2 && header.elements[0].count == 3 && header.elements[0].recordSize == 17
+            && header.elements[0].properties[2].offset == 12 && header.elements[1].recordSize == 0);
+
+        CHECK(!parsePlyHeader("plyx\nformat ascii 1.0\nend_header\n", header));
+        CHECK(!parsePlyHeader("ply\nformat binary_middle_endian 1.0\nend_header\n", header));
+        CHECK(!parsePlyHeader("ply\nelement vertex 1\nproperty float x\nend_header\n", header));
+        CHECK(!parsePlyHeader("ply\nformat ascii 1.0\nproperty float x\nend_header\n", header));
+        CHECK(!parsePlyHeader("ply\nformat ascii 1.0\nelement vertex 1\nproperty quad x\nend_header\n", header));
+        CHECK(!parsePlyHeader("ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\n", header));
+    }
+
+    void testRejected()
+    {
+        std::vector<TestPoint> points = testPoints(100);
+        std::vector<Column> noZ = { { "float", "x" }, { "float", "y" }, { "uchar", "red" } };
+        std::filesystem::path path = writePly("pcv_ply_rejected.ply", PlyFormat::BinaryLittleEndian, noZ, points);
+        CHECK(!readPointCloudPLY(path));
+
+        //A vertex list property leaves binary records without a fixed size
+        std::vector<Column> withList = { { "float", "x" }, { "float", "y" }, { "float", "z" } };
+        std::string text = "ply\nformat binary_little_endian 1.0\nelement vertex 1\nproperty float x\nproperty float y\n"
+            "property float z\nproperty list uchar int extra\nend_header\n";
+        text.append(13, '\0');
+        std::ofstream(path, std::ios::binary).write(text.data(), static_cast<std::streamsize>(text.size()));
+        CHECK(!readPointCloudPLY(path));
+
+        //A body shorter than its declared vertices
+        path = writePly("pcv_ply_rejected.ply", PlyFormat::BinaryLittleEndian, withList, points);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 17 - 12 * 50);
+        CHECK(!readPointCloudPLY(path));
+        std::filesystem::remove(path);
+
+        CHECK(!readPointCloudPLY(std::filesystem::temp_directory_path() / "pcv_missing_file.ply"));
+    }
+}
+
+int main()
+{
+    testLayouts();
+    testHeader();
+    testRejected();
+    return testResult();
+}
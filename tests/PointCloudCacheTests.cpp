@@ -0,0 +1,207 @@
+#include "Check.h"
+#include "PointCloudCache.h"
+#include "PointCloudLoader.h"
+//C++
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace
+{
+    std::filesystem::path temporaryPath(const std::string& name)
+    {
+        return std::filesystem::temp_directory_path() / name;
+    }
+
+    std::unique_ptr<PointCloud> makePointCloud(std::size_t nPoints, bool withNormals)
+    {
+        std::mt19937 random(6);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<PointCloudVertex> vertices(nPoints);
+        for (PointCloudVertex& vertex : vertices)
+        {
+            vertex.modelPos = DirectX::XMFLOAT3(unit(random) * 10.0f, unit(random) * 20.0f, unit(random));
+            vertex.colour = DirectX::XMFLOAT3(unit(random), unit(random), unit(random));
+        }
+        auto pointCloud = std::make_unique<PointCloud>(std::move(vertices));
+        if (withNormals)
+        {
+            for (std::size_t i = 0; i < nPoints; ++i)
+                pointCloud->normals.push_back(static_cast<std::uint32_t>(random()));
+        }
+        pointCloud->bounds = calculateBounds(pointCloud->data(), pointCloud->size());
+        pointCloud->origin = { 1234567.25, -7654321.5, 42.0 };
+        return pointCloud;
+    }
+
+    bool sameVertices(const PointCloudVertex* a, const PointCloudVertex* b, std::size_t nVertices)
+    {
+        return nVertices == 0 || std::memcmp(a, b, nVertices * sizeof(PointCloudVertex)) == 0;
+    }
+
+    void testRoundTrip()
+    {
+        std::filesystem::path cachePath = temporaryPath("pcv_cache_test.pcvcache");
+        SourceFingerprint fingerprint = { 123456, 987654321, 0x0123456789ABCDEFull };
+        for (bool withNormals : { false, true })
+        {
+            std::unique_ptr<PointCloud> pointCloud = makePointCloud(5000, withNormals);
+            CHECK(writePointCloudCache(cachePath, fingerprint, *pointCloud));
+            std::unique_ptr<PointCloud> cached = openPointCloudCache(cachePath, fingerprint);
+            CHECK(cached && cached->size() == pointCloud->size());
+            if (!cached || cached->size() != pointCloud->size())
+                continue;
+            CHECK(sameVertices(cached->data(), pointCloud->data(), pointCloud->size()));
+            CHECK(cached->normals == pointCloud->normals);
+            CHECK(cached->origin == pointCloud->origin);
+            CHECK(cached->bounds && cached->bounds->box.min.y == pointCloud->bounds->box.min.y
+                && cached->bounds->sphere.radius == pointCloud->bounds->sphere.radius);
+            CHECK(!cached->lod);
+        }
+        std::filesystem::remove(cachePath);
+    }
+
+    void testLodRoundTrip()
+    {
+        std::filesystem::path cachePath = temporaryPath("pcv_cache_lod_test.pcvcache");
+        SourceFingerprint fingerprint = { 1, 2, 3 };
+        std::unique_ptr<PointCloud> pointCloud = makePointCloud(60000, true);
+        pointCloud->lod = buildLodHierarchy(pointCloud->data(), pointCloud->size(), pointCloud->bounds->box,
+            pointCloud->normals.data(), 1000);
+        const LodHierarchy& lod = *pointCloud->lod;
+        CHECK(writePointCloudCache(cachePath, fingerprint, *pointCloud));
+
+        //Without withLod the points come back in the hierarchy's order but without it
+        std::unique_ptr<PointCloud> withoutLod = openPointCloudCache(cachePath, fingerprint);
+        CHECK(withoutLod && !withoutLod->lod && sameVertices(withoutLod->data(), lod.vertices.data(), lod.vertices.size()));
+        withoutLod.reset();
+
+        std::unique_ptr<PointCloud> cached = openPointCloudCache(cachePath, fingerprint, true);
+        CHECK(cached && cached->lod);
+        if (cached && cached->lod)
+        {
+            const LodHierarchy& cachedLod = *cached->lod;
+            CHECK(sameVertices(cachedLod.vertices.data(), lod.vertices.data(), lod.vertices.size()));
+            CHECK(cachedLod.normals == lod.normals && cachedLod.coarseColours == lod.coarseColours);
+            CHECK(cachedLod.cube.min.x == lod.cube.min.x && cachedLod.cube.max.z == lod.cube.max.z);
+            bool sameNodes = cachedLod.nodes.size() == lod.nodes.size();
+            for (std::size_t i = 0; sameNodes && i < lod.nodes.size(); ++i)
+            {
+                const LodNode& a = cachedLod.nodes[i];
+                const LodNode& b = lod.nodes[i];
+                sameNodes = a.firstPoint == b.firstPoint && a.nPoints == b.nPoints && a.firstChild == b.firstChild
+                    && a.childMask == b.childMask && a.level == b.level && a.spacing == b.spacing && a.bounds.max.x == b.bounds.max.x;
+            }
+            CHECK(sameNodes && lod.nodes.size() > 1);
+
+            //The hierarchy views the cloud's mapped vertices rather than a copy, and keeps them mapped on its own
+            CHECK(cachedLod.vertices.data() == cached->data());
+            std::unique_ptr<LodHierarchy> kept = std::move(cached->lod);
+            cached.reset();
+            CHECK(sameVertices(kept->vertices.data(), lod.vertices.data(), lod.vertices.size()));
+        }
+        cached.reset();
+
+        //A node pointing past the vertices makes the whole cache invalid
+        std::uint64_t fileSize = std::filesystem::file_size(cachePath);
+        std::uint64_t nodesOffset = fileSize - lod.nodes.size() * sizeof(LodNode);
+        auto corruptNode = [&](std::size_t node, std::size_t fieldOffset, const void* value, std::size_t size) {
+            CHECK(writePointCloudCache(cachePath, fingerprint, *pointCloud));
+            std::fstream file(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(nodesOffset + node * sizeof(LodNode) + fieldOffset));
+            file.write(static_cast<const char*>(value), static_cast<std::streamsize>(size));
+        };
+        std::uint64_t pastTheEnd = lod.vertices.size() + 1;
+        corruptNode(lod.nodes.size() - 1, offsetof(LodNode, firstPoint), &pastTheEnd, sizeof(pastTheEnd));
+        CHECK(!openPointCloudCache(cachePath, fingerprint, true));
+
+        //So does a node whose children point back at itself or an earlier node, which would be walked forever
+        std::size_t inner = 1;
+        while (inner < lod.nodes.size() && lod.nodes[inner].isLeaf())
+            ++inner;
+        CHECK(inner < lod.nodes.size());
+        for (std::uint32_t firstChild : { static_cast<std::uint32_t>(inner), 1u })
+        {
+            corruptNode(inner, offsetof(LodNode, firstChild), &firstChild, sizeof(firstChild));
+            CHECK(!openPointCloudCache(cachePath, fingerprint, true));
+        }
+        std::filesystem::remove(cachePath);
+    }
+
+    void testRejection()
+    {
+        std::filesystem::path cachePath = temporaryPath("pcv_cache_reject_test.pcvcache");
+        SourceFingerprint fingerprint = { 100, 200, 300 };
+        std::unique_ptr<PointCloud> pointCloud = makePointCloud(1000, true);
+        CHECK(writePointCloudCache(cachePath, fingerprint, *pointCloud));
+
+        //Stale: any part of the fingerprint differs
+        CHECK(!openPointCloudCache(cachePath, { 101, 200, 300 }));
+        CHECK(!openPointCloudCache(cachePath, { 100, 201, 300 }));
+        CHECK(!openPointCloudCache(cachePath, { 100, 200, 301 }));
+        CHECK(openPointCloudCache(cachePath, fingerprint) != nullptr);
+
+        //Invalid: a truncated payload, a wrong magic or a wrong version
+        std::uint64_t fileSize = std::filesystem::file_size(cachePath);
+        std::filesystem::resize_file(cachePath, fileSize - 1);
+        CHECK(!openPointCloudCache(cachePath, fingerprint));
+        std::filesystem::resize_file(cachePath, 16);
+        CHECK(!openPointCloudCache(cachePath, fingerprint));
+
+        CHECK(writePointCloudCache(cachePath, fingerprint, *pointCloud));
+        {
+            std::fstream file(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(8);
+            std::uint32_t version = 1;
+            file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        }
+        CHECK(!openPointCloudCache(cachePath, fingerprint));
+        {
+            std::fstream file(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+            file.write("NOTCACHE", 8);
+        }
+        CHECK(!openPointCloudCache(cachePath, fingerprint));
+        CHECK(!openPointCloudCache(temporaryPath("pcv_missing.pcvcache"), fingerprint));
+        std::filesystem::remove(cachePath);
+    }
+
+    //Editing the source, even without changing its size, must make loadPointCloud reparse it
+    void testSourceChanges()
+    {
+        std::filesystem::path sourcePath = temporaryPath("pcv_cache_source_test.asc");
+        std::filesystem::path cachePath = cachePathFor(sourcePath);
+        std::filesystem::remove(cachePath);
+        std::ofstream(sourcePath, std::ios::binary) << "1 2 3\n4 5 6\n";
+        std::unique_ptr<PointCloud> parsed = loadPointCloud(sourcePath, false);
+        CHECK(parsed && parsed->size() == 2 && std::filesystem::exists(cachePath));
+        std::unique_ptr<PointCloud> cached = loadPointCloud(sourcePath, false);
+        CHECK(cached && cached->size() == 2 && cached->data()[1].modelPos.z == 6.0f);
+        //The sphere fitted on the reparse is stored, so the cached cloud doesn't have to fit it again
+        CHECK(parsed && parsed->bounds && parsed->bounds->minimalSphere && cached && cached->bounds && cached->bounds->minimalSphere
+            && cached->bounds->sphere.radius == parsed->bounds->sphere.radius);
+        cached.reset();
+
+        std::optional<SourceFingerprint> before = fingerprintSource(sourcePath);
+        std::ofstream(sourcePath, std::ios::binary) << "1 2 3\n4 5 9\n";
+        std::optional<SourceFingerprint> after = fingerprintSource(sourcePath);
+        CHECK(before && after && before->size == after->size && before->hash != after->hash);
+        std::unique_ptr<PointCloud> reparsed = loadPointCloud(sourcePath, false);
+        CHECK(reparsed && reparsed->size() == 2 && reparsed->data()[1].modelPos.z == 9.0f);
+        reparsed.reset();
+
+        std::filesystem::remove(cachePath);
+        std::filesystem::remove(sourcePath);
+    }
+}
+
+int main()
+{
+    testRoundTrip();
+    testLodRoundTrip();
+    testRejection();
+    testSourceChanges();
+    return testResult();
+}
@@ -0,0 +1,88 @@
+#include "Check.h"
+#include "QuantizedVertex.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+    //Largest error on one axis relative to the documented bound: step / 2 plus the float rounding of the input and of
+    //the dequantization, a few ulps of the largest magnitude involved
+    double worstRelativeError(const std::vector<PointCloudVertex>& vertices)
+    {
+        QuantizationBlock block = computeQuantizationBlock(vertices.data(), vertices.size());
+        std::vector<QuantizedVertex> quantized(vertices.size());
+        quantizeVertices(vertices.data(), vertices.size(), block, quantized.data());
+
+        double worst = 0.0;
+        const float origin[3] = { block.origin.x, block.origin.y, block.origin.z };
+        const float step[3] = { block.step.x, block.step.y, block.step.z };
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            PointCloudVertex decoded = dequantizeVertex(quantized[i], block);
+            const float input[3] = { vertices[i].modelPos.x, vertices[i].modelPos.y, vertices[i].modelPos.z };
+            const float output[3] = { decoded.modelPos.x, decoded.modelPos.y, decoded.modelPos.z };
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                double magnitude = std::max({ std::fabs(origin[axis]), std::fabs(input[axis]), std::fabs(output[axis]) });
+                double bound = step[axis] / 2.0 + 4.0 * magnitude * std::numeric_limits<float>::epsilon();
+                worst = std::max(worst, std::fabs(static_cast<double>(output[axis]) - input[axis]) / bound);
+            }
+        }
+        return worst;
+    }
+
+    std::vector<PointCloudVertex> randomVertices(std::size_t nVertices, DirectX::XMFLOAT3 centre, DirectX::XMFLOAT3 extent)
+    {
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+        std::vector<PointCloudVertex> vertices(nVertices);
+        for (PointCloudVertex& vertex : vertices)
+        {
+            vertex.modelPos = DirectX::XMFLOAT3(centre.x + unit(random) * extent.x, centre.y + unit(random) * extent.y,
+                centre.z + unit(random) * extent.z);
+            vertex.colour = DirectX::XMFLOAT3(unit(random) + 0.5f, unit(random) + 0.5f, unit(random) + 0.5f);
+        }
+        return vertices;
+    }
+
+    void testPositionErrorBound()
+    {
+        //Unit cube, a large scan far from the origin and a flat cloud whose z step is 0
+        CHECK(worstRelativeError(randomVertices(200000, { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f })) <= 1.0);
+        CHECK(worstRelativeError(randomVertices(200000, { 5000.0f, -3000.0f, 120.0f }, { 800.0f, 600.0f, 40.0f })) <= 1.0);
+        CHECK(worstRelativeError(randomVertices(10000, { 1.0f, 2.0f, 3.0f }, { 10.0f, 10.0f, 0.0f })) <= 1.0);
+    }
+
+    void testColourAndPacking()
+    {
+        std::vector<PointCloudVertex> vertices = randomVertices(10000, { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+        vertices[0].colour = DirectX::XMFLOAT3(-1.0f, 2.0f, 0.5f); //Clamped to [0, 1]
+        QuantizationBlock block = computeQuantizationBlock(vertices.data(), vertices.size());
+        std::vector<QuantizedVertex> quantized(vertices.size());
+        quantizeVertices(vertices.data(), vertices.size(), block, quantized.data());
+
+        bool withinHalfStep = true, topBitClear = true;
+        for (std::size_t i = 1; i < vertices.size(); ++i)
+        {
+            PointCloudVertex decoded = dequantizeVertex(quantized[i], block);
+            withinHalfStep = withinHalfStep && std::fabs(decoded.colour.x - vertices[i].colour.x) <= 0.5f / 255.0f + 1e-6f
+                && std::fabs(decoded.colour.z - vertices[i].colour.z) <= 0.5f / 255.0f + 1e-6f;
+            topBitClear = topBitClear && (quantized[i].packedPosition[1] >> 31) == 0;
+            withinHalfStep = withinHalfStep && quantized[i].colour == packColour(vertices[i].colour);
+        }
+        CHECK(withinHalfStep && topBitClear);
+        CHECK(quantized[0].colour == (0u | (255u << 8) | (128u << 16) | (255u << 24)));
+        CHECK(packColour(DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f)) == 0xFF0000FFu);
+    }
+}
+
+int main()
+{
+    testPositionErrorBound();
+    testColourAndPacking();
+    return testResult();
+}
@@ -0,0 +1,154 @@
+#include "Check.h"
+#include "SpaceFillingCurve.h"
+//C++
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    void testMortonCode()
+    {
+        std::mt19937 random(15);
+        bool roundTrips = true;
+        for (int i = 0; i < 10000; ++i)
+        {
+            std::uint32_t x = random() & (curveGridSize - 1), y = random() & (curveGridSize - 1), z = random() & (curveGridSize - 1);
+            std::uint64_t code = mortonCode(x, y, z);
+            roundTrips = roundTrips && compactBitsBy3(code) == x && compactBitsBy3(code >> 1) == y && compactBitsBy3(code >> 2) == z;
+        }
+        CHECK(roundTrips);
+        CHECK(mortonCode(1, 0, 0) == 1 && mortonCode(0, 1, 0) == 2 && mortonCode(0, 0, 1) == 4 && mortonCode(2, 0, 0) == 8);
+        CHECK(mortonCode(curveGridSize - 1, curveGridSize - 1, curveGridSize - 1) == (1ull << 63) - 1);
+    }
+
+    //The curve's first 8^k cells fill the cube of side 2^k at the origin, so visiting that cube's cells by code walks the
+    //curve: every step must move to a face neighbour
+    void testHilbertAdjacency()
+    {
+        for (std::uint32_t side : { 2u, 4u, 16u, 32u })
+        {
+            std::vector<std::array<std::uint32_t, 3>> cellsByCode(side * side * side);
+            bool permutation = true;
+            for (std::uint32_t z = 0; z < side; ++z)
+            {
+                for (std::uint32_t y = 0; y < side; ++y)
+                {
+                    for (std::uint32_t x = 0; x < side; ++x)
+                    {
+                        std::uint64_t code = hilbertCode(x, y, z);
+                        permutation = permutation && code < cellsByCode.size();
+                        if (code < cellsByCode.size())
+                            cellsByCode[code] = { x + 1, y, z }; //x + 1 so an unfilled slot stays recognisable
+                    }
+                }
+            }
+            bool adjacent = true;
+            for (std::size_t i = 0; i < cellsByCode.size(); ++i)
+            {
+                permutation = permutation && cellsByCode[i][0] != 0;
+                if (i == 0 || !permutation)
+                    continue;
+                int steps = 0;
+                for (int axis = 0; axis < 3; ++axis)
+                    steps += std::abs(static_cast<int>(cellsByCode[i][axis]) - static_cast<int>(cellsByCode[i - 1][axis]));
+                adjacent = adjacent && steps == 1;
+            }
+            CHECK(permutation && adjacent);
+        }
+    }
+
+    //Distinct cells get distinct codes over the whole grid
+    void testHilbertInjective()
+    {
+        std::mt19937 random(16);
+        std::vector<std::uint64_t> mortonCodes, hilbertCodes;
+        for (int i = 0; i < 100000; ++i)
+            mortonCodes.push_back(mortonCode(random() & (curveGridSize - 1), random() & (curveGridSize - 1), random() & (curveGridSize - 1)));
+        std::sort(mortonCodes.begin(), mortonCodes.end());
+        mortonCodes.erase(std::unique(mortonCodes.begin(), mortonCodes.end()), mortonCodes.end());
+        for (std::uint64_t code : mortonCodes)
+            hilbertCodes.push_back(hilbertCode(compactBitsBy3(code), compactBitsBy3(code >> 1), compactBitsBy3(code >> 2)));
+        std::sort(hilbertCodes.begin(), hilbertCodes.end());
+        CHECK(std::adjacent_find(hilbertCodes.begin(), hilbertCodes.end()) == hilbertCodes.end());
+        CHECK(hilbertCodes.back() < (1ull << 63));
+    }
+
+    void testReorderAlongCurve()
+    {
+        std::mt19937 random(17);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<PointCloudVertex> vertices(50000);
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            vertices[i].modelPos = DirectX::XMFLOAT3(unit(random) * 10.0f, unit(random) * 10.0f, unit(random) * 10.0f);
+            vertices[i].colour = DirectX::XMFLOAT3(static_cast<float>(i), 0.0f, 0.0f);
+        }
+        PointCloud pointCloud(std::move(vertices));
+        for (std::size_t i = 0; i < pointCloud.size(); ++i)
+            pointCloud.normals.push_back(static_cast<std::uint32_t>(i));
+        pointCloud.origin = { 1.0, 2.0, 3.0 };
+
+        for (CurveType curve : { CurveType::Morton, CurveType::Hilbert })
+        {
+            std::unique_ptr<PointCloud> reordered = reorderAlongCurve(pointCloud, curve);
+            CHECK(reordered->size() == pointCloud.size() && reordered->origin == pointCloud.origin && reordered->bounds);
+
+            //Every normal stays with its vertex, and the codes come out in order
+            BoundingBox cube = boundingCube(reordered->bounds->box);
+            std::vector<std::uint64_t> codes(reordered->size());
+            computeCurveCodes(reordered->data(), reordered->size(), cube, curve, codes.data());
+            CHECK(std::is_sorted(codes.begin(), codes.end()));
+            bool normalsFollow = true;
+            std::vector<bool> seen(reordered->size());
+            for (std::size_t i = 0; i < reordered->size(); ++i)
+            {
+                std::size_t source = static_cast<std::size_t>(reordered->data()[i].colour.x);
+                normalsFollow = normalsFollow && reordered->normals[i] == source && !seen[source];
+                seen[source] = true;
+            }
+            CHECK(normalsFollow);
+        }
+    }
+
+    //Reordering twice composes the permutations, so the file order still comes back exactly
+    void testRestoreSourceOrder()
+    {
+        std::mt19937 random(170);
+        std::uniform_real_distribution<float> unit(-5.0f, 5.0f);
+        std::vector<PointCloudVertex> vertices(70000);
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            vertices[i].modelPos = DirectX::XMFLOAT3(unit(random), unit(random), unit(random));
+            vertices[i].colour = DirectX::XMFLOAT3(static_cast<float>(i), 0.0f, 0.0f);
+        }
+        PointCloud pointCloud{ std::vector<PointCloudVertex>(vertices) };
+        CHECK(pointCloud.sourceOrder.empty());
+        std::vector<PointCloudVertex> unchanged = restoreSourceOrder(pointCloud);
+        CHECK(std::memcmp(unchanged.data(), vertices.data(), vertices.size() * sizeof(PointCloudVertex)) == 0);
+
+        std::unique_ptr<PointCloud> morton = reorderAlongCurve(pointCloud, CurveType::Morton);
+        std::unique_ptr<PointCloud> hilbert = reorderAlongCurve(*morton, CurveType::Hilbert);
+        CHECK(morton->sourceOrder.size() == vertices.size() && hilbert->sourceOrder.size() == vertices.size());
+        bool indexesSource = true;
+        for (std::size_t i = 0; i < hilbert->size(); ++i)
+            indexesSource = indexesSource && hilbert->sourceOrder[i] == static_cast<std::uint64_t>(hilbert->data()[i].colour.x);
+        CHECK(indexesSource);
+        std::vector<PointCloudVertex> restored = restoreSourceOrder(*hilbert);
+        CHECK(restored.size() == vertices.size()
+            && std::memcmp(restored.data(), vertices.data(), vertices.size() * sizeof(PointCloudVertex)) == 0);
+    }
+}
+
+int main()
+{
+    testMortonCode();
+    testHilbertAdjacency();
+    testHilbertInjective();
+    testReorderAlongCurve();
+    testRestoreSourceOrder();
+    return testResult();
+}
@@ -0,0 +1,53 @@
+#include "Check.h"
+#include "ThreadPool.h"
+//C++
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void testEveryIndexOnce()
+    {
+        for (unsigned int nThreads : { 1u, 2u, 3u, 8u })
+        {
+            ThreadPool pool(nThreads);
+            CHECK(pool.size() == nThreads);
+            //Repeated jobs on the same pool, including empty ones and ones smaller than the pool
+            for (std::size_t count : { 0, 1, 5, 1000, 100000 })
+            {
+                std::vector<std::atomic<int>> visits(count);
+                pool.parallelFor(count, [&](std::size_t i) { visits[i].fetch_add(1, std::memory_order_relaxed); });
+                bool once = true;
+                for (const auto& visit : visits)
+                    once = once && visit.load() == 1;
+                CHECK(once);
+            }
+        }
+    }
+
+    //While the participant holding index 0 is stuck, the rest of its share must be stolen by the others
+    void testStealing()
+    {
+        constexpr std::size_t count = 4000;
+        ThreadPool pool(4);
+        std::vector<std::thread::id> runners(count);
+        pool.parallelFor(count, [&](std::size_t i) {
+            if (i == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            runners[i] = std::this_thread::get_id();
+        });
+        std::size_t nStolen = 0;
+        for (std::size_t i = 1; i < count / pool.size(); ++i)
+            nStolen += runners[i] != runners[0];
+        CHECK(nStolen > 0);
+    }
+}
+
+int main()
+{
+    testEveryIndexOnce();
+    testStealing();
+    return testResult();
+}
@@ -0,0 +1,153 @@
+#include "Check.h"
+#include "VertexSegments.h"
+#include "QuantizedVertex.h"
+#include "MappedFile.h"
+#include "PointCloudLoader.h"
+//C++
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    //Counts past 2^32 vertices must be partitioned and addressed without wrapping
+    void testPartitionBeyond32Bits()
+    {
+        constexpr std::uint64_t nVertices = 5000000000ull;
+        std::vector<VertexSegment> segments = partitionIntoSegments(nVertices, sizeof(QuantizedVertex));
+        std::uint64_t next = 0;
+        bool contiguous = true, withinBudget = true;
+        for (const VertexSegment& segment : segments)
+        {
+            contiguous = contiguous && segment.firstVertex == next && segment.nVertices != 0;
+            withinBudget = withinBudget && segment.nVertices * sizeof(QuantizedVertex) <= defaultSegmentBytes;
+            next = segment.firstVertex + segment.nVertices;
+        }
+        CHECK(contiguous && withinBudget && next == nVertices);
+        CHECK(segments.back().firstVertex > 0xFFFFFFFFull);
+
+        CHECK(partitionIntoSegments(0, sizeof(QuantizedVertex)).empty());
+        //A stride larger than the segment still gets one vertex per segment
+        CHECK(partitionIntoSegments(3, 64, 16).size() == 3);
+    }
+
+    void testSortAndMerge()
+    {
+        std::vector<DrawRange> ranges = { { 30, 10 }, { 0, 10 }, { 10, 20 }, { 50, 5, true }, { 55, 5, true }, { 60, 5 } };
+        sortAndMergeRanges(ranges);
+        CHECK(ranges.size() == 3);
+        CHECK(ranges[0].firstVertex == 0 && ranges[0].nVertices == 40 && !ranges[0].coarse);
+        CHECK(ranges[1].firstVertex == 50 && ranges[1].nVertices == 10 && ranges[1].coarse);
+        //Touching but drawn with the other colours, so kept apart
+        CHECK(ranges[2].firstVertex == 60 && !ranges[2].coarse);
+    }
+
+    void testSplitAtSegments()
+    {
+        constexpr std::uint64_t nVertices = 5000000000ull;
+        std::vector<VertexSegment> segments = partitionIntoSegments(nVertices, sizeof(QuantizedVertex));
+        std::uint64_t perSegment = segments.front().nVertices;
+        //One range inside a segment past 2^32, one spanning three segments and one ending the cloud
+        std::uint64_t lateFirst = segments[20].firstVertex + 7;
+        std::uint64_t spanFirst = segments[2].firstVertex + perSegment / 2;
+        std::vector<DrawRange> ranges = { { spanFirst, 2 * perSegment }, { lateFirst, 100, true }, { nVertices - 3, 3 } };
+
+        struct Piece
+        {
+            std::size_t segment;
+            std::uint32_t first;
+            std::uint32_t nVertices;
+            bool coarse;
+        };
+        std::vector<Piece> pieces;
+        splitRangesAtSegments(segments, ranges, [&](std::size_t segment, std::uint32_t first, std::uint32_t n, bool coarse) {
+            pieces.push_back({ segment, first, n, coarse });
+        });
+        CHECK(pieces.size() == 5);
+        if (pieces.size() == 5)
+        {
+            CHECK(pieces[0].segment == 2 && pieces[0].first == perSegment / 2 && pieces[0].nVertices == perSegment - perSegment / 2);
+            CHECK(pieces[1].segment == 3 && pieces[1].first == 0 && pieces[1].nVertices == perSegment);
+            CHECK(pieces[2].segment == 4 && pieces[2].first == 0 && pieces[2].nVertices == perSegment / 2);
+            CHECK(pieces[3].segment == 20 && pieces[3].first == 7 && pieces[3].nVertices == 100 && pieces[3].coarse);
+            CHECK(pieces[4].segment == segments.size() - 1 && pieces[4].first + pieces[4].nVertices == segments.back().nVertices);
+        }
+    }
+
+    //A sparse text file past 4 GiB: a few records, one straddling byte 2^32, between lines of zero bytes. Mapping,
+    //splitting and parsing must address every byte of it without wrapping.
+    void testFileBeyond32Bits()
+    {
+        constexpr std::uint64_t boundary = 1ull << 32;
+        constexpr std::uint64_t fileSize = boundary + (256ull << 20);
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "pcv_sparse_beyond_4gib.xyz";
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        std::ofstream(path, std::ios::binary) << "0 0 0\n";
+        std::filesystem::resize_file(path, fileSize, error);
+        CHECK(!error);
+        if (error)
+            return;
+        {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            auto write = [&](std::uint64_t offset, const std::string& text) {
+                file.seekp(static_cast<std::streamoff>(offset));
+                file.write(text.data(), static_cast<std::streamsize>(text.size()));
+            };
+            //Lines every block, so no block has to search far for its end
+            for (std::uint64_t offset = asciiBlockSize - 1; offset < fileSize; offset += asciiBlockSize)
+                write(offset, "\n");
+            write(boundary - 3, "\n1 2 3\n");
+            write(boundary + 100, "\n4.5 -6.25 7\n-1 -2 -3\n");
+            write(fileSize - 7, "\n8 9 10");
+        }
+
+        MappedFile mapped;
+        CHECK(mapped.open(path) && mapped.size() == fileSize);
+        if (mapped.size() == fileSize)
+        {
+            CHECK(mapped.data()[boundary] == '2' && mapped.data()[fileSize - 1] == '0');
+
+            //Blocks cover the file in order, each ending on a line, and some start past 2^32
+            std::vector<std::string_view> blocks = splitAtLineBoundaries(mapped.view(), fileSize / asciiBlockSize);
+            bool contiguous = !blocks.empty() && blocks.front().data() == mapped.data();
+            std::size_t nPast32Bits = 0;
+            for (std::size_t i = 0; contiguous && i < blocks.size(); ++i)
+            {
+                contiguous = (i == 0 || blocks[i].data() == blocks[i - 1].data() + blocks[i - 1].size())
+                    && (i + 1 == blocks.size() || blocks[i].back() == '\n');
+                nPast32Bits += static_cast<std::uint64_t>(blocks[i].data() - mapped.data()) > boundary;
+            }
+            CHECK(contiguous && blocks.back().data() + blocks.back().size() == mapped.data() + fileSize);
+            CHECK(nPast32Bits > 0);
+        }
+        mapped.close();
+
+        //The lines of zeros are skipped and the records land in file order
+        std::unique_ptr<PointCloud> pointCloud = readPointCloudASC(path);
+        CHECK(pointCloud && pointCloud->size() == 5);
+        if (pointCloud && pointCloud->size() == 5)
+        {
+            const float expected[5][3] = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 2.0f, 3.0f }, { 4.5f, -6.25f, 7.0f }, { -1.0f, -2.0f, -3.0f },
+                { 8.0f, 9.0f, 10.0f } };
+            bool inOrder = true;
+            for (std::size_t i = 0; i < 5; ++i)
+            {
+                const DirectX::XMFLOAT3& position = pointCloud->data()[i].modelPos;
+                inOrder = inOrder && position.x == expected[i][0] && position.y == expected[i][1] && position.z == expected[i][2];
+            }
+            CHECK(inOrder);
+        }
+        std::filesystem::remove(path, error);
+    }
+}
+
+int main()
+{
+    testPartitionBeyond32Bits();
+    testSortAndMerge();
+    testSplitAtSegments();
+    testFileBeyond32Bits();
+    return testResult();
+}
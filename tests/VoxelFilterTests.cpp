@@ -0,0 +1,133 @@
+#include "Check.h"
+#include "OctahedralNormal.h"
+#include "SpaceFillingCurve.h"
+#include "VoxelFilter.h"
+//C++
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    double distance(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        double dx = static_cast<double>(a.x) - b.x, dy = static_cast<double>(a.y) - b.y, dz = static_cast<double>(a.z) - b.z;
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    bool encloses(const BoundingSphere& sphere, const PointCloud& pointCloud)
+    {
+        for (std::size_t i = 0; i < pointCloud.size(); ++i)
+        {
+            if (distance(pointCloud.data()[i].modelPos, sphere.centre) > sphere.radius)
+                return false;
+        }
+        return true;
+    }
+
+    //Clustered points, with enough of them to split the reduction over several tasks
+    PointCloud testCloud()
+    {
+        std::mt19937 random(22);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<PointCloudVertex> vertices(300000);
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            float scale = i % 5 ? 1.0f : 30.0f;
+            vertices[i].modelPos = XMFLOAT3(unit(random) * scale + 5.0f, unit(random) * scale - 3.0f, unit(random) * scale * 0.3f);
+            vertices[i].colour = XMFLOAT3(unit(random), unit(random), unit(random));
+        }
+        PointCloud pointCloud(std::move(vertices));
+        pointCloud.origin = { 1000.0, 2000.0, 3000.0 };
+        for (std::size_t i = 0; i < pointCloud.size(); ++i)
+            pointCloud.normals.push_back(encodeOctahedral(XMFLOAT3(0.0f, 0.0f, 1.0f)));
+        return pointCloud;
+    }
+
+    //Morton codes of the occupied voxels, with the filter's own arithmetic so no point lands in a different voxel
+    std::set<std::uint64_t> occupiedVoxels(const PointCloud& pointCloud, float voxelSize)
+    {
+        BoundingBox box = calculateBounds(pointCloud.data(), pointCloud.size()).box;
+        float inverseSize = 1.0f / voxelSize;
+        auto cell = [&](float coordinate, float minimum) {
+            return static_cast<std::uint32_t>(std::min((coordinate - minimum) * inverseSize, static_cast<float>(curveGridSize - 1)));
+        };
+        std::set<std::uint64_t> voxels;
+        for (std::size_t i = 0; i < pointCloud.size(); ++i)
+        {
+            const XMFLOAT3& position = pointCloud.data()[i].modelPos;
+            voxels.insert(mortonCode(cell(position.x, box.min.x), cell(position.y, box.min.y), cell(position.z, box.min.z)));
+        }
+        return voxels;
+    }
+
+    void testVoxelDownsample()
+    {
+        PointCloud pointCloud = testCloud();
+        for (float voxelSize : { 0.05f, 0.5f, 4.0f })
+        {
+            std::size_t nVoxels = occupiedVoxels(pointCloud, voxelSize).size();
+            for (VoxelRepresentative representative : { VoxelRepresentative::Centroid, VoxelRepresentative::NearestToCentroid })
+            {
+                std::unique_ptr<PointCloud> downsampled = voxelDownsample(pointCloud, voxelSize, representative);
+                CHECK(downsampled && downsampled->size() == nVoxels);
+                if (!downsampled)
+                    continue;
+                CHECK(downsampled->normals.size() == downsampled->size() && downsampled->origin == pointCloud.origin);
+                CHECK(downsampled->bounds && encloses(downsampled->bounds->sphere, *downsampled));
+
+                bool unitNormals = true, meanColours = true;
+                for (std::size_t i = 0; i < downsampled->size(); ++i)
+                {
+                    XMFLOAT3 normal = decodeOctahedral(downsampled->normals[i]);
+                    unitNormals = unitNormals && std::fabs(normal.z - 1.0f) < 1e-4f;
+                    const XMFLOAT3& colour = downsampled->data()[i].colour;
+                    meanColours = meanColours && colour.x >= 0.0f && colour.x <= 1.0f && colour.y >= 0.0f && colour.y <= 1.0f;
+                }
+                CHECK(unitNormals && meanColours);
+            }
+        }
+
+        //The nearest to centroid representatives are input points
+        std::unique_ptr<PointCloud> nearest = voxelDownsample(pointCloud, 0.5f, VoxelRepresentative::NearestToCentroid);
+        std::set<std::tuple<float, float, float>> inputPositions;
+        for (std::size_t i = 0; i < pointCloud.size(); ++i)
+        {
+            const XMFLOAT3& position = pointCloud.data()[i].modelPos;
+            inputPositions.insert({ position.x, position.y, position.z });
+        }
+        bool fromInput = true;
+        for (std::size_t i = 0; i < nearest->size(); ++i)
+        {
+            const XMFLOAT3& position = nearest->data()[i].modelPos;
+            fromInput = fromInput && inputPositions.count({ position.x, position.y, position.z }) == 1;
+        }
+        CHECK(fromInput);
+
+        //One voxel per point when the voxels are much smaller than the spacing
+        std::vector<PointCloudVertex> grid;
+        for (int i = 0; i < 1000; ++i)
+        {
+            XMFLOAT3 position(static_cast<float>(i % 10), static_cast<float>(i / 10 % 10), static_cast<float>(i / 100));
+            grid.emplace_back(position, XMFLOAT3(0.0f, 0.0f, 0.0f));
+        }
+        std::unique_ptr<PointCloud> unchanged = voxelDownsample(PointCloud(std::move(grid)), 0.25f);
+        CHECK(unchanged && unchanged->size() == 1000);
+
+        CHECK(!voxelDownsample(pointCloud, 0.0f));
+        CHECK(!voxelDownsample(pointCloud, -1.0f));
+        //More than 2^21 voxels along x
+        CHECK(!voxelDownsample(pointCloud, 1e-5f));
+    }
+}
+
+int main()
+{
+    testVoxelDownsample();
+    return testResult();
+}
@@ -0,0 +1,218 @@
+#pragma once
+//Scalar stand-in for the parts of DirectXMath the portable modules and their tests use, so they build with compilers
+//that don't ship the Windows SDK. Same conventions as the real library: row vectors, v * M, left handed.
+//C++
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#define XM_CALLCONV
+
+namespace DirectX
+{
+	struct XMFLOAT3
+	{
+		float x, y, z;
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		float m[4][4];
+	};
+
+	struct XMVECTOR
+	{
+		float v[4];
+	};
+	using FXMVECTOR = XMVECTOR;
+	using GXMVECTOR = XMVECTOR;
+	using CXMVECTOR = const XMVECTOR&;
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+	};
+	using FXMMATRIX = const XMMATRIX&;
+	using CXMMATRIX = const XMMATRIX&;
+
+	inline float XMConvertToRadians(float degrees) { return degrees * (3.141592654f / 180.0f); }
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+	inline XMVECTOR XMVectorZero() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	inline XMVECTOR XMVectorReplicate(float value) { return { { value, value, value, value } }; }
+	inline float XMVectorGetX(FXMVECTOR v) { return v.v[0]; }
+	inline float XMVectorGetY(FXMVECTOR v) { return v.v[1]; }
+	inline float XMVectorGetZ(FXMVECTOR v) { return v.v[2]; }
+	inline float XMVectorGetW(FXMVECTOR v) { return v.v[3]; }
+
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return { { source->x, source->y, source->z, 0.0f } }; }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return { { source->x, source->y, source->z, source->w } }; }
+	inline void XMStoreFloat(float* destination, FXMVECTOR v) { *destination = v.v[0]; }
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v) { *destination = XMFLOAT3(v.v[0], v.v[1], v.v[2]); }
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v) { *destination = XMFLOAT4(v.v[0], v.v[1], v.v[2], v.v[3]); }
+
+	template<typename Operation>
+	XMVECTOR perComponent(FXMVECTOR a, FXMVECTOR b, Operation operation)
+	{
+		XMVECTOR result;
+		for (int i = 0; i < 4; ++i)
+			result.v[i] = operation(a.v[i], b.v[i]);
+		return result;
+	}
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) { return perComponent(a, b, [](float x, float y) { return x + y; }); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return perComponent(a, b, [](float x, float y) { return x - y; }); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return perComponent(a, b, [](float x, float y) { return x * y; }); }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b) { return perComponent(a, b, [](float x, float y) { return x / y; }); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) { return perComponent(a, b, [](float x, float y) { return std::min(x, y); }); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) { return perComponent(a, b, [](float x, float y) { return std::max(x, y); }); }
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale) { return XMVectorMultiply(v, XMVectorReplicate(scale)); }
+	inline XMVECTOR XMVectorNegate(FXMVECTOR v) { return XMVectorScale(v, -1.0f); }
+	inline XMVECTOR XMVectorAbs(FXMVECTOR v) { return perComponent(v, v, [](float x, float) { return std::fabs(x); }); }
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2]); }
+	inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3]); }
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) { return XMVector3Dot(v, v); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return XMVectorReplicate(std::sqrt(XMVector3Dot(v, v).v[0])); }
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		float length = XMVector3Length(v).v[0];
+		return length > 0.0f ? XMVectorScale(v, 1.0f / length) : v;
+	}
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.v[1] * b.v[2] - a.v[2] * b.v[1], a.v[2] * b.v[0] - a.v[0] * b.v[2], a.v[0] * b.v[1] - a.v[1] * b.v[0], 0.0f);
+	}
+
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = XMVectorZero();
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int row = 0; row < 4; ++row)
+				result.v[column] += v.v[row] * m.r[row].v[column];
+		}
+		return result;
+	}
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR transformed = XMVector4Transform(XMVectorSet(v.v[0], v.v[1], v.v[2], 1.0f), m);
+		return XMVectorScale(transformed, 1.0f / transformed.v[3]);
+	}
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		XMMATRIX m = {};
+		for (int i = 0; i < 4; ++i)
+			m.r[i].v[i] = 1.0f;
+		return m;
+	}
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m)
+	{
+		XMMATRIX transposed;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+				transposed.r[row].v[column] = m.r[column].v[row];
+		}
+		return transposed;
+	}
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b)
+	{
+		XMMATRIX product;
+		for (int row = 0; row < 4; ++row)
+			product.r[row] = XMVector4Transform(a.r[row], b);
+		return product;
+	}
+	//Gauss-Jordan elimination with partial pivoting, in double precision. determinant isn't computed.
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, FXMMATRIX m)
+	{
+		double augmented[4][8];
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				augmented[row][column] = m.r[row].v[column];
+				augmented[row][column + 4] = row == column ? 1.0 : 0.0;
+			}
+		}
+		for (int column = 0; column < 4; ++column)
+		{
+			int pivot = column;
+			for (int row = column + 1; row < 4; ++row)
+			{
+				if (std::fabs(augmented[row][column]) > std::fabs(augmented[pivot][column]))
+					pivot = row;
+			}
+			std::swap(augmented[column], augmented[pivot]);
+			double scale = 1.0 / augmented[column][column];
+			for (double& value : augmented[column])
+				value *= scale;
+			for (int row = 0; row < 4; ++row)
+			{
+				double factor = augmented[row][column];
+				if (row == column || factor == 0.0)
+					continue;
+				for (int i = 0; i < 8; ++i)
+					augmented[row][i] -= factor * augmented[column][i];
+			}
+		}
+		XMMATRIX inverse;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+				inverse.r[row].v[column] = static_cast<float>(augmented[row][column + 4]);
+		}
+		if (determinant)
+			*determinant = XMVectorZero();
+		return inverse;
+	}
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR eye, FXMVECTOR focus, FXMVECTOR up)
+	{
+		XMVECTOR zAxis = XMVector3Normalize(XMVectorSubtract(focus, eye));
+		XMVECTOR xAxis = XMVector3Normalize(XMVector3Cross(up, zAxis));
+		XMVECTOR yAxis = XMVector3Cross(zAxis, xAxis);
+		XMMATRIX m;
+		for (int i = 0; i < 3; ++i)
+			m.r[i] = XMVectorSet(xAxis.v[i], yAxis.v[i], zAxis.v[i], 0.0f);
+		m.r[3] = XMVectorSet(-XMVector3Dot(xAxis, eye).v[0], -XMVector3Dot(yAxis, eye).v[0], -XMVector3Dot(zAxis, eye).v[0], 1.0f);
+		return m;
+	}
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+	{
+		float height = 1.0f / std::tan(0.5f * fovAngleY);
+		float range = farZ / (farZ - nearZ);
+		XMMATRIX m = {};
+		m.r[0].v[0] = height / aspectRatio;
+		m.r[1].v[1] = height;
+		m.r[2].v[2] = range;
+		m.r[2].v[3] = 1.0f;
+		m.r[3].v[2] = -range * nearZ;
+		return m;
+	}
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source)
+	{
+		XMMATRIX m;
+		for (int row = 0; row < 4; ++row)
+			m.r[row] = XMVectorSet(source->m[row][0], source->m[row][1], source->m[row][2], source->m[row][3]);
+		return m;
+	}
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, FXMMATRIX m)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+				destination->m[row][column] = m.r[row].v[column];
+		}
+	}
+}